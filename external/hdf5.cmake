@@ -1,11 +1,12 @@
 
 #Find HDF5 support
 if (ENABLE_HDF5)
-  set(HDF5_PREFER_PARALLEL FALSE)
+  # parallel HDF5 lets all processes write H5POutputArchive collectively
+  set(HDF5_PREFER_PARALLEL TRUE)
   find_package(HDF5 COMPONENTS C)
 
   if (HDF5_FOUND)
-    message(STATUS "Found HDF5: ${HDF5_LIBRARIES}")
+    message(STATUS "Found HDF5: ${HDF5_LIBRARIES} (parallel: ${HDF5_IS_PARALLEL})")
     set(HAVE_HDF5 ON CACHE INTERNAL "Have HDF5" FORCE)
   endif ()
 #  if (HDF5_IS_PARALLEL)
@@ -402,13 +402,10 @@ struct BinaryOpStructure {
         const Tensor<double>& qp =cdata.quad_x;
         fcube(key,(*f),qp,intpol);
 
-        // exchange correlation potential weighted by correction factor
-        Tensor<double> tmp1 = madness::copy(vxc).emul(intpol);
-        // hartree potential pot weighted by correction factor
-        Tensor<double> tmp2 = madness::copy(vhartree).emul(intpol);
-        Tensor<double> tmp3 = madness::copy(vhartree);
-        // corrected potential
-        result = tmp1 - tmp2 + tmp3;
+        // corrected potential: exchange correlation potential weighted by
+        // correction factor, minus hartree potential weighted by correction
+        // factor, plus hartree potential
+        result = evaluate(lazy(vxc)*lazy(intpol) - lazy(vhartree)*lazy(intpol) + lazy(vhartree));
     }
 
     /// shared pointer to object of int_factor_functor
@@ -9,7 +9,7 @@
 #define PAPER_CODE_PNOTENSORS_H_
 
 #include <stdio.h>
-#include <valarray>
+#include <unordered_map>
 #include <madness.h>
 
 
@@ -30,12 +30,11 @@ namespace PNOTensors {
   /// stores pairs of pairs that share first index (i.e. {ij} and {ik}, where i >= j) as a 3-index tensor:
   /// case 1 -- i >= j, i >= k: only need j >= k, or ij >= ik; store as {{ij},k}
   /// case 2 -- i >= j, k > i: can also be found at Tensor_IJ_JK(k,i,j)
+  /// only the blocks that were set are stored, for localized orbitals most {ij},k are never needed
   template <typename T>
     class Tensor_IJ_IK {
   public:
-  Tensor_IJ_IK(size_t n) : n_(n), data_(ntri(n) * n) {
-      reset();
-    }
+  Tensor_IJ_IK(size_t n) : n_(n) {}
     ~Tensor_IJ_IK() = default;
     
     std::tuple<size_t,bool> ijk(size_t i, size_t j, size_t k) const {
@@ -68,7 +67,7 @@ namespace PNOTensors {
       assert(i >= j);
       size_t ijk;
       std::tie(ijk,std::ignore) = this->ijk(i,j,k);
-      return data_[ijk].size() != 0;
+      return data_.count(ijk) != 0;
     }
     madness::Tensor<T> get(size_t i, size_t j, size_t k) const {
       assert(i < size_t(n_));
@@ -77,7 +76,9 @@ namespace PNOTensors {
       assert(i >= j);
       size_t ijk; bool swap;
       std::tie(ijk, swap) = this->ijk(i,j,k);
-      return swap ? data_[ijk].swapdim(0,1) : data_[ijk];
+      auto it = data_.find(ijk);
+      if (it == data_.end()) return madness::Tensor<T>();
+      return swap ? it->second.swapdim(0,1) : it->second;
     }
     void set(size_t i, size_t j, size_t k, const madness::Tensor<T>& t) {
       assert(i < size_t(n_));
@@ -86,27 +87,32 @@ namespace PNOTensors {
       assert(i >= j);
       size_t ijk; bool swap;
       std::tie(ijk, swap) = this->ijk(i,j,k);
-      data_[ijk] = swap ? t.swapdim(0,1) : t;
+      if (t.size() == 0) data_.erase(ijk);
+      else data_[ijk] = swap ? t.swapdim(0,1) : t;
     }
     
     void reset() {
-      std::fill(std::begin(data_), std::end(data_), madness::Tensor<T>());
+      data_.clear();
+    }
+
+    /// number of stored blocks
+    size_t nstored() const {
+      return data_.size();
     }
     
   private:
     int n_;
-    std::valarray<madness::Tensor<T>> data_;
+    std::unordered_map<size_t,madness::Tensor<T>> data_;
   };
   
   /// stores pairs of pairs that share second index (i.e. {ij} and {kj}, where i >= j) as a 3-index tensor:
   /// case 1 -- i >= j, j >= k: store as {{ij},k}
   /// case 2 -- i >= j, k > j: only need i >= k, or ij >= kj; store as {{ij},k}
+  /// only the blocks that were set are stored
   template <typename T>
     class Tensor_IJ_KJ {
   public:
-  Tensor_IJ_KJ(size_t n) : n_(n), data_(ntri(n) * n) {
-      reset();
-    }
+  Tensor_IJ_KJ(size_t n) : n_(n) {}
     ~Tensor_IJ_KJ() = default;
     
     std::tuple<size_t,bool> ijk(size_t i, size_t j, size_t k) const {
@@ -137,7 +143,7 @@ namespace PNOTensors {
       
       size_t ijk;
       std::tie(ijk, std::ignore) = this->ijk(i, j, k);
-      return data_[ijk].size() != 0;
+      return data_.count(ijk) != 0;
     }
     madness::Tensor<T> get(size_t i, size_t j, size_t k) const {
       assert(i < size_t(n_));
@@ -147,7 +153,9 @@ namespace PNOTensors {
       size_t ijk;
       bool swap;
       std::tie(ijk, swap) = this->ijk(i,j,k);
-      return swap ? data_[ijk].swapdim(0,1) : data_[ijk];
+      auto it = data_.find(ijk);
+      if (it == data_.end()) return madness::Tensor<T>();
+      return swap ? it->second.swapdim(0,1) : it->second;
     }
     void set(size_t i, size_t j, size_t k, const madness::Tensor<T>& t) {
       assert(i < size_t(n_));
@@ -157,16 +165,22 @@ namespace PNOTensors {
       size_t ijk;
       bool swap;
       std::tie(ijk, swap) = this->ijk(i,j,k);
-      data_[ijk] = swap ? t.swapdim(0,1) : t;
+      if (t.size() == 0) data_.erase(ijk);
+      else data_[ijk] = swap ? t.swapdim(0,1) : t;
     }
     
     void reset() {
-      std::fill(std::begin(data_), std::end(data_), madness::Tensor<T>());
+      data_.clear();
+    }
+
+    /// number of stored blocks
+    size_t nstored() const {
+      return data_.size();
     }
     
   private:
     int n_;
-    std::valarray<madness::Tensor<T>> data_;
+    std::unordered_map<size_t,madness::Tensor<T>> data_;
   };
   
 }  // was anonymous namespace --- now PNOTensors
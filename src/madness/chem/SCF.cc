@@ -42,23 +42,6 @@
 #include<madness/chem/SCF.h>
 #include<chem.h>
 
-#if defined(__has_include)
-#  if __has_include(<filesystem>)
-#    define MADCHEM_HAS_STD_FILESYSTEM
-// <filesystem> is not reliably usable on Linux with gcc < 9
-#    if defined(__GNUC__)
-#      if __GNUC__ >= 7 && __GNUC__ < 9
-#        undef MADCHEM_HAS_STD_FILESYSTEM
-#      endif
-#    endif
-#    if defined(MADCHEM_HAS_STD_FILESYSTEM)
-
-#      include <filesystem>
-
-#    endif
-#  endif
-#endif
-
 using namespace madchem;
 namespace madness {
 
@@ -231,6 +214,18 @@ void SCF::save_mos(World& world) {
     PROFILE_MEMBER_FUNC(SCF);
     auto archivename=param.prefix()+".restartdata";
     archive::ParallelOutputArchive<archive::BinaryFstreamOutputArchive> ar(world, archivename.c_str(), param.get<int>("nio"));
+    store_mos(world, ar);
+}
+
+Future<bool> SCF::save_mos_async(World& world) {
+    PROFILE_MEMBER_FUNC(SCF);
+    AsyncCheckpoint checkpoint(world, param.prefix()+".restartdata", param.get<int>("nio"));
+    store_mos(world, checkpoint.archive());
+    return checkpoint.commit();
+}
+
+template <typename Archive>
+void SCF::store_mos(World& world, Archive& ar) {
     // IF YOU CHANGE ANYTHING HERE MAKE SURE TO UPDATE THIS VERSION NUMBER
     /*
      * After spin restricted
@@ -278,7 +273,7 @@ void SCF::load_mos(World& world) {
     amo.clear();
     bmo.clear();
 
-    archive::ParallelInputArchive<archive::BinaryFstreamInputArchive> ar(world, param.prefix()+".restartdata");
+    archive::ParallelInputArchive<archive::MmapInputArchive> ar(world, param.prefix()+".restartdata");
 
     /*
       File format:
@@ -2263,23 +2258,13 @@ void SCF::output_scf_info_schema(const int& iter, const std::map<std::string, do
     for (auto const& [key, val]: vals) {
         j[0][key] = val;
     }
-    j[0]["scf_dipole_moment"] = tensor_to_json(dipole_T);
-    int num = 0;
-    std::string save = param.prefix()+".scf_info.json";
-#ifdef MADCHEM_HAS_STD_FILESYSTEM
-    if (std::filesystem::exists(save)) {
-        std::ifstream ifs(save);
-#else
-        std::ifstream ifs(save);
-        if (ifs) {
-#endif
-        nlohmann::json j_old;
-        ifs >> j_old;
-        print(j_old);
+    j[0]["scf_dipole_moment"] = param.binary_schema() ? tensor_to_json_binary(dipole_T) : tensor_to_json(dipole_T);
+    const std::string save = param.prefix()+".scf_info";
+    nlohmann::json j_old = input_schema(save);
+    if (not j_old.is_null()) {
         j_old.push_back(j);
         j = j_old;
-    };
-    std::ofstream ofs(save);
-    ofs << j;
+    }
+    output_schema(save, j, param.binary_schema());
 }
 }
@@ -43,6 +43,7 @@
 //#define WORLD_INSTANTIATE_STATIC_TEMPLATES
 
 #include <memory>
+#include <optional>
 
 #include<madness/chem/molecular_functors.h>
 #include <madness/mra/mra.h>
@@ -305,6 +306,16 @@ public:
 
     void save_mos(World& world);
 
+    /// Same as save_mos(), but the restart data is written in the background
+
+    /// The orbitals are copied before returning, so the calculation may continue.
+    /// \return A future assigned once the restart file of this process is written
+    Future<bool> save_mos_async(World& world);
+
+    /// Write the restart data read by load_mos() to a parallel archive
+    template <typename Archive>
+    void store_mos(World& world, Archive& ar);
+
     void load_mos(World& world);
 
     bool restart_aos(World& world);
@@ -555,6 +566,9 @@ public:
 
         // The below is missing convergence test logic, etc.
 
+        // Restart data is written in the background while the next protocol starts
+        std::optional<Future<bool>> saved;
+
         // Make the nuclear potential, initial orbitals, etc.
         for (unsigned int proto = 0; proto < calc.param.protocol().size(); proto++) {
 
@@ -620,8 +634,10 @@ public:
                 calc.ao = calc.project_ao_basis(world, calc.aobasis);
                 calc.solve(world);
 
-                if (calc.param.save())
-                    calc.save_mos(world);
+                if (calc.param.save()) {
+                    if (saved) saved->get();
+                    saved.emplace(calc.save_mos_async(world));
+                }
 
                 nv_old = nv;
                 // exit loop over decreasing nvirt if nvirt=0
@@ -630,6 +646,7 @@ public:
             }
 
         }
+        if (saved) saved->get();
         return calc.current_energy;
     }
 
@@ -673,7 +690,7 @@ public:
         to_json(j, int_vals);
         double_vals.push_back({"return_energy", value(calc.molecule.get_all_coords().flat())});
         to_json(j, double_vals);
-        output_schema(param.prefix()+".calc_info", j);
+        output_schema(param.prefix()+".calc_info", j, param.binary_schema());
     }
 };
 }
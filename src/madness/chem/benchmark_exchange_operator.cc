@@ -144,6 +144,23 @@ int main(int argc, char** argv) {
             err = norm2(world, reference - tmp);
             if (world.rank() == 0)
                 printf("timings exchange operator no multiworld smallmem   %8.2fs, error %.2e\n", cpu1 - cpu0, err);
+
+            // sweep over the subworld sizes of the macrotask queue
+            K.set_algorithm(Exchange<double, 3>::multiworld_efficient);
+            K.set_printlevel(0);
+            for (long nsubworld = world.size(); nsubworld > 0; nsubworld /= 2) {
+                auto taskq = std::shared_ptr<MacroTaskQ>(new MacroTaskQ(world, nsubworld));
+                K.set_taskq(taskq);
+                cpu0 = cpu_time();
+                tmp = K(calc.amo);
+                taskq->run_all();
+                cpu1 = cpu_time();
+                err = norm2(world, reference - tmp);
+                if (world.rank() == 0)
+                    printf("timings exchange operator %4ld subworlds of size %4ld  %8.2fs, error %.2e\n",
+                           nsubworld, world.size() / nsubworld, cpu1 - cpu0, err);
+            }
+            K.set_taskq(0);
         }
         world.gop.fence();
         world.gop.fence();
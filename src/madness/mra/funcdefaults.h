@@ -193,6 +193,7 @@ namespace madness {
         static int special_level;      ///< Minimum level for fine scale projection of special boxes
         static int max_refine_level;   ///< Level at which to stop refinement
         static int truncate_mode;    ///< Truncation method
+        static double mixed_precision; ///< If positive, truncate() packs nodes with errors up to this fraction of the threshold
         static bool refine;            ///< Whether to refine new functions
         static bool autorefine;        ///< Whether to autorefine in multiplication, etc.
         static bool debug;             ///< Controls output of debug info
@@ -321,6 +322,20 @@ namespace madness {
         	MADNESS_ASSERT(value>=0 && value<4);
         }
 
+        /// Gets the fraction of the threshold up to which truncate() stores coefficients in single precision
+        static double get_mixed_precision() {
+        	return mixed_precision;
+        }
+
+        /// Sets the fraction of the threshold up to which truncate() stores coefficients in single precision
+
+        /// Zero, the default, keeps all coefficients in double precision, see Function::pack().
+        /// Existing functions are unaffected
+        static void set_mixed_precision(double fraction) {
+        	mixed_precision=fraction;
+        	MADNESS_ASSERT(fraction>=0.0 && fraction<=1.0);
+        }
+
         /// Gets the default adaptive refinement flag
         static bool get_refine() {
         	return refine;
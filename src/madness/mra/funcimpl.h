@@ -35,13 +35,17 @@
 /// \file funcimpl.h
 /// \brief Provides FunctionCommonData, FunctionImpl and FunctionFactory
 
+#include <atomic>
 #include <iostream>
+#include <memory>
 #include <type_traits>
 #include <madness/world/MADworld.h>
 #include <madness/world/print.h>
 #include <madness/misc/misc.h>
 #include <madness/tensor/tensor.h>
+#include <madness/tensor/tensor_expr.h>
 #include <madness/tensor/gentensor.h>
+#include <madness/tensor/quantized_tensor.h>
 
 #include <madness/mra/function_common_data.h>
 #include <madness/mra/indexit.h>
@@ -119,12 +123,20 @@ namespace madness {
     };
 
 
+    namespace detail {
+        /// The type of packed coefficients, see FunctionNode::pack(); T if they are never packed
+        template <typename T> struct packed_coeff_type {typedef T type;};
+        template <> struct packed_coeff_type<double> {typedef float type;};
+        template <> struct packed_coeff_type<double_complex> {typedef float_complex type;};
+    }
+
     /// FunctionNode holds the coefficients, etc., at each node of the 2^NDIM-tree
     template<typename T, std::size_t NDIM>
     class FunctionNode {
     public:
     	typedef GenTensor<T> coeffT;
     	typedef Tensor<T> tensorT;
+        typedef typename detail::packed_coeff_type<T>::type packedT;
     private:
         // Should compile OK with these volatile but there should
         // be no need to set as volatile since the container internally
@@ -133,10 +145,41 @@ namespace madness {
         coeffT _coeffs; ///< The coefficients, if any
         double _norm_tree; ///< After norm_tree will contain norm of coefficients summed up tree
         bool _has_children; ///< True if there are children
+        mutable std::atomic_flag _packed_lock = ATOMIC_FLAG_INIT; ///< Guards unpacking, fits next to _has_children
         coeffT buffer; ///< The coefficients, if any
         double dnorm=-1.0;	///< norm of the d coefficients
         double snorm=-1.0;	///< norm of the s coefficients
 
+        // Packed coefficients are converted back to T by the first access
+        // through coeff(), which may come from several threads reading a
+        // const node, hence the lock.  The packed tensor is allocated only
+        // when a node is packed, and its data may be shared by copies of
+        // the node.
+        mutable std::atomic< Tensor<packedT>* > _packed{nullptr}; ///< The coefficients in single precision, if packed
+
+        void lock_packed() const {
+            while (_packed_lock.test_and_set(std::memory_order_acquire)) ;
+        }
+
+        void unlock_packed() const {
+            _packed_lock.clear(std::memory_order_release);
+        }
+
+        /// @return a shallow copy of the packed coefficients, or an empty tensor if the node is not packed
+        Tensor<packedT> get_packed() const {
+            if (!is_packed()) return Tensor<packedT>();
+            lock_packed();
+            const Tensor<packedT>* p = _packed.load(std::memory_order_relaxed);
+            Tensor<packedT> result = p ? *p : Tensor<packedT>();
+            unlock_packed();
+            return result;
+        }
+
+        /// Discards the packed coefficients, if any, without converting them
+        void drop_packed() {
+            delete _packed.exchange(nullptr, std::memory_order_acq_rel);
+        }
+
     public:
         typedef WorldContainer<Key<NDIM> , FunctionNode<T, NDIM> > dcT; ///< Type of container holding the nodes
         /// Default constructor makes node without coeff or children
@@ -163,10 +206,22 @@ namespace madness {
             *this = other;
         }
 
+        ~FunctionNode() {
+            drop_packed();
+        }
+
         FunctionNode<T, NDIM>&
         operator=(const FunctionNode<T, NDIM>& other) {
             if (this != &other) {
-                coeff() = copy(other.coeff());
+                const Tensor<packedT> p = other.get_packed();
+                drop_packed();
+                if (p.has_data()) {
+                    _coeffs = coeffT();
+                    _packed.store(new Tensor<packedT>(p), std::memory_order_release);
+                }
+                else {
+                    _coeffs = copy(other.coeff());
+                }
                 _norm_tree = other._norm_tree;
                 _has_children = other._has_children;
                 dnorm=other.dnorm;
@@ -187,7 +242,51 @@ namespace madness {
         /// Returns true if there are coefficients in this node
         bool
         has_coeff() const {
-            return _coeffs.has_data();
+            return is_packed() || _coeffs.has_data();
+        }
+
+        /// Returns true if the coefficients are stored in single precision
+        bool is_packed() const {
+            return _packed.load(std::memory_order_acquire) != nullptr;
+        }
+
+        /// Stores the coefficients in single precision if that changes them by at most \c tol
+
+        /// Only full-rank coefficients of double or double_complex are packed,
+        /// low-rank (SVD) coefficients are left unchanged.
+        /// @return the norm of the change, zero if the node was not packed
+        double pack(const double tol) {
+            if (std::is_same<packedT,T>::value || is_packed() || !_coeffs.has_data() || !_coeffs.is_full_tensor())
+                return 0.0;
+            const tensorT c = _coeffs.get_tensor();
+            Tensor<packedT> p = madness::convert<packedT>(c);
+            const double err = (c - madness::convert<T>(p)).normf();
+            if (err > tol) return 0.0;
+            _coeffs = coeffT();
+            _packed.store(new Tensor<packedT>(p), std::memory_order_release);
+            return err;
+        }
+
+        /// Converts packed coefficients back to T, may be called concurrently on a const node
+        void unpack() const {
+            if (!is_packed()) return;
+            lock_packed();
+            Tensor<packedT>* p = _packed.load(std::memory_order_relaxed);
+            if (p) {
+                const_cast<FunctionNode&>(*this)._coeffs = coeffT(madness::convert<T>(*p));
+                _packed.store(nullptr, std::memory_order_release);
+                delete p;
+            }
+            unlock_packed();
+        }
+
+        /// Returns the coefficients in the precision of T, without unpacking the node
+
+        /// For a packed node this is a new tensor, else a shallow copy of coeff().
+        coeffT unpacked_coeff() const {
+            const Tensor<packedT> p = get_packed();
+            if (p.has_data()) return coeffT(madness::convert<T>(p));
+            return _coeffs;
         }
 
 
@@ -214,6 +313,7 @@ namespace madness {
         /// Returns an empty tensor if there are no coefficients.
         coeffT&
         coeff() {
+            unpack();
             MADNESS_ASSERT(_coeffs.ndim() == -1 || (_coeffs.dim(0) <= 2
                                                     * MAXK && _coeffs.dim(0) >= 0));
             return const_cast<coeffT&>(_coeffs);
@@ -224,19 +324,21 @@ namespace madness {
         /// Returns an empty tensor if there are no coefficeints.
         const coeffT&
         coeff() const {
+            unpack();
             return const_cast<const coeffT&>(_coeffs);
         }
 
         /// Returns the number of coefficients in this node
         size_t size() const {
-            return _coeffs.size();
+            const Tensor<packedT> p = get_packed();
+            return p.has_data() ? p.size() : _coeffs.size();
         }
 
     public:
 
         /// reduces the rank of the coefficients (if applicable)
         void reduceRank(const double& eps) {
-            _coeffs.reduce_rank(eps);
+            coeff().reduce_rank(eps);
         }
 
         /// Sets \c has_children attribute to value of \c flag.
@@ -272,7 +374,8 @@ namespace madness {
 
         /// Takes a \em shallow copy of the coeff --- same as \c this->coeff()=coeff
         void set_coeff(const coeffT& coeffs) {
-            coeff() = coeffs;
+            drop_packed();
+            _coeffs = coeffs;
             if ((_coeffs.has_data()) and ((_coeffs.dim(0) < 0) || (_coeffs.dim(0)>2*MAXK))) {
                 print("set_coeff: may have a problem");
                 print("set_coeff: coeff.dim[0] =", coeffs.dim(0), ", 2* MAXK =", 2*MAXK);
@@ -282,13 +385,14 @@ namespace madness {
 
         /// Clears the coefficients (has_coeff() will subsequently return false)
         void clear_coeff() {
-            coeff()=coeffT();
+            drop_packed();
+            _coeffs = coeffT();
         }
 
         /// Scale the coefficients of this node
         template <typename Q>
         void scale(Q a) {
-            _coeffs.scale(a);
+            coeff().scale(a);
         }
 
         /// Sets the value of norm_tree
@@ -442,12 +546,20 @@ namespace madness {
         }
 
         T trace_conj(const FunctionNode<T,NDIM>& rhs) const {
-            return this->_coeffs.trace_conj((rhs._coeffs));
+            return coeff().trace_conj(rhs.coeff());
         }
 
         template <typename Archive>
         void serialize(Archive& ar) {
-            ar & coeff() & _has_children & _norm_tree & dnorm & snorm;
+            if constexpr (std::decay_t<Archive>::is_output_archive) {
+                // packed nodes stay packed, the archive holds the coefficients in T
+                coeffT c = unpacked_coeff();
+                ar & c;
+            }
+            else {
+                ar & coeff();
+            }
+            ar & _has_children & _norm_tree & dnorm & snorm;
         }
 
     };
@@ -465,6 +577,55 @@ namespace madness {
         return s;
     }
 
+    /// A FunctionNode with its coefficients stored to a given error bound
+
+    /// Used for lossy storage of functions, see ParallelOutputArchive::set_lossy_compression().
+    /// Low-rank coefficients are kept exactly.
+    template <typename T, std::size_t NDIM>
+    class QuantizedFunctionNode {
+        typedef FunctionNode<T,NDIM> nodeT;
+        typedef typename nodeT::coeffT coeffT;
+
+        QuantizedTensor<T> q;     ///< The coefficients, if they are a full tensor
+        coeffT lowrank;           ///< The coefficients, if they are not a full tensor
+        double norm_tree=1e300;
+        double dnorm=-1.0;
+        double snorm=-1.0;
+        bool has_children=false;
+
+    public:
+        QuantizedFunctionNode() = default;
+
+        /// Encodes the node such that the norm of the coefficient error is at most \c tol
+        QuantizedFunctionNode(const nodeT& node, const double tol)
+            : norm_tree(node.get_norm_tree())
+            , dnorm(node.get_dnorm())
+            , snorm(node.get_snorm())
+            , has_children(node.has_children())
+        {
+            if (node.coeff().has_no_data()) return;
+            if (node.coeff().is_full_tensor()) q = QuantizedTensor<T>(node.coeff().get_tensor(), tol);
+            else lowrank = node.coeff();
+        }
+
+        /// Returns the bound on the norm of the coefficient error
+        double tolerance() const {return q.tolerance();}
+
+        /// Returns the decoded node
+        nodeT node() const {
+            const coeffT coeff = lowrank.has_data() ? lowrank : coeffT(q.decode());
+            nodeT result(coeff, norm_tree, has_children);
+            result.set_dnorm(dnorm);
+            result.set_snorm(snorm);
+            return result;
+        }
+
+        template <typename Archive>
+        void serialize(Archive& ar) {
+            ar & q & lowrank & norm_tree & dnorm & snorm & has_children;
+        }
+    };
+
 
     /// returns true if the result of a hartree_product is a leaf node (compute norm & error)
     template<typename T, size_t NDIM>
@@ -932,6 +1093,7 @@ namespace madness {
         TreeState tree_state;
 
         dcT coeffs; ///< The coefficients
+        double packing_error_sq = 0.0; ///< Sum of the squared errors of the nodes packed by this process
 
         // Disable the default copy constructor
         FunctionImpl(const FunctionImpl<T,NDIM>& p);
@@ -1151,8 +1313,9 @@ namespace madness {
 
         // loads a function impl from persistence
         // @param[in] ar   the archive where the function impl is stored
+        // @param[in] lossy true if the coefficients were stored with lossy compression
         template <typename Archive>
-        void load(Archive& ar) {
+        void load(Archive& ar, const bool lossy=false) {
             // WE RELY ON K BEING STORED FIRST
             int kk = 0;
             ar & kk;
@@ -1163,7 +1326,18 @@ namespace madness {
             ar & thresh & initial_level & max_refine_level & truncate_mode
                 & autorefine & truncate_on_project & tree_state;//nonstandard & compressed ; //& bc;
 
-            ar & coeffs;
+            if (lossy) {
+                double fraction = 0.0;
+                WorldContainer<keyT,QuantizedFunctionNode<T,NDIM> > qcoeffs(world, coeffs.get_pmap());
+                ar & fraction & qcoeffs;
+                for (auto it=qcoeffs.begin(); it!=qcoeffs.end(); ++it) {
+                    const keyT& key = it->first;
+                    MADNESS_CHECK(it->second.tolerance() <= fraction*truncate_tol(thresh,key)*(1.0+1e-12));
+                    coeffs.replace(key, it->second.node());
+                }
+            } else {
+                ar & coeffs;
+            }
             world.gop.fence();
         }
 
@@ -1177,7 +1351,18 @@ namespace madness {
             ar & k & thresh & initial_level & max_refine_level & truncate_mode
                 & autorefine & truncate_on_project & tree_state;//nonstandard & compressed ; //& bc;
 
-            ar & coeffs;
+            // the error of each node is bounded relative to its truncation threshold
+            const double fraction = archive::get_lossy_compression(ar);
+            if (fraction > 0.0) {
+                WorldContainer<keyT,QuantizedFunctionNode<T,NDIM> > qcoeffs(world, coeffs.get_pmap());
+                for (auto it=coeffs.begin(); it!=coeffs.end(); ++it) {
+                    const keyT& key = it->first;
+                    qcoeffs.replace(key, QuantizedFunctionNode<T,NDIM>(it->second, fraction*truncate_tol(thresh,key)));
+                }
+                ar & fraction & qcoeffs;
+            } else {
+                ar & coeffs;
+            }
             world.gop.fence();
         }
 
@@ -2157,6 +2342,29 @@ namespace madness {
         };
 
 
+        /// packs the coefficients of the nodes in single precision where the error allows
+        struct do_pack {
+            typedef Range<typename dcT::iterator> rangeT;
+            const implT* impl;
+            double tol;
+
+            do_pack() : impl(0), tol(0.0) {}
+            do_pack(const implT* impl, double tol) : impl(impl), tol(tol) {}
+
+            double operator()(typename rangeT::iterator& it) const {
+                const double err = it->second.pack(impl->truncate_tol(tol, it->first));
+                return err*err;
+            }
+
+            double operator()(double a, double b) const {
+                return a+b;
+            }
+
+            template <typename Archive> void serialize(const Archive& ar) {
+                throw "NOT IMPLEMENTED";
+            }
+        };
+
         /// reduce the rank of the nodes, optional fence
         struct do_reduce_rank {
             typedef Range<typename dcT::iterator> rangeT;
@@ -2805,14 +3013,16 @@ namespace madness {
                     lss = left->unfilter(ld);
                 }
 
+                // all right functions have the same k, so they are unfiltered together
                 std::vector< Tensor<R> > vrss(vresult.size());
                 for (unsigned int i=0; i<vresult.size(); ++i) {
                     if (vrc[i].size()) {
                         Tensor<R> rd(cdata.v2k);
                         rd(cdata.s0) = vrc[i](___);
-                        vrss[i] = vright[i]->unfilter(rd);
+                        vrss[i] = rd;
                     }
                 }
+                vrss = vright[0]->unfilter(vrss);
 
                 for (KeyChildIterator<NDIM> kit(key); kit; ++kit) {
                     const keyT& child = kit.key();
@@ -2859,7 +3069,7 @@ namespace madness {
                 MADNESS_ASSERT(it != left->coeffs.end());
                 lnorm = it->second.get_norm_tree();
                 if (it->second.has_coeff())
-                    lc = it->second.coeff().reconstruct_tensor();
+                    lc = it->second.unpacked_coeff().reconstruct_tensor();
             }
 
             Tensor<R> rc = rcin;
@@ -2868,7 +3078,7 @@ namespace madness {
                 MADNESS_ASSERT(it != right->coeffs.end());
                 rnorm = it->second.get_norm_tree();
                 if (it->second.has_coeff())
-                    rc = it->second.coeff().reconstruct_tensor();
+                    rc = it->second.unpacked_coeff().reconstruct_tensor();
             }
 
             // both nodes are leaf nodes: multiply and return
@@ -2942,7 +3152,7 @@ namespace madness {
                 literT it = left->coeffs.find(key).get();
                 MADNESS_ASSERT(it != left->coeffs.end());
                 if (it->second.has_coeff())
-                    lc = it->second.coeff().reconstruct_tensor();
+                    lc = it->second.unpacked_coeff().reconstruct_tensor();
             }
 
             Tensor<R> rc = rcin;
@@ -2950,7 +3160,7 @@ namespace madness {
                 riterT it = right->coeffs.find(key).get();
                 MADNESS_ASSERT(it != right->coeffs.end());
                 if (it->second.has_coeff())
-                    rc = it->second.coeff().reconstruct_tensor();
+                    rc = it->second.unpacked_coeff().reconstruct_tensor();
             }
 
             if (rc.size() && lc.size()) { // Yipee!
@@ -4252,6 +4462,15 @@ namespace madness {
         /// @param[in]  targs   target tensor arguments (threshold and full/low rank)
         void reduce_rank(const double thresh, bool fence);
 
+        /// Stores coefficients in single precision where that changes a node by at most truncate_tol(tol,key)
+        void pack(const double tol, bool fence);
+
+        /// Converts all packed coefficients back to T
+        void unpack(bool fence);
+
+        /// Returns the norm of the errors made when packing nodes, collective
+        double packing_error() const;
+
 
         /// remove all nodes with level higher than n
         void chop_at_level(const int n, const bool fence=true);
@@ -4313,6 +4532,12 @@ namespace madness {
 
         coeffT unfilter(const coeffT& s) const;
 
+        /// Unfilters several tensors at once, empty tensors give empty results
+
+        /// Same as unfilter on each tensor, but each pass of the transform is a
+        /// single matrix multiplication for all of them.
+        std::vector<tensorT> unfilter(const std::vector<tensorT>& s) const;
+
         /// downsample the sum coefficients of level n+1 to sum coeffs on level n
 
         /// specialization of the filter method, will yield only the sum coefficients
@@ -4726,10 +4951,11 @@ namespace madness {
                 const keyT& key = it->first;
                 const FunctionNode<R,NDIM>& node = it->second;
                 if (node.has_coeff()) {
-                    if (node.coeff().dim(0) != k || op.doleaves) {
+                    const typename FunctionNode<R,NDIM>::coeffT coeff = node.unpacked_coeff();
+                    if (coeff.dim(0) != k || op.doleaves) {
                         ProcessID p = FunctionDefaults<NDIM>::get_apply_randomize() ? world.random_proc() : coeffs.owner(key);
 //                        woT::task(p, &implT:: template do_apply<opT,R>, &op, key, node.coeff()); //.full_tensor_copy() ????? why copy ????
-                        woT::task(p, &implT:: template do_apply<opT,R>, &op, key, node.coeff().reconstruct_tensor());
+                        woT::task(p, &implT:: template do_apply<opT,R>, &op, key, coeff.reconstruct_tensor());
                     }
                 }
             }
@@ -4872,7 +5098,7 @@ namespace madness {
             for (typename dcT::const_iterator it=f.get_coeffs().begin(); it!=end; ++it) {
 
                 const keyT& key = it->first;
-                const coeffT& coeff = it->second.coeff();
+                const coeffT coeff = it->second.unpacked_coeff();
 
                 if (coeff.has_data() and (coeff.rank()!=0)) {
                     ProcessID p = FunctionDefaults<NDIM>::get_apply_randomize() ? world.random_proc() : coeffs.owner(key);
@@ -5229,7 +5455,7 @@ namespace madness {
             double operator()(typename dcT::const_iterator& it) const {
                 const nodeT& node = it->second;
                 if (node.has_coeff()) {
-                    double norm = node.coeff().normf();
+                    double norm = node.unpacked_coeff().normf();
                     return norm*norm;
                 }
                 else {
@@ -5268,16 +5494,18 @@ namespace madness {
                     if (other->coeffs.probe(it->first)) {
                         const FunctionNode<R,NDIM>& gnode = other->coeffs.find(key).get()->second;
                         if (gnode.has_coeff()) {
-                            if (gnode.coeff().dim(0) != fnode.coeff().dim(0)) {
-                                madness::print("INNER", it->first, gnode.coeff().dim(0),fnode.coeff().dim(0));
+                            const coeffT fcoeff = fnode.unpacked_coeff();
+                            const typename FunctionNode<R,NDIM>::coeffT gcoeff = gnode.unpacked_coeff();
+                            if (gcoeff.dim(0) != fcoeff.dim(0)) {
+                                madness::print("INNER", it->first, gcoeff.dim(0),fcoeff.dim(0));
                                 MADNESS_EXCEPTION("functions have different k or compress/reconstruct error", 0);
                             }
                             if (leaves_only) {
                                 if (gnode.is_leaf() or fnode.is_leaf()) {
-                                    sum += fnode.coeff().trace_conj(gnode.coeff());
+                                    sum += fcoeff.trace_conj(gcoeff);
                                 }
                             } else {
-                                sum += fnode.coeff().trace_conj(gnode.coeff());
+                                sum += fcoeff.trace_conj(gcoeff);
                             }
                         }
                     }
@@ -6187,7 +6415,7 @@ namespace madness {
                 literT it = left->coeffs.find(key).get();
                 MADNESS_ASSERT(it != left->coeffs.end());
                 if (it->second.has_coeff())
-                    lc = it->second.coeff().reconstruct_tensor();
+                    lc = it->second.unpacked_coeff().reconstruct_tensor();
             }
 
             // Compute this node's coefficients if not provided in function call
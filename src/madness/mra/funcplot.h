@@ -317,6 +317,260 @@ namespace madness {
         world.gop.fence();
     }
 
+    namespace detail {
+
+        inline const char* vtk_type_name(float) {return "Float32";}
+        inline const char* vtk_type_name(double) {return "Float64";}
+
+        /// Holds the plot values of one slab of a grid and writes them to the file
+
+        /// The grid points are numbered with the first dimension fastest, as in
+        /// VTK.  Process p owns the planes [plane_lo[p],plane_lo[p+1]) of the
+        /// last dimension.  Values evaluated elsewhere are collected per owner
+        /// and exchanged in one message between each pair of processes.
+        template <typename T>
+        class PlotSlab : private Mutex {
+            typedef std::pair< std::vector<long>, std::vector<T> > batchT;
+
+            World& world;
+            std::vector<long> plane_lo; ///< First plane of each process, and the number of planes
+            long plane_size;            ///< Number of points in one plane
+            std::vector<T> values;      ///< Values in the local slab
+            std::vector<batchT> batch;  ///< Indices and values for each process
+
+        public:
+            PlotSlab(World& world, const long nplane, const long plane_size)
+                : world(world), plane_lo(world.size()+1), plane_size(plane_size), batch(world.size()) {
+                for (int p=0; p<=world.size(); ++p) plane_lo[p] = (nplane*p)/world.size();
+                values.resize((plane_lo[world.rank()+1]-plane_lo[world.rank()])*plane_size);
+            }
+
+            /// Returns the process owning grid point i
+            ProcessID owner(const long i) const {
+                return std::upper_bound(plane_lo.begin(), plane_lo.end(), i/plane_size) - plane_lo.begin() - 1;
+            }
+
+            /// Adds the value of grid point i, thread safe
+            void add(const std::vector<long>& index, const std::vector<T>& v) {
+                ScopedMutex<Mutex> obolus(this);
+                for (std::size_t i=0; i<index.size(); ++i) {
+                    batchT& b = batch[owner(index[i])];
+                    b.first.push_back(index[i]);
+                    b.second.push_back(v[i]);
+                }
+            }
+
+            /// Sends the values to their owners and receives the local ones, collective
+            void exchange() {
+                const int key = world.mpi.unique_tag();
+                for (ProcessID p=0; p<world.size(); ++p) {
+                    if (p != world.rank()) world.gop.send(p, key, batch[p]);
+                }
+                set(batch[world.rank()]);
+                for (ProcessID p=0; p<world.size(); ++p) {
+                    batch[p] = batchT();
+                    if (p != world.rank()) set(world.gop.template recv<batchT>(p, key).get());
+                }
+            }
+
+            /// Writes the local slab into the file, whose data start at byte offset
+            void write(const char* filename, const long offset) const {
+                if (values.empty()) return;
+                FILE* f = fopen(filename, "r+b");
+                if (!f) MADNESS_EXCEPTION("plotvti: failed to open the plot file", 0);
+                const long start = offset + plane_lo[world.rank()]*plane_size*long(sizeof(T));
+                if (fseek(f, start, SEEK_SET) != 0 || fwrite(values.data(), sizeof(T), values.size(), f) != values.size())
+                    MADNESS_EXCEPTION("plotvti: failed to write the plot file", 0);
+                fclose(f);
+            }
+
+        private:
+            void set(const batchT& b) {
+                const long offset = plane_lo[world.rank()]*plane_size;
+                for (std::size_t i=0; i<b.first.size(); ++i) values[b.first[i]-offset] = b.second[i];
+            }
+        };
+
+        /// Evaluates a leaf box at the grid points inside it and collects the values for their owners
+
+        /// The points inside the box form a sub-grid, so the values follow from a
+        /// single transform of the coefficients with the matrices of the scaling
+        /// functions at the points in each dimension.  A point belongs to the box
+        /// that contains it in the half-open sense, so each is evaluated once.
+        template <typename T, std::size_t NDIM>
+        void plot_box(PlotSlab<T>* slab, const Key<NDIM>& key, const Tensor<T>& coeff,
+                      const Vector<double,NDIM>& simlo, const Vector<double,NDIM>& h,
+                      const Vector<long,NDIM>& npt) {
+            const Level n = key.level();
+            const double twon = std::pow(2.0,double(n));
+            const long k = coeff.dim(0);
+
+            long lo[NDIM], m[NDIM], stride[NDIM];
+            Tensor<double> phi[NDIM];
+            std::vector<double> p(k);
+            for (std::size_t d=0; d<NDIM; ++d) {
+                const Translation l = key.translation()[d];
+                // translation of the box containing point i at level n
+                auto translation = [&](long i) {
+                    return std::min(Translation(std::floor((simlo[d]+i*h[d])*twon)), Translation(twon)-1);
+                };
+                // first point in a box with translation of at least t
+                auto first = [&](Translation t) {
+                    long i = (h[d] > 0.0) ? long(std::ceil((t/twon - simlo[d])/h[d])) : 0;
+                    i = std::max(0L, std::min(npt[d], i));
+                    while (i > 0 && translation(i-1) >= t) --i;
+                    while (i < npt[d] && translation(i) < t) ++i;
+                    return i;
+                };
+                lo[d] = first(l);
+                m[d] = first(l+1) - lo[d];
+                if (m[d] <= 0) return;
+                stride[d] = (d == 0) ? 1 : stride[d-1]*npt[d-1];
+
+                phi[d] = Tensor<double>(k, m[d]);
+                for (long i=0; i<m[d]; ++i) {
+                    const double x = std::max(0.0, std::min(1.0, (simlo[d]+(lo[d]+i)*h[d])*twon - l));
+                    legendre_scaling_functions(x, k, p.data());
+                    for (long j=0; j<k; ++j) phi[d](j,i) = p[j];
+                }
+            }
+
+            Tensor<T> v = general_transform(coeff, phi);
+            v.scale(std::pow(2.0,0.5*NDIM*n)/std::sqrt(FunctionDefaults<NDIM>::get_cell_volume()));
+
+            std::vector<long> index;
+            index.reserve(v.size());
+            for (IndexIterator it(NDIM, m); it; ++it) {
+                long i = 0;
+                for (std::size_t d=0; d<NDIM; ++d) i += (lo[d]+it[d])*stride[d];
+                index.push_back(i);
+            }
+            slab->add(index, std::vector<T>(v.ptr(), v.ptr()+v.size()));
+        }
+    }
+
+    /// Writes a VTK image data file (.vti) with a cube of points on a uniform grid, in parallel
+
+    /// Collective operation.  Each process evaluates the leaf boxes that it owns
+    /// at the grid points inside them, sends the values to the process owning
+    /// the slab of the grid that contains them, and every process then writes its
+    /// slab as raw binary data at its offset in the appended data section.
+    /// Each box is evaluated by one tensor transform, not point by point.
+    /// Neither the memory nor the work of any process grows with the full grid,
+    /// and nothing is formatted as text.  The file system must allow several
+    /// processes to write to disjoint parts of the same file.
+    ///
+    /// Complex values are written as two components (real and imaginary part).
+    /// @param f Function to plot
+    /// @param filename Name of the file to write
+    /// @param fieldname Name of the field in the file
+    /// @param plotlo Lower corner of the cube, in user coordinates
+    /// @param plothi Upper corner of the cube, in user coordinates, the cube is clipped to the cell
+    /// @param npt Number of points in each dimension
+    template <typename T, std::size_t NDIM>
+    void plotvti(const Function<T,NDIM>& f, const char* filename, const char* fieldname,
+                 const Vector<double,NDIM>& plotlo, const Vector<double,NDIM>& plothi,
+                 const Vector<long,NDIM>& npt) {
+        PROFILE_FUNC;
+        MADNESS_CHECK(NDIM>=1 && NDIM<=3);
+        typedef typename TensorTypeData<T>::scalar_type scalar_type;
+        World& world = f.world();
+
+        f.verify();
+        f.reconstruct();
+
+        // the cube is clipped to the cell, origin and spacing describe the clipped cube
+        Vector<double,NDIM> simlo, simhi, h, lo, hi, spacing;
+        user_to_sim(plotlo, simlo);
+        user_to_sim(plothi, simhi);
+        long npoint = 1;
+        for (std::size_t d=0; d<NDIM; ++d) {
+            MADNESS_CHECK(npt[d] >= 1);
+            simlo[d] = std::max(0.0, simlo[d]);
+            simhi[d] = std::min(1.0, simhi[d]);
+            MADNESS_CHECK(simhi[d] >= simlo[d]);
+            h[d] = (npt[d] > 1) ? (simhi[d]-simlo[d])/(npt[d]-1) : 0.0;
+            npoint *= npt[d];
+        }
+        sim_to_user(simlo, lo);
+        sim_to_user(simhi, hi);
+        for (std::size_t d=0; d<NDIM; ++d) {
+            spacing[d] = (npt[d] > 1) ? (hi[d]-lo[d])/(npt[d]-1) : 0.0;
+        }
+
+        // all processes compute the same header to find the offset of the data
+        std::ostringstream header;
+        const int one = 1;
+        header << "<?xml version=\"1.0\"?>\n"
+               << "<VTKFile type=\"ImageData\" version=\"1.0\" byte_order=\""
+               << ((*reinterpret_cast<const char*>(&one) == 1) ? "LittleEndian" : "BigEndian")
+               << "\" header_type=\"UInt64\">\n";
+        std::ostringstream extent, origin, space;
+        origin.precision(17);
+        space.precision(17);
+        for (std::size_t d=0; d<3; ++d) {
+            extent << "0 " << ((d < NDIM) ? npt[d]-1 : 0) << " ";
+            origin << ((d < NDIM) ? lo[d] : 0.0) << " ";
+            space << ((d < NDIM) ? spacing[d] : 0.0) << " ";
+        }
+        header << "  <ImageData WholeExtent=\"" << extent.str() << "\" Origin=\"" << origin.str()
+               << "\" Spacing=\"" << space.str() << "\">\n"
+               << "    <Piece Extent=\"" << extent.str() << "\">\n"
+               << "      <PointData Scalars=\"" << fieldname << "\">\n"
+               << "        <DataArray type=\"" << detail::vtk_type_name(scalar_type()) << "\" Name=\""
+               << fieldname << "\" NumberOfComponents=\"" << sizeof(T)/sizeof(scalar_type)
+               << "\" format=\"appended\" offset=\"0\"/>\n"
+               << "      </PointData>\n"
+               << "    </Piece>\n"
+               << "  </ImageData>\n"
+               << "  <AppendedData encoding=\"raw\">\n   _";
+        const std::string footer = "\n  </AppendedData>\n</VTKFile>\n";
+        const uint64_t nbyte = npoint*sizeof(T);
+        const long offset = header.str().size() + sizeof(nbyte);
+
+        if (world.rank() == 0) {
+            FILE* file = fopen(filename, "wb");
+            if (!file) MADNESS_EXCEPTION("plotvti: failed to open the plot file", 0);
+            fwrite(header.str().data(), 1, header.str().size(), file);
+            fwrite(&nbyte, sizeof(nbyte), 1, file);
+            fseek(file, offset+nbyte, SEEK_SET);
+            fwrite(footer.data(), 1, footer.size(), file);
+            fclose(file);
+        }
+
+        const long plane_size = npoint/npt[NDIM-1];
+        detail::PlotSlab<T> slab(world, npt[NDIM-1], plane_size);
+
+        const auto& coeffs = f.get_impl()->get_coeffs();
+        for (auto it=coeffs.begin(); it!=coeffs.end(); ++it) {
+            const auto& node = it->second;
+            if (node.has_coeff()) {
+                world.taskq.add(detail::plot_box<T,NDIM>, &slab, it->first, node.coeff().full_tensor_copy(),
+                                simlo, h, npt);
+            }
+        }
+        world.gop.fence();
+
+        slab.exchange();
+        slab.write(filename, offset);
+        world.gop.fence();
+    }
+
+    /// Writes a VTK image data file (.vti) of the whole simulation cell, in parallel
+
+    /// Collective operation, see the general version of plotvti.
+    template <typename T, std::size_t NDIM>
+    void plotvti(const Function<T,NDIM>& f, const char* filename, const char* fieldname="f",
+                 const long npt=201) {
+        const Tensor<double>& cell = FunctionDefaults<NDIM>::get_cell();
+        Vector<double,NDIM> plotlo, plothi;
+        for (std::size_t d=0; d<NDIM; ++d) {
+            plotlo[d] = cell(d,0);
+            plothi[d] = cell(d,1);
+        }
+        plotvti(f, filename, fieldname, plotlo, plothi, Vector<long,NDIM>(npt));
+    }
+
     namespace detail {
         inline unsigned short htons_x(unsigned short a) {
             return (a>>8) | (a<<8);
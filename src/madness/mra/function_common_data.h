@@ -80,6 +80,15 @@ namespace madness {
             _init_twoscale();
             _init_quadrature(k, npt, quad_x, quad_w, quad_phi, quad_phiw,
                              quad_phit);
+
+            // coefficients of the boxes and of their children come from the tensor pool
+            std::size_t nk = sizeof(T), n2k = sizeof(T);
+            for (std::size_t i = 0; i < NDIM; ++i) {
+                nk *= k;
+                n2k *= 2 * k;
+            }
+            tensor_pool_add_size(nk);
+            tensor_pool_add_size(n2k);
         }
 
     public:
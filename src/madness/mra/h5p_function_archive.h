@@ -0,0 +1,327 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_MRA_H5P_FUNCTION_ARCHIVE_H__INCLUDED
+#define MADNESS_MRA_H5P_FUNCTION_ARCHIVE_H__INCLUDED
+
+/// \file h5p_function_archive.h
+/// \brief Stores the nodes of functions as tables in the HDF5 parallel archive
+
+/// A function written to a \c ParallelOutputArchive<H5POutputArchive> is a
+/// record of kind \c "function" with one row per node in the tables
+///  - \c key: the locational code of the node at level \c n with translation
+///    \c l, which is 2^(NDIM*n) plus bit \c b of \c l[d] at position NDIM*b+d,
+///    in \c key_words unsigned 64-bit words, the least significant first;
+///  - \c has_children: one for interior nodes;
+///  - \c norm: the norm of the tree below, of the d and of the s coefficients;
+///  - \c coeff_dim: the extent of the coefficients in each dimension, zero if none;
+///  - \c coeff_row: the row of the coefficients in \c coeff, -1 if none.
+///
+/// The table \c coeff has one row of \c max_coeff_dim^NDIM elements per node
+/// with coefficients, padded with zeros if \c coeff_dim is smaller, and is
+/// chunked such that chunks hold whole nodes. The nodes of every writer are
+/// sorted by their code, i.e. by level and then along a Z-order curve, so the
+/// top levels of a tree or the nodes in a region are in few chunks. Only
+/// full-rank coefficients can be stored this way; lossy compressed functions
+/// are stored as containers.
+
+#include <madness/mra/funcimpl.h>
+#include <madness/world/h5p_archive.h>
+
+#ifdef HAVE_HDF5
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+namespace madness {
+
+    /// Converts keys to and from their locational codes in the HDF5 parallel archive
+    template <std::size_t NDIM>
+    struct H5PKeyCode {
+        /// Returns the number of 64-bit words for the codes of keys down to level \c n
+        static std::size_t nword(const Level n) {
+            return (NDIM*n)/64 + 1;
+        }
+
+        /// Appends the \c nw words of the code of \c key to \c code
+        static void encode(const Key<NDIM>& key, const std::size_t nw, std::vector<std::uint64_t>& code) {
+            std::uint64_t* c = &*code.insert(code.end(), nw, 0);
+            const Level n = key.level();
+            for (Level b=0; b<n; ++b) {
+                for (std::size_t d=0; d<NDIM; ++d) {
+                    if ((key.translation()[d] >> b) & 1) set(c, NDIM*b+d);
+                }
+            }
+            set(c, NDIM*n);
+        }
+
+        /// Returns the key of the code of \c nw words
+        static Key<NDIM> decode(const std::uint64_t* c, const std::size_t nw) {
+            std::size_t top = 64*nw;
+            while (top > 0 && !get(c, top-1)) --top;
+            MADNESS_CHECK(top > 0 && (top-1)%NDIM == 0);
+            const Level n = (top-1)/NDIM;
+            Vector<Translation,NDIM> l(0);
+            for (Level b=0; b<n; ++b) {
+                for (std::size_t d=0; d<NDIM; ++d) {
+                    if (get(c, NDIM*b+d)) l[d] |= Translation(1) << b;
+                }
+            }
+            return Key<NDIM>(n, l);
+        }
+
+    private:
+        static void set(std::uint64_t* c, const std::size_t bit) {
+            c[bit/64] |= std::uint64_t(1) << (bit%64);
+        }
+
+        static bool get(const std::uint64_t* c, const std::size_t bit) {
+            return (c[bit/64] >> (bit%64)) & 1;
+        }
+    };
+
+    /// Reads rows of the node tables of the current function record
+
+    /// \param[in] h5 The archive, with a record of kind \c "function" open.
+    /// \param[in] rows The rows in increasing order.
+    /// \return The keys and nodes of the rows.
+    template <typename T, std::size_t NDIM>
+    std::vector<std::pair<Key<NDIM>,FunctionNode<T,NDIM> > >
+    read_function_rows(const archive::H5PInputArchive& h5, const std::vector<std::size_t>& rows) {
+        typedef FunctionNode<T,NDIM> nodeT;
+        typedef typename nodeT::coeffT coeffT;
+        MADNESS_CHECK(h5.read_attribute("ndim")[0] == std::int64_t(NDIM));
+        const std::size_t nw = h5.read_attribute("key_words")[0];
+        const long maxdim = h5.read_attribute("max_coeff_dim")[0];
+        std::size_t ncoeff = 1;
+        for (std::size_t d=0; d<NDIM; ++d) ncoeff *= maxdim;
+
+        const std::vector<std::uint64_t> code = h5.read_rows<std::uint64_t>("key", rows);
+        const std::vector<std::uint8_t> has_children = h5.read_rows<std::uint8_t>("has_children", rows);
+        const std::vector<double> norm = h5.read_rows<double>("norm", rows);
+        const std::vector<std::int32_t> coeff_dim = h5.read_rows<std::int32_t>("coeff_dim", rows);
+        const std::vector<std::int64_t> coeff_row = h5.read_rows<std::int64_t>("coeff_row", rows);
+
+        std::vector<std::size_t> crows;
+        for (std::int64_t r : coeff_row) if (r >= 0) crows.push_back(r);
+        const std::vector<T> coeff = (ncoeff > 0) ? h5.read_rows<T>("coeff", crows) : std::vector<T>();
+
+        std::vector<std::pair<Key<NDIM>,nodeT> > result;
+        result.reserve(rows.size());
+        std::size_t next = 0;
+        for (std::size_t i=0; i<rows.size(); ++i) {
+            coeffT c;
+            if (coeff_row[i] >= 0) {
+                Tensor<T> t(std::vector<long>(NDIM, coeff_dim[i]));
+                std::copy(&coeff[next*ncoeff], &coeff[next*ncoeff] + t.size(), t.ptr());
+                c = coeffT(t);
+                ++next;
+            }
+            nodeT node(c, norm[3*i], has_children[i] != 0);
+            node.set_dnorm(norm[3*i+1]);
+            node.set_snorm(norm[3*i+2]);
+            result.push_back(std::make_pair(H5PKeyCode<NDIM>::decode(&code[i*nw], nw), node));
+        }
+        return result;
+    }
+
+    /// Reads the nodes of a function in the HDF5 parallel archive that satisfy a predicate
+
+    /// All keys of the function are read but only the coefficients of the
+    /// selected nodes. This is independent of the other processes, e.g. for
+    /// post-processing on one process without loading the function.
+    /// \param[in] h5 The archive.
+    /// \param[in] record The index of a record of kind \c "function".
+    /// \param[in] select Returns true for the keys of the nodes to read.
+    /// \return The keys and nodes selected.
+    template <typename T, std::size_t NDIM>
+    std::vector<std::pair<Key<NDIM>,FunctionNode<T,NDIM> > >
+    read_function_nodes(archive::H5PInputArchive& h5, const std::size_t record,
+                        const std::function<bool(const Key<NDIM>&)>& select) {
+        MADNESS_CHECK(h5.kind(record) == "function");
+        h5.open_record(record);
+        const std::size_t nw = h5.read_attribute("key_words")[0];
+        const std::vector<std::uint64_t> code = h5.read_rows<std::uint64_t>("key", 0, h5.nrow("key"));
+        std::vector<std::size_t> rows;
+        for (std::size_t i=0; i<code.size()/nw; ++i) {
+            if (select(H5PKeyCode<NDIM>::decode(&code[i*nw], nw))) rows.push_back(i);
+        }
+        std::vector<std::pair<Key<NDIM>,FunctionNode<T,NDIM> > > result = read_function_rows<T,NDIM>(h5, rows);
+        h5.end_record();
+        return result;
+    }
+
+    /// Selects the nodes of a function down to level \c n for \c read_function_nodes()
+    template <std::size_t NDIM>
+    std::function<bool(const Key<NDIM>&)> select_nodes_to_level(const Level n) {
+        return [n](const Key<NDIM>& key) {return key.level() <= n;};
+    }
+
+    /// Selects the nodes of a function whose boxes overlap a region for \c read_function_nodes()
+
+    /// \param[in] lo The lower corner of the region in user coordinates.
+    /// \param[in] hi The upper corner of the region in user coordinates.
+    template <std::size_t NDIM>
+    std::function<bool(const Key<NDIM>&)> select_nodes_in_region(const Vector<double,NDIM>& lo,
+                                                                  const Vector<double,NDIM>& hi) {
+        Vector<double,NDIM> slo, shi;
+        user_to_sim(lo, slo);
+        user_to_sim(hi, shi);
+        return [slo,shi](const Key<NDIM>& key) {
+            const double h = std::ldexp(1.0, -key.level());
+            for (std::size_t d=0; d<NDIM; ++d) {
+                const double x = key.translation()[d]*h;
+                if (x > shi[d] || x+h < slo[d]) return false;
+            }
+            return true;
+        };
+    }
+
+    namespace archive {
+
+        /// Write the nodes of a function to an HDF5 parallel archive as tables
+
+        /// \ingroup worlddc
+        /// Every process writes the rows of its local nodes.
+        template <typename T, std::size_t NDIM>
+        struct ArchiveStoreImpl< ParallelOutputArchive<H5POutputArchive>, WorldContainer<Key<NDIM>,FunctionNode<T,NDIM> > > {
+            typedef WorldContainer<Key<NDIM>,FunctionNode<T,NDIM> > dcT;
+
+            static void store(const ParallelOutputArchive<H5POutputArchive>& ar, const dcT& t) {
+                World* world = ar.get_world();
+                if (ar.dofence()) world->gop.fence();
+
+                std::vector<const typename dcT::pairT*> nodes;
+                Level maxlevel = 0;
+                long maxdim = 0;
+                for (auto it=t.begin(); it!=t.end(); ++it) {
+                    nodes.push_back(&*it);
+                    maxlevel = std::max(maxlevel, it->first.level());
+                    const auto& c = it->second.coeff();
+                    if (c.has_data()) {
+                        MADNESS_CHECK_THROW(c.is_full_tensor(), "H5POutputArchive stores only full-rank coefficients");
+                        maxdim = std::max(maxdim, c.dim(0));
+                    }
+                }
+                world->gop.max(maxlevel);
+                world->gop.max(maxdim);
+                const std::size_t nw = H5PKeyCode<NDIM>::nword(maxlevel);
+                std::size_t ncoeff = 1;
+                for (std::size_t d=0; d<NDIM; ++d) ncoeff *= maxdim;
+
+                // Sort the nodes by their code
+                std::vector<std::uint64_t> code;
+                code.reserve(nodes.size()*nw);
+                for (const auto* p : nodes) H5PKeyCode<NDIM>::encode(p->first, nw, code);
+                std::vector<std::size_t> order(nodes.size());
+                std::iota(order.begin(), order.end(), 0);
+                std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+                    for (std::size_t w=nw; w-->0; ) {
+                        if (code[a*nw+w] != code[b*nw+w]) return code[a*nw+w] < code[b*nw+w];
+                    }
+                    return false;
+                });
+
+                std::vector<std::uint64_t> key;
+                std::vector<std::uint8_t> has_children;
+                std::vector<double> norm;
+                std::vector<std::int32_t> coeff_dim;
+                std::vector<std::int64_t> coeff_row;
+                std::vector<T> coeff;
+                key.reserve(code.size());
+                for (std::size_t i : order) {
+                    const FunctionNode<T,NDIM>& node = nodes[i]->second;
+                    key.insert(key.end(), &code[i*nw], &code[i*nw] + nw);
+                    has_children.push_back(node.has_children());
+                    norm.push_back(node.get_norm_tree());
+                    norm.push_back(node.get_dnorm());
+                    norm.push_back(node.get_snorm());
+                    if (node.coeff().has_data()) {
+                        Tensor<T> c = node.coeff().get_tensor();
+                        if (!c.iscontiguous()) c = copy(c);
+                        coeff_dim.push_back(c.dim(0));
+                        coeff_row.push_back(coeff.size()/ncoeff);
+                        coeff.insert(coeff.end(), c.ptr(), c.ptr() + c.size());
+                        coeff.resize(coeff.size() + ncoeff - c.size(), T(0));
+                    } else {
+                        coeff_dim.push_back(0);
+                        coeff_row.push_back(-1);
+                    }
+                }
+
+                H5POutputArchive& h5 = ar.local_archive();
+                h5.begin_record("function");
+                h5.write_attribute("ndim", std::vector<std::int64_t>(1, NDIM));
+                h5.write_attribute("key_words", std::vector<std::int64_t>(1, nw));
+                h5.write_attribute("max_coeff_dim", std::vector<std::int64_t>(1, maxdim));
+                const std::size_t first = (ncoeff > 0) ? h5.write_rows("coeff", coeff, ncoeff) : 0;
+                for (auto& r : coeff_row) if (r >= 0) r += first;
+                h5.write_rows("key", key, nw);
+                h5.write_rows("has_children", has_children, 1);
+                h5.write_rows("norm", norm, 3);
+                h5.write_rows("coeff_dim", coeff_dim, 1);
+                h5.write_rows("coeff_row", coeff_row, 1);
+                h5.end_record();
+                if (ar.dofence()) world->gop.fence();
+            }
+        };
+
+        /// Read the nodes of a function from an HDF5 parallel archive
+
+        /// \ingroup worlddc
+        /// The rows are split evenly over the current processes and the nodes
+        /// are inserted with \c replace(), which sends them to their owner in
+        /// the current process map.
+        template <typename T, std::size_t NDIM>
+        struct ArchiveLoadImpl< ParallelInputArchive<H5PInputArchive>, WorldContainer<Key<NDIM>,FunctionNode<T,NDIM> > > {
+            static void load(const ParallelInputArchive<H5PInputArchive>& ar, WorldContainer<Key<NDIM>,FunctionNode<T,NDIM> >& t) {
+                World* world = ar.get_world();
+                if (ar.dofence()) world->gop.fence();
+                H5PInputArchive& h5 = ar.local_archive();
+                h5.begin_record("function");
+                const std::size_t n = h5.nrow("has_children");
+                const std::size_t nproc = world->size();
+                const std::size_t me = world->rank();
+                std::vector<std::size_t> rows(n*(me+1)/nproc - n*me/nproc);
+                std::iota(rows.begin(), rows.end(), n*me/nproc);
+                for (const auto& node : read_function_rows<T,NDIM>(h5, rows)) t.replace(node.first, node.second);
+                h5.end_record();
+                if (ar.dofence()) world->gop.fence();
+            }
+        };
+    }
+}
+
+#endif // HAVE_HDF5
+
+#endif // MADNESS_MRA_H5P_FUNCTION_ARCHIVE_H__INCLUDED
@@ -17,6 +17,10 @@
  The user-defined macrotask is derived from MacroTaskIntermediate and must implement the run()
  method. A heterogeneous task queue is possible.
 
+ Tasks may declare their resource needs (number of processes, memory footprint). If adaptive
+ subworld sizing is switched on the universe is re-split before each run_all() such that the
+ most demanding waiting task fits into a single subworld.
+
  TODO: priority q
  TODO: task submission from inside task (serialize task instead of replicate)
  TODO: update documentation
@@ -47,6 +51,23 @@ public:
 	double priority=1.0;
 	enum Status {Running, Waiting, Complete, Unknown} stat=Unknown;
 
+	/// resources a task declares to need, used for sizing the subworlds
+	struct Resources {
+		long nproc=1;			///< number of processes the task can use efficiently
+		double memory=0.0;		///< estimated memory footprint of the task in bytes
+	} resources;
+
+	/// number of processes a subworld must provide to run this task
+
+	/// @param[in]	memory_per_process	memory available per process in bytes, 0 to ignore memory
+	long required_nproc(const double memory_per_process) const {
+		long n=std::max(1l,resources.nproc);
+		if (memory_per_process>0.0 and resources.memory>0.0) {
+			n=std::max(n,long(std::ceil(resources.memory/memory_per_process)));
+		}
+		return n;
+	}
+
 	void set_complete() {stat=Complete;}
 	void set_running() {stat=Running;}
 	void set_waiting() {stat=Waiting;}
@@ -109,6 +130,8 @@ class MacroTaskQ : public WorldObject< MacroTaskQ> {
 	std::mutex taskq_mutex;
 	long printlevel=0;
 	long nsubworld=1;
+	bool adaptive_subworlds=false;		///< re-split the universe before each run_all
+	double memory_per_process=0.0;		///< memory available per process in bytes
     std::shared_ptr< WorldDCPmapInterface< Key<1> > > pmap1;
     std::shared_ptr< WorldDCPmapInterface< Key<2> > > pmap2;
     std::shared_ptr< WorldDCPmapInterface< Key<3> > > pmap3;
@@ -126,6 +149,16 @@ public:
 	long get_nsubworld() const {return nsubworld;}
 	void set_printlevel(const long p) {printlevel=p;}
 
+	/// let the taskq choose the number of subworlds from the tasks' declared resources
+
+	/// @param[in]	flag	switch adaptive subworld sizing on or off
+	/// @param[in]	memory	memory available per process in bytes, used to translate the tasks'
+	/// 					memory estimates into a number of processes; 0 to ignore memory
+	void set_adaptive_subworlds(const bool flag, const double memory=0.0) {
+		adaptive_subworlds=flag;
+		memory_per_process=memory;
+	}
+
     /// create an empty taskq and initialize the subworlds
 	MacroTaskQ(World& universe, int nworld, const long printlevel=0)
 		  : universe(universe), WorldObject<MacroTaskQ>(universe), taskq(), cloud(universe), printlevel(printlevel),
@@ -151,6 +184,34 @@ public:
 		return all_worlds;
 	}
 
+	/// collectively re-split the universe into nworld subworlds
+
+	/// must be called by all processes of the universe outside of run_all
+	void resize_subworlds(const long nworld) {
+		MADNESS_CHECK(nworld>0 and nworld<=universe.size());
+		if (nworld==nsubworld) return;
+		universe.gop.fence();
+		subworld_ptr.reset();
+		subworld_ptr=create_worlds(universe,nworld);
+		nsubworld=nworld;
+		if (printtimings()) print("resized taskq to",nsubworld,"subworlds");
+	}
+
+	/// the number of subworlds such that every task fits into one subworld
+
+	/// @param[in]	taskq	the tasks to be run, completed tasks are ignored
+	/// @param[in]	nproc	number of processes in the universe
+	/// @param[in]	memory	memory available per process in bytes
+	static long optimal_nsubworld(const MacroTaskBase::taskqT& taskq, const long nproc, const double memory) {
+		long subworld_size=1;
+		for (const auto& t : taskq) {
+			if (t->is_complete()) continue;
+			subworld_size=std::max(subworld_size,t->required_nproc(memory));
+		}
+		subworld_size=std::min(subworld_size,nproc);
+		return std::max(1l,nproc/subworld_size);
+	}
+
 	/// run all tasks, tasks may store the results in the cloud
 	void run_all(MacroTaskBase::taskqT vtask=MacroTaskBase::taskqT()) {
 
@@ -158,6 +219,14 @@ public:
 		for (int i=0; i<vtask.size(); ++i) add_replicated_task(vtask[i]);
 		if (printdebug()) print_taskq();
 
+		// task status is only known on the scheduler
+		if (adaptive_subworlds) {
+			long n=0;
+			if (universe.rank()==0) n=optimal_nsubworld(taskq,universe.size(),memory_per_process);
+			universe.gop.broadcast(n,0);
+			resize_subworlds(n);
+		}
+
 		cloud.replicate();
         universe.gop.fence();
         universe.gop.set_forbid_fence(true); // make sure there are no hidden universe fences
@@ -389,6 +458,7 @@ private:
             static_assert(is_madness_function<resultT>::value || is_madness_function_vector<resultT>::value);
             this->task.batch=batch_prio.first;
             this->priority=batch_prio.second;
+            this->resources=task.resources;
         }
 
 
@@ -464,6 +534,7 @@ class MacroTaskOperationBase {
 public:
     Batch batch;
     std::shared_ptr<MacroTaskPartitioner> partitioner=0;
+    MacroTaskBase::Resources resources;     ///< resources needed by each batch of this operation
     MacroTaskOperationBase() : batch(Batch(_, _, _)), partitioner(new MacroTaskPartitioner) {}
 };
 
@@ -67,6 +67,7 @@ namespace madness {
 #include <madness/mra/legendre.h>
 #include <madness/mra/indexit.h>
 #include <madness/world/parallel_archive.h>
+#include <madness/world/async_checkpoint.h>
 #include <madness/world/worlddc.h>
 #include <madness/mra/funcdefaults.h>
 #include <madness/mra/function_factory.h>
@@ -602,10 +603,46 @@ namespace madness {
             verify();
 //            if (!is_compressed()) compress();
             impl->truncate(tol,fence);
+            const double fraction = FunctionDefaults<NDIM>::get_mixed_precision();
+            if (fence && fraction > 0.0) impl->pack(fraction*((tol > 0.0) ? tol : thresh()), true);
             if (VERIFY_TREE) verify_tree();
             return *this;
         }
 
+        /// Stores coefficients in single precision where the error of a node is at most \c fraction of its threshold
+
+        /// Deep levels of a truncated function hold coefficients of small norm,
+        /// which lose nothing of significance in single precision and so take
+        /// half the memory.  inner(), apply() and multiplication convert packed
+        /// nodes on the fly, all other operations convert the nodes they touch
+        /// back to double precision.  Only full-rank double and double_complex
+        /// coefficients are packed; low-rank (SVD) coefficients of a GenTensor
+        /// build keep their precision.  See also FunctionDefaults::set_mixed_precision().
+        Function<T,NDIM>& pack(double fraction = 0.1, bool fence = true) {
+            PROFILE_MEMBER_FUNC(Function);
+            if (!impl) return *this;
+            verify();
+            impl->pack(fraction*thresh(), fence);
+            return *this;
+        }
+
+        /// Converts all packed coefficients back to double precision
+        Function<T,NDIM>& unpack(bool fence = true) {
+            PROFILE_MEMBER_FUNC(Function);
+            if (!impl) return *this;
+            verify();
+            impl->unpack(fence);
+            return *this;
+        }
+
+        /// Returns the norm of the errors made by packing coefficients in single precision, collective
+        double packing_error() const {
+            PROFILE_MEMBER_FUNC(Function);
+            if (!impl) return 0.0;
+            verify();
+            return impl->packing_error();
+        }
+
 
         /// Returns a shared-pointer to the implementation
         const std::shared_ptr< FunctionImpl<T,NDIM> >& get_impl() const {
@@ -1427,13 +1464,13 @@ namespace madness {
             // Type checking since we are probably circumventing the archive's own type checking
             long magic = 0l, id = 0l, ndim = 0l, k = 0l;
             ar & magic & id & ndim & k;
-            MADNESS_ASSERT(magic == 7776768); // Mellow Mushroom Pizza tel.# in Knoxville
+            MADNESS_ASSERT(magic == 7776768 or magic == 7776769); // Mellow Mushroom Pizza tel.# in Knoxville, +1 if lossy
             MADNESS_ASSERT(id == TensorTypeData<T>::id);
             MADNESS_ASSERT(ndim == NDIM);
 
             impl.reset(new implT(FunctionFactory<T,NDIM>(world).k(k).empty()));
 
-            impl->load(ar);
+            impl->load(ar, magic == 7776769);
         }
 
 
@@ -1447,7 +1484,8 @@ namespace madness {
             PROFILE_MEMBER_FUNC(Function);
             verify();
             // For type checking, etc.
-            ar & long(7776768) & long(TensorTypeData<T>::id) & long(NDIM) & long(k());
+            const long magic = (archive::get_lossy_compression(ar) > 0.0) ? 7776769 : 7776768;
+            ar & magic & long(TensorTypeData<T>::id) & long(NDIM) & long(k());
 
             impl->store(ar);
         }
@@ -2697,9 +2735,18 @@ namespace madness {
         ar2 & f;
     }
 
+    /// Save a function in the background, the file can be read with load()
+
+    /// The coefficients are copied into a staging buffer before returning.
+    /// The future is assigned once the file of this process is written.
+    template <class T, std::size_t NDIM>
+    Future<bool> save_async(const Function<T,NDIM>& f, const std::string name) {
+        return save_async(f.world(), f, name);
+    }
+
     template <class T, std::size_t NDIM>
     void load(Function<T,NDIM>& f, const std::string name) {
-        archive::ParallelInputArchive<archive::BinaryFstreamInputArchive> ar2(f.world(), name.c_str(), 1);
+        archive::ParallelInputArchive<archive::MmapInputArchive> ar2(f.world(), name.c_str(), 1);
         ar2 & f;
     }
 
@@ -2721,6 +2768,7 @@ namespace madness {
 #include <madness/mra/operator.h>
 #include <madness/mra/functypedefs.h>
 #include <madness/mra/vmra.h>
+#include <madness/mra/h5p_function_archive.h>
 // #include <madness/mra/mraimpl.h> !!!!!!!!!!!!! NOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOO  !!!!!!!!!!!!!!!!!!
 
 #endif // MADNESS_MRA_MRA_H__INCLUDED
@@ -899,10 +899,11 @@ namespace madness {
                     //                        s(cdata.s0) = acc[i]->second.coeff()(___);
                     s(cdata.s0) = acc[i]->second.coeff().full_tensor_copy();
                     acc[i]->second.clear_coeff();
-                    d[i] = unfilter(s);
+                    d[i] = s;
                     acc[i]->second.set_has_children(true);
                 }
             }
+            d = unfilter(d);
 
             // Loop thru children and pass down
             for (KeyChildIterator<NDIM> kit(key); kit; ++kit) {
@@ -1135,8 +1136,9 @@ namespace madness {
 
         // values for eri: this must be done in full rank...
         if (veri.has_data()) {
-            tensorT val_ket2=val_ket.full_tensor_copy().emul(veri);
-            if (val_result.has_data()) val_ket2+=val_result.full_tensor_copy();
+            tensorT val_ket2=val_ket.full_tensor_copy();
+            if (val_result.has_data()) assign(val_ket2,lazy(val_ket2)*lazy(veri)+lazy(val_result.full_tensor_copy()));
+            else val_ket2.emul(veri);
             // values2coeffs expensive (30%), coeffT() (relatively) cheap (8%)
             coeff_result=coeffT(values2coeffs(key,val_ket2),this->get_tensor_args());
 
@@ -1209,6 +1211,28 @@ namespace madness {
         flo_unary_op_node_inplace(do_reduce_rank(thresh),fence);
     }
 
+    template <typename T, std::size_t NDIM>
+    void FunctionImpl<T,NDIM>::pack(const double tol, bool fence) {
+        PROFILE_MEMBER_FUNC(FunctionImpl);
+        typedef Range<typename dcT::iterator> rangeT;
+        packing_error_sq += world.taskq.reduce<double,rangeT,do_pack>(rangeT(coeffs.begin(),coeffs.end()),
+                                                                       do_pack(this, tol));
+        if (fence) world.gop.fence();
+    }
+
+    template <typename T, std::size_t NDIM>
+    void FunctionImpl<T,NDIM>::unpack(bool fence) {
+        for (typename dcT::iterator it=coeffs.begin(); it!=coeffs.end(); ++it) it->second.unpack();
+        if (fence) world.gop.fence();
+    }
+
+    template <typename T, std::size_t NDIM>
+    double FunctionImpl<T,NDIM>::packing_error() const {
+        double sum = packing_error_sq;
+        world.gop.sum(sum);
+        return std::sqrt(sum);
+    }
+
     /// reduce the rank of the coefficients tensors
 
     /// @param[in]  targs   target tensor arguments (threshold and full/low rank)
@@ -1291,6 +1315,12 @@ namespace madness {
         return transform(s,cdata.hg);
     }
 
+    template <typename T, std::size_t NDIM>
+    std::vector<typename FunctionImpl<T,NDIM>::tensorT>
+    FunctionImpl<T,NDIM>::unfilter(const std::vector<tensorT>& s) const {
+        return transform_batch(s,cdata.hg);
+    }
+
     /// downsample the sum coefficients of level n+1 to sum coeffs on level n
 
     /// specialization of the filter method, will yield only the sum coefficients
@@ -3439,6 +3469,7 @@ template <typename T, std::size_t NDIM>
         special_level = 3;
         max_refine_level = 30;
         truncate_mode = 0;
+        mixed_precision = 0.0;
         refine = true;
         autorefine = true;
         debug = false;
@@ -3470,6 +3501,7 @@ template <typename T, std::size_t NDIM>
     		std::cout << "                   special_level" <<  ": " << special_level << std::endl;
     		std::cout << "                max_refine_level" <<  ": " << max_refine_level << std::endl;
     		std::cout << "                   truncate_mode" <<  ": " << truncate_mode << std::endl;
+    		std::cout << "                 mixed_precision" <<  ": " << mixed_precision << std::endl;
     		std::cout << "                          refine" <<  ": " << refine << std::endl;
     		std::cout << "                      autorefine" <<  ": " << autorefine << std::endl;
     		std::cout << "                           debug" <<  ": " << debug << std::endl;
@@ -3491,6 +3523,7 @@ template <typename T, std::size_t NDIM>
     template <std::size_t NDIM> int FunctionDefaults<NDIM>::special_level = 3;
     template <std::size_t NDIM> int FunctionDefaults<NDIM>::max_refine_level = 30;
     template <std::size_t NDIM> int FunctionDefaults<NDIM>::truncate_mode = 0;
+    template <std::size_t NDIM> double FunctionDefaults<NDIM>::mixed_precision = 0.0;
     template <std::size_t NDIM> bool FunctionDefaults<NDIM>::refine = true;
     template <std::size_t NDIM> bool FunctionDefaults<NDIM>::autorefine = true;
     template <std::size_t NDIM> bool FunctionDefaults<NDIM>::debug = false;
@@ -118,6 +118,8 @@ namespace madness {
 		Function<double,NDIM> update(const Function<double,NDIM>& u, const Function<double,NDIM>& r,
 				const double rcondtol=1e-8, const double cabsmax=1000.0) {
 			if (maxsub==1) return u-r;
+			static const int memtag=memory_tag_id("KAIN subspace");
+			MemoryTagScope memscope(memtag);
 			int iter = ulist.size();
 			ulist.push_back(u);
 			rlist.push_back(r);
@@ -156,6 +158,21 @@ namespace madness {
 	typedef NonlinearSolverND<3> NonlinearSolver;
 
 
+	namespace detail {
+		/// unew += (u - r)*c, the KAIN update of XNonlinearSolver
+		template <typename T, typename C>
+		void kain_accumulate(T& unew, const T& u, const T& r, const C& c) {
+			unew += (u - r)*c;
+		}
+
+		/// unew += (u - r)*c for tensors, in a single pass over memory
+		template <typename T, typename C>
+		void kain_accumulate(Tensor<T>& unew, const Tensor<T>& u, const Tensor<T>& r, const C& c) {
+			if (unew.has_data()) assign(unew, lazy(unew) + (lazy(u) - lazy(r))*c);
+			else unew = evaluate((lazy(u) - lazy(r))*c);
+		}
+	}
+
 	template <class T>
 	struct default_allocator {
         T operator()() {return T();}
@@ -224,6 +241,8 @@ namespace madness {
         /// @param[in]          cabsmax  maximum element of c greater than this will cause the subspace to be shrunk due to li
 	T update(const T& u, const T& r, const double rcondtol=1e-8, const double cabsmax=1000.0) {
 		if (maxsub==1) return u-r;
+		static const int memtag=memory_tag_id("KAIN subspace");
+		MemoryTagScope memscope(memtag);
 		int iter = ulist.size();
 		ulist.push_back(u);
 		rlist.push_back(r);
@@ -244,7 +263,7 @@ namespace madness {
 		// Form new solution in u
 		T unew = alloc();
 		for (int i=0; i<=iter; i++) {
-			unew += (ulist[i] - rlist[i])*c[i];
+			detail::kain_accumulate(unew, ulist[i], rlist[i], c[i]);
 		}
 
 		if (ulist.size() == maxsub) {
@@ -732,6 +732,9 @@ namespace madness {
             const SeparatedConvolutionData<Q,NDIM>* p = data.getptr(n,d);
             if (p) return p;
 
+            static const int memtag=memory_tag_id("operator cache");
+            MemoryTagScope memscope(memtag);
+
             // get the data for each term
             SeparatedConvolutionData<Q,NDIM> op(rank);
             for (int mu=0; mu<rank; ++mu) {
@@ -772,6 +775,9 @@ namespace madness {
             const SeparatedConvolutionData<Q,NDIM>* p = mod_data.getptr(n,key);
             if (p) return p;
 
+            static const int memtag=memory_tag_id("operator cache");
+            MemoryTagScope memscope(memtag);
+
             // get the data for each term
             // op.muops is of type SeparatedConvolutionInternal (1 term, all dim, 1 disp)
             // getmuop uses ConvolutionND
@@ -231,6 +231,39 @@ int test_2d_partitioning(World& universe, const std::vector<real_function_3d>& v
     return success;
 }
 
+int test_adaptive_subworlds(World& universe, const std::vector<real_function_3d>& v3,
+                  const std::vector<real_function_3d>& ref) {
+    if (universe.rank() == 0) print("\nstarting adaptive subworld sizing");
+    int success=0;
+
+    // tasks requesting 4 processes or 3 GB with 1 GB per process
+    struct ResourceTask : public MacroTaskBase {
+        void run(World& world, Cloud& cloud, taskqT& taskq) {}
+        void cleanup() {}
+    };
+    MacroTaskBase::taskqT vtask={std::make_shared<ResourceTask>(),std::make_shared<ResourceTask>()};
+    vtask[0]->resources.nproc=4;
+    vtask[1]->resources.memory=3.e9;
+    if (MacroTaskQ::optimal_nsubworld(vtask,16,1.e9)!=4) success++;
+    if (MacroTaskQ::optimal_nsubworld(vtask,2,1.e9)!=1) success++;
+    vtask[0]->set_complete();
+    if (MacroTaskQ::optimal_nsubworld(vtask,16,1.e9)!=5) success++;
+    if (MacroTaskQ::optimal_nsubworld(vtask,16,0.0)!=16) success++;
+    if (universe.rank()==0) print("optimal_nsubworld", (success==0) ? "passed" : "failed");
+
+    // a small taskq shrinks to a single subworld if the task asks for the whole universe
+    auto taskq = std::shared_ptr<MacroTaskQ>(new MacroTaskQ(universe, universe.size()));
+    taskq->set_adaptive_subworlds(true);
+    MicroTask t1;
+    t1.resources.nproc=universe.size();
+    MacroTask task(universe, t1, taskq);
+    std::vector<real_function_3d> f2a = task(v3[0], 2.0, v3);
+    taskq->run_all();
+    if (taskq->get_nsubworld()!=1) success++;
+    success+=check_vector(universe,ref,f2a,"test adaptive subworlds");
+    return success;
+}
+
 int main(int argc, char **argv) {
     madness::World &universe = madness::initialize(argc, argv);
     startup(universe, argc, argv);
@@ -273,6 +306,9 @@ int main(int argc, char **argv) {
         success+=test_2d_partitioning(universe,v3);
         timer1.tag("2D partitioning");
 
+        success+=test_adaptive_subworlds(universe,v3,ref);
+        timer1.tag("adaptive subworlds");
+
         if (universe.rank() == 0) {
             if (success==0) print("\n --> all tests \033[32m", "passed ", "\033[0m\n");
             else print("\n --> all tests \033[31m", "failed \033[0m \n");
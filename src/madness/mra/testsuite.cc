@@ -1171,6 +1171,53 @@ int test_plot(World& world) {
     }
     world.gop.fence();
 
+    if (NDIM <= 3) {
+        // the parallel VTK writer must reproduce the cube, with the first dimension fastest
+        Vector<long,NDIM> vnpt;
+        for (std::size_t d=0; d<NDIM; ++d) vnpt[d] = npt[d];
+        plotvti(f, "testplot.vti", "f", coordT(-L), coordT(L), vnpt);
+        if (world.rank() == 0) {
+            std::ifstream in("testplot.vti", std::ios::binary);
+            std::string s((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            const std::size_t start = s.find("encoding=\"raw\">\n   _") + 20;
+            uint64_t nbyte = 0;
+            std::memcpy(&nbyte, &s[start], sizeof(nbyte));
+            CHECK(double(nbyte) - double(r.size()*sizeof(T)), 0.5, "plotvti size");
+            const T* data = reinterpret_cast<const T*>(&s[start+sizeof(nbyte)]);
+            double err = 0.0;
+            for (IndexIterator it(npt); it; ++it) {
+                long index = 0, stride = 1;
+                for (std::size_t d=0; d<NDIM; ++d) {
+                    index += it[d]*stride;
+                    stride *= npt[d];
+                }
+                err = std::max(err, double(std::abs(data[index] - r(*it))));
+            }
+            // eval_cube puts a point on a box face into either neighbour, which
+            // differ by the local truncation error; a wrong layout gives O(1) errors
+            CHECK(err, 100.0*thresh, "plotvti");
+            CHECK(double(s.find("</VTKFile>", start+nbyte) == std::string::npos), 0.5, "plotvti footer");
+            std::remove("testplot.vti");
+        }
+        world.gop.fence();
+
+        // a cube reaching out of the cell is clipped, and so are its origin and spacing
+        plotvti(f, "testplot.vti", "f", coordT(-L), coordT(3.0*L), vnpt);
+        if (world.rank() == 0) {
+            std::ifstream in("testplot.vti", std::ios::binary);
+            std::string s((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            std::istringstream vorigin(s.substr(s.find("Origin=\"") + 8));
+            std::istringstream vspacing(s.substr(s.find("Spacing=\"") + 9));
+            double x0 = 0.0, h0 = 0.0;
+            vorigin >> x0;
+            vspacing >> h0;
+            CHECK(x0 + L, 1e-12*L, "plotvti clipped origin");
+            CHECK(h0 - 2.0*L/(npt[0]-1), 1e-12*L, "plotvti clipped spacing");
+            std::remove("testplot.vti");
+        }
+        world.gop.fence();
+    }
+
     r = Tensor<T>();
     plotdx(f, "testplot", FunctionDefaults<NDIM>::get_cell(), npt);
 
@@ -1183,6 +1230,72 @@ int test_plot(World& world) {
     return 1;
 }
 
+template <typename T, std::size_t NDIM>
+int test_mixed_precision(World& world) {
+    if (world.rank() == 0) {
+        print("\nTest mixed precision - type =", archive::get_type_name<T>(),", ndim =",NDIM,"\n");
+    }
+    bool ok=true;
+    typedef Vector<double,NDIM> coordT;
+    typedef std::shared_ptr< FunctionFunctorInterface<T,NDIM> > functorT;
+
+    const double thresh = 1e-8;
+    FunctionDefaults<NDIM>::set_k(8);
+    FunctionDefaults<NDIM>::set_thresh(thresh);
+    FunctionDefaults<NDIM>::set_truncate_mode(0);
+    FunctionDefaults<NDIM>::set_refine(true);
+    FunctionDefaults<NDIM>::set_initial_level(3);
+    FunctionDefaults<NDIM>::set_cubic_cell(-10,10);
+
+    const coordT origin(0.0);
+    const double expnt = 10.0;
+    const double coeff = pow(2.0/PI,0.25*NDIM);
+    functorT functor(new Gaussian<T,NDIM>(origin, expnt, coeff));
+    Function<T,NDIM> f = FunctionFactory<T,NDIM>(world).functor(functor);
+    f.truncate();
+    f.reconstruct();
+
+    // the error of each node is at most a tenth of its threshold
+    Function<T,NDIM> g = copy(f);
+    g.pack(0.1);
+    const double err = g.packing_error();
+    const double bound = 0.1*thresh*std::sqrt(double(f.tree_size()));
+    if (world.rank() == 0) print("packing error", err);
+    CHECK(err, bound, "packing error");
+    CHECK((err > 0.0) ? 0.0 : 1.0, 0.5, "nodes packed");
+
+    // read without unpacking
+    const double fnorm = f.norm2();
+    CHECK(g.norm2() - fnorm, err*1.01 + 1e-14, "norm2 of packed function");
+    CHECK(inner(f,g) - inner(f,f), fnorm*err*1.01 + 1e-14, "inner with packed function");
+    Function<T,NDIM> fg = f*g;
+    Function<T,NDIM> ff = f*f;
+    CHECK((fg-ff).norm2(), 10.0*thresh, "multiplication by packed function");
+
+    Tensor<double> coeffs(1), exponents(1);
+    exponents(0L) = 10.0;
+    coeffs(0L) = pow(exponents(0L)/PI, 0.5*NDIM);
+    SeparatedConvolution<T,NDIM> op(world, coeffs, exponents);
+    Function<T,NDIM> opg = madness::apply(op,g);
+    Function<T,NDIM> opf = madness::apply(op,f);
+    CHECK((opg-opf).norm2(), 10.0*thresh, "apply to packed function");
+
+    // in place operations unpack
+    g.unpack();
+    CHECK((g-f).norm2(), err*1.01 + 1e-14, "unpacked function");
+
+    FunctionDefaults<NDIM>::set_mixed_precision(0.1);
+    Function<T,NDIM> h = copy(f);
+    h.truncate();
+    FunctionDefaults<NDIM>::set_mixed_precision(0.0);
+    CHECK((h.packing_error() > 0.0) ? 0.0 : 1.0, 0.5, "nodes packed by truncate");
+    CHECK((h-f).norm2(), 10.0*thresh, "truncate with mixed precision");
+
+    world.gop.fence();
+    if (world.rank() == 0) print("test_mixed_precision",ok);
+    return (ok) ? 0 : 1;
+}
+
 template <typename T, std::size_t NDIM>
 int test_io(World& world) {
     if (world.rank() == 0) {
@@ -1222,6 +1335,65 @@ int test_io(World& world) {
     if (world.rank() == 0) print("err = ", err);
     CHECK(err,1e-12,"test_io");
 
+    // lossy storage bounds the error of each node by a fraction of its threshold
+    const double fraction = 0.1;
+    archive::ParallelOutputArchive<archive::BinaryFstreamOutputArchive> lossyout(world, "mary", nio);
+    lossyout.set_lossy_compression(fraction);
+    lossyout & f;
+    lossyout.close();
+
+    Function<T,NDIM> h;
+    archive::ParallelInputArchive<archive::BinaryFstreamInputArchive> lossyin(world, "mary", nio);
+    lossyin & h;
+    lossyin.close();
+    lossyin.remove();
+
+    err = (h-f).norm2();
+    const double bound = fraction*f.thresh()*std::sqrt(double(f.tree_size()));
+    if (world.rank() == 0) print("lossy err = ", err);
+    CHECK(err,bound,"test_io lossy");
+
+    // a vector of functions is saved in schema mode and read back through the mapping
+    {
+        std::vector< Function<T,NDIM> > v = {f, copy(f).scale(T(2.0))}, w;
+        save_function(v, "mary_schema");
+        load_function(world, w, "mary_schema");
+        archive::ParallelInputArchive<archive::BinaryFstreamInputArchive>::remove(world, "mary_schema");
+        MADNESS_CHECK(w.size() == v.size());
+        err = (w[0]-v[0]).norm2() + (w[1]-v[1]).norm2();
+        if (world.rank() == 0) print("schema err = ", err);
+        CHECK(err,1e-12,"test_io schema");
+    }
+
+#ifdef HAVE_HDF5
+    // nodes as HDF5 tables, read back in full and down to the initial level
+    {
+        archive::ParallelOutputArchive<archive::H5POutputArchive> h5out(world, "mary.h5");
+        h5out & f;
+    }
+    Function<T,NDIM> p;
+    {
+        archive::ParallelInputArchive<archive::H5PInputArchive> h5in(world, "mary.h5");
+        h5in & p;
+        const Level n = FunctionDefaults<NDIM>::get_initial_level();
+        long ntop = 0;
+        for (const auto& node : f.get_impl()->get_coeffs()) if (node.first.level() <= n) ++ntop;
+        world.gop.sum(ntop);
+        if (world.rank() == 0) {
+            archive::H5PInputArchive& h5 = h5in.local_archive();
+            std::size_t record = 0;
+            while (h5.kind(record) != "function") ++record;
+            const auto top = read_function_nodes<T,NDIM>(h5, record, select_nodes_to_level<NDIM>(n));
+            for (const auto& node : top) MADNESS_CHECK(node.first.level() <= n);
+            CHECK(double(top.size())-double(ntop),0.5,"test_io hdf5 partial read");
+        }
+    }
+    archive::ParallelOutputArchive<archive::H5POutputArchive>::remove(world, "mary.h5");
+    err = (p-f).norm2();
+    if (world.rank() == 0) print("hdf5 err = ", err);
+    CHECK(err,1e-12,"test_io hdf5");
+#endif
+
     //    MADNESS_CHECK(err == 0.0);
 
     if (world.rank() == 0) print("test_io OK");
@@ -1343,6 +1515,7 @@ int main(int argc, char**argv) {
         nfail+=test_plot<double,1>(world);
         nfail+=test_apply_push_1d<double,1>(world);
         nfail+=test_io<double,1>(world);
+        nfail+=test_mixed_precision<double,1>(world);
 
         // stupid location for this test
         GenericConvolution1D<double,GaussianGenericFunctor<double> > gen(10,GaussianGenericFunctor<double>(100.0,100.0),0);
@@ -1363,6 +1536,7 @@ int main(int argc, char**argv) {
         nfail+=test_op<double_complex,1>(world);
         nfail+=test_plot<double_complex,1>(world);
         nfail+=test_io<double_complex,1>(world);
+        nfail+=test_mixed_precision<double_complex,1>(world);
 
         //TaskInterface::debug = true;
         nfail+=test_basic<double,2>(world);
@@ -1372,6 +1546,7 @@ int main(int argc, char**argv) {
         nfail+=test_op<double,2>(world);
         nfail+=test_plot<double,2>(world);
         nfail+=test_io<double,2>(world);
+        nfail+=test_mixed_precision<double,2>(world);
 
         if (!smalltest) {
             nfail+=test_basic<double,3>(world);
@@ -245,6 +245,71 @@ void SVDTensor<T>::truncate_svd(const double& thresh) {
 }
 
 
+template<typename T>
+double SVDTensor<T>::orthonormalize_qr(const double& thresh) {
+
+	if (this->has_no_data() or rank()==0) return 0.0;
+
+	// this = X^T diag(w) Y, with X=Qx Rx and Y=Qy Ry
+	Tensor<T> qx=transpose(this->flat_vector(0));
+	Tensor<T> qy=transpose(this->flat_vector(1));
+	Tensor<T> rx, ry;
+	qr(qx,rx);
+	qr(qy,ry);
+
+	// the core Rx diag(w) Ry^T, at most (rank,rank)
+	for (long r=0; r<rank(); ++r) rx(_,r)*=T(this->weights_(r));
+	Tensor<T> core=inner(rx,ry,1,1);
+
+	typedef typename Tensor<T>::scalar_type scalar_type;
+	Tensor<T> U,VT;
+	Tensor<scalar_type> s;
+	svd(core,U,s,VT);
+
+	const long i=SRConf<T>::max_sigma(thresh,s.dim(0),s);
+	double discarded=0.0;
+	for (long j=i+1; j<s.dim(0); ++j) discarded+=s(j)*s(j);
+
+	if (i<0) {
+		SRConf<T> empty(this->ndim(),this->dims(),this->nci_left);
+		*this=SVDTensor<T>(empty);
+	} else {
+		const Slice s0(0,i);
+		Tensor<T> v0=inner(U(_,s0),qx,0,1);
+		Tensor<T> v1=inner(VT(s0,_),qy,1,1);
+		Tensor<scalar_type> weights=copy(s(s0));
+		this->set_vectors_and_weights(weights,v0,v1);
+	}
+	return sqrt(discarded);
+}
+
+template<typename T>
+void SVDTensorAccumulator<T>::add(const SVDTensor<T>& t) {
+	if (t.has_no_data() or t.rank()==0) return;
+	buffer.push_back(t);
+	if (long(buffer.size())>=nbuffer) {
+		const double eps=(thresh<0.0) ? -1.0 : fraction*std::max(thresh-error,0.0);
+		flush(eps);
+	}
+}
+
+template<typename T>
+SVDTensor<T> SVDTensorAccumulator<T>::finish() {
+	flush((thresh<0.0) ? -1.0 : std::max(thresh-error,0.0));
+	return sum;
+}
+
+template<typename T>
+void SVDTensorAccumulator<T>::flush(const double eps) {
+	if (buffer.empty()) return;
+	if (sum.has_data() and sum.rank()>0) buffer.push_front(sum);
+	SVDTensor<T> result=SVDTensor<T>::concatenate(buffer);
+	buffer.clear();
+	peak=std::max(peak,result.rank());
+	error+=result.orthonormalize_qr(eps);
+	sum=result;
+	++nreduction;
+}
 
 
 // explicit instantiation
@@ -253,5 +318,10 @@ template class SVDTensor<double>;
 template class SVDTensor<float_complex>;
 template class SVDTensor<double_complex>;
 
+template class SVDTensorAccumulator<float>;
+template class SVDTensorAccumulator<double>;
+template class SVDTensorAccumulator<float_complex>;
+template class SVDTensorAccumulator<double_complex>;
+
 } // namespace madness
 
@@ -37,6 +37,8 @@
 
 namespace madness{
 
+template<typename T> class SVDTensorAccumulator;
+
 
 template<typename T>
 class SVDTensor : public SRConf<T> {
@@ -152,6 +154,13 @@ public:
 
 	void truncate_svd(const double& thresh);
 
+	/// reduce the rank using QR decompositions of both vectors and an SVD of the small core
+
+	/// the result is orthonormal, as after orthonormalize(), but the vectors
+	/// need not be normalized on entry and no overlap matrices are squared
+	/// @return the Frobenius norm of the discarded part
+	double orthonormalize_qr(const double& thresh);
+
 	static std::string reduction_algorithm();
 	static void set_reduction_algorithm(const std::string alg);
 
@@ -189,6 +198,10 @@ public:
     		SVDTensor<T> result=SVDTensor<T>::concatenate(addends);
     		result.orthonormalize_random(eps);
     		return result;
+    	} else if (ref.reduction_algorithm()=="incremental") {
+    		SVDTensorAccumulator<T> acc(eps);
+    		for (auto& a : addends) acc.add(a);
+    		return acc.finish();
     	} else {
     		MADNESS_EXCEPTION("unknown reduction algorithm in SVDTensor.h",1);
     		return SVDTensor<T>();
@@ -203,6 +216,69 @@ public:
 
 };
 
+/// accumulates many low-rank addends into an SVDTensor of bounded rank
+
+/// Concatenating all addends and reducing the rank at the end lets the rank
+/// grow with the number of addends.  Here the addends are buffered until
+/// \c nbuffer of them have arrived, and then combined with the sum by
+/// SVDTensor::orthonormalize_qr(), so that the rank held never exceeds the
+/// rank of the sum plus the ranks of the buffered addends.
+///
+/// Each of these reductions may discard \c fraction of the error budget
+/// that is left, and finish() the remainder, so that the norm of all
+/// discarded parts stays below \c thresh.
+/// \code
+///   SVDTensorAccumulator<double> acc(args.thresh);
+///   for (const SVDTensor<double>& t : addends) acc.add(t);
+///   SVDTensor<double> sum=acc.finish();
+/// \endcode
+template<typename T>
+class SVDTensorAccumulator {
+public:
+
+	/// @param[in]	thresh		accuracy of the sum, or negative for no truncation
+	/// @param[in]	nbuffer		number of addends reduced together
+	/// @param[in]	fraction	fraction of the remaining error budget spent by each reduction
+	SVDTensorAccumulator(const double thresh, const long nbuffer=8, const double fraction=0.1)
+		: thresh(thresh), fraction(fraction), nbuffer(nbuffer) {
+		MADNESS_CHECK_THROW(nbuffer>0,"SVDTensorAccumulator needs a positive buffer size");
+		MADNESS_CHECK_THROW(fraction>0.0 and fraction<=1.0,"SVDTensorAccumulator: fraction must be in (0,1]");
+	}
+
+	/// add a tensor to the sum
+	void add(const SVDTensor<T>& t);
+
+	SVDTensorAccumulator& operator+=(const SVDTensor<T>& t) {
+		add(t);
+		return *this;
+	}
+
+	/// reduce the buffered addends and truncate the sum with the remaining error budget
+	SVDTensor<T> finish();
+
+	/// @return an upper bound for the norm of the parts discarded so far
+	double error_bound() const {return error;}
+
+	/// @return the largest rank held at any time
+	long peak_rank() const {return peak;}
+
+	/// @return the number of reductions done so far
+	long nreduce() const {return nreduction;}
+
+private:
+	/// reduce the buffered addends into the sum, discarding at most eps
+	void flush(const double eps);
+
+	double thresh;
+	double fraction;
+	long nbuffer;
+	SVDTensor<T> sum;					///< orthonormal sum of the reduced addends
+	std::list<SVDTensor<T> > buffer;	///< addends not yet reduced
+	double error=0.0;
+	long peak=0;
+	long nreduction=0;
+};
+
 template <typename R, typename Q>
 SVDTensor<TENSOR_RESULT_TYPE(R,Q)> transform(
 		const SVDTensor<R>& t, const Tensor<Q>& c) {
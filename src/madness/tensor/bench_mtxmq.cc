@@ -0,0 +1,130 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/// \file bench_mtxmq.cc
+/// \brief GFLOP/s of mTxmq at the shapes of MADNESS transforms
+
+/// Times c=a^T*b with dimi=k^(d-1), dimj=dimk=k or 2k for k=6..12 and d=3,4,
+/// in double and complex, with BLAS and with the kernels of every supported
+/// instruction set. Results are printed as JSON, to stdout or to the file
+/// given as first command line argument.
+///
+///     ./bench_mtxmq bench_mtxmq.json
+
+#include <madness/tensor/tensor.h>
+#include <madness/tensor/mtxmq_kernels.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace madness;
+
+namespace {
+
+    /// Best rate in GFLOP/s of mTxmq over a few repetitions of about 20ms
+    template <typename T>
+    double rate(long dimi, long dimj, long dimk, const std::vector<T>& a, const std::vector<T>& b, std::vector<T>& c) {
+        const double flop_per_op = TensorTypeData<T>::iscomplex ? 8.0 : 2.0;
+        const double nflop = flop_per_op*dimi*dimj*dimk;
+        long nloop = 1;
+        double best = 0.0;
+        for (int rep=0; rep<5; ++rep) {
+            double used = 0.0;
+            while (true) {
+                auto start = std::chrono::steady_clock::now();
+                for (long loop=0; loop<nloop; ++loop) mTxmq(dimi, dimj, dimk, c.data(), a.data(), b.data());
+                used = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if (used > 0.02) break;
+                nloop *= 2;
+            }
+            best = std::max(best, 1e-9*nflop*nloop/used);
+        }
+        return best;
+    }
+
+    template <typename T>
+    void bench(const char* type, std::vector<std::string>& records) {
+        std::vector<MtxmqISA> isas;
+        for (MtxmqISA isa : {MtxmqISA::BLAS, MtxmqISA::Generic, MtxmqISA::AVX2, MtxmqISA::AVX512}) {
+            if (mtxmq_isa_supported(isa)) isas.push_back(isa);
+        }
+        const MtxmqISA selected = mtxmq_isa();
+        for (long d=3; d<=4; ++d) {
+            for (long k=6; k<=12; ++k) {
+                for (long dimj : {k, 2*k}) {
+                    long dimi = 1;
+                    for (long i=1; i<d; ++i) dimi *= dimj;
+                    const long dimk = dimj;
+                    std::vector<T> a(dimk*dimi, T(0.5)), b(dimk*dimj, T(0.25)), c(dimi*dimj);
+                    std::ostringstream ss;
+                    ss.precision(4);
+                    ss << "    {\"type\": \"" << type << "\", \"dimi\": " << dimi << ", \"dimj\": " << dimj
+                       << ", \"dimk\": " << dimk << ", \"gflops\": {";
+                    for (std::size_t i=0; i<isas.size(); ++i) {
+                        set_mtxmq_isa(isas[i]);
+                        ss << (i ? ", " : "") << "\"" << mtxmq_isa_name(isas[i]) << "\": "
+                           << rate(dimi, dimj, dimk, a, b, c);
+                    }
+                    ss << "}}";
+                    records.push_back(ss.str());
+                }
+            }
+        }
+        set_mtxmq_isa(selected);
+    }
+
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> records;
+    bench<double>("double", records);
+    bench<double_complex>("double_complex", records);
+
+    std::ostringstream ss;
+    ss << "{\n  \"benchmark\": \"bench_mtxmq\",\n";
+    ss << "  \"selected\": \"" << mtxmq_isa_name(mtxmq_isa()) << "\",\n";
+    ss << "  \"results\": [\n";
+    for (std::size_t i=0; i<records.size(); ++i) {
+        ss << records[i] << ((i+1<records.size()) ? ",\n" : "\n");
+    }
+    ss << "  ]\n}\n";
+
+    if (argc > 1) {
+        std::ofstream out(argv[1]);
+        out << ss.str();
+    }
+    else {
+        std::cout << ss.str();
+    }
+    return 0;
+}
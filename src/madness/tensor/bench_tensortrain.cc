@@ -0,0 +1,174 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+/// \file bench_tensortrain.cc
+/// \brief Compares the tensor train and the SVD representation of 6D pair nodes
+
+/// For k=5..8 a correlation-like function of r12 is sampled on k^6 points and
+/// represented as TensorTrain (TT_TENSORTRAIN) and as SVDTensor (TT_2D). Times
+/// are the best of a few repetitions of: the decomposition of the full tensor,
+/// the reconstruction, and the rounded sum of three such nodes, for the tensor
+/// train both with gaxpy()+truncate() and with the randomized round_sum().
+/// Results are printed as JSON, to stdout or to the file given as first
+/// command line argument.
+///
+///     ./bench_tensortrain bench_tensortrain.json
+
+#include <madness/tensor/tensortrain.h>
+#include <madness/tensor/SVDTensor.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace madness;
+
+namespace {
+
+    /// Best wall time in seconds of f() over a few repetitions
+    template <typename funcT>
+    double seconds(funcT f) {
+        double best = 1.e10;
+        for (int rep=0; rep<3; ++rep) {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    /// Gaussian-fitted exp(-gamma*r12) displaced by x0, on the midpoints of k^6 cells of the unit box
+    Tensor<double> pair_node(long k, double gamma, double x0) {
+        const double c[3] = {0.3, 0.4, 0.3}, a[3] = {0.1, 0.5, 2.0};
+        Tensor<double> t(std::vector<long>(6,k));
+        double* p = t.ptr();
+        for (long i=0; i<t.size(); ++i) {
+            long idx = i;
+            double x[6];
+            for (int d=5; d>=0; --d) {
+                x[d] = (idx%k + 0.5)/k;
+                idx /= k;
+            }
+            double r2 = 0.0;
+            for (int d=0; d<3; ++d) r2 += (x[d]-x[d+3]-x0)*(x[d]-x[d+3]-x0);
+            double f = 0.0;
+            for (int g=0; g<3; ++g) f += c[g]*std::exp(-a[g]*gamma*gamma*r2);
+            p[i] = f;
+        }
+        return t;
+    }
+
+    long max_rank(const std::vector<long>& r) {
+        return r.empty() ? 0 : *std::max_element(r.begin(), r.end());
+    }
+
+    std::string record(long k, double eps) {
+        std::vector<Tensor<double> > full = {pair_node(k, 1.0, 0.0), pair_node(k, 1.5, 0.1), pair_node(k, 0.8, -0.1)};
+        full[2].scale(-0.5);
+        Tensor<double> sum = full[0] + full[1] + full[2];
+
+        // tensor train
+        std::vector<TensorTrain<double> > tt(3);
+        const double tt_decompose = seconds([&] {for (int i=0; i<3; ++i) tt[i] = TensorTrain<double>(full[i], eps);})/3;
+        Tensor<double> r;
+        const double tt_reconstruct = seconds([&] {r = tt[0].reconstruct();});
+        const double tt_error = (r - full[0]).normf();
+
+        TensorTrain<double> tt_sum;
+        const double tt_add = seconds([&] {
+            tt_sum = copy(tt[0]);
+            for (int i=1; i<3; ++i) tt_sum.gaxpy(1.0, tt[i], 1.0);
+            tt_sum.truncate(eps);
+        });
+        const double tt_add_error = (tt_sum.reconstruct() - sum).normf();
+        TensorTrain<double> tt_rsum;
+        const double tt_round_sum = seconds([&] {
+            tt_rsum = round_sum(tt, std::vector<double>(3, 1.0), eps);
+        });
+        const double tt_round_sum_error = (tt_rsum.reconstruct() - sum).normf();
+
+        // 2-way SVD
+        std::vector<SVDTensor<double> > svd(3);
+        const double svd_decompose = seconds([&] {for (int i=0; i<3; ++i) svd[i] = SVDTensor<double>(full[i], eps);})/3;
+        const double svd_reconstruct = seconds([&] {r = svd[0].reconstruct();});
+        const double svd_error = (r - full[0]).normf();
+
+        SVDTensor<double> svd_sum;
+        const double svd_add = seconds([&] {
+            svd_sum = copy(svd[0]);
+            for (int i=1; i<3; ++i) svd_sum.add_SVD(svd[i], eps);
+        });
+        const double svd_add_error = (svd_sum.reconstruct() - sum).normf();
+
+        std::ostringstream ss;
+        ss.precision(4);
+        ss << "    {\"k\": " << k << ", \"eps\": " << eps << ", \"full_size\": " << full[0].size() << ",\n"
+           << "     \"tt\": {\"size\": " << tt[0].size() << ", \"max_rank\": " << max_rank(tt[0].ranks())
+           << ", \"error\": " << tt_error << ", \"decompose\": " << tt_decompose
+           << ", \"reconstruct\": " << tt_reconstruct << ", \"add\": " << tt_add
+           << ", \"add_error\": " << tt_add_error << ", \"round_sum\": " << tt_round_sum
+           << ", \"round_sum_error\": " << tt_round_sum_error << ", \"sum_size\": " << tt_rsum.size() << "},\n"
+           << "     \"svd\": {\"size\": " << svd[0].nCoeff() << ", \"rank\": " << svd[0].rank()
+           << ", \"error\": " << svd_error << ", \"decompose\": " << svd_decompose
+           << ", \"reconstruct\": " << svd_reconstruct << ", \"add\": " << svd_add
+           << ", \"add_error\": " << svd_add_error << ", \"sum_size\": " << svd_sum.nCoeff() << "}}";
+        return ss.str();
+    }
+
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> records;
+    for (double eps : {1.e-3, 1.e-5}) {
+        for (long k=5; k<=8; ++k) records.push_back(record(k, eps));
+    }
+
+    std::ostringstream ss;
+    ss << "{\n  \"benchmark\": \"bench_tensortrain\",\n";
+    ss << "  \"results\": [\n";
+    for (std::size_t i=0; i<records.size(); ++i) {
+        ss << records[i] << ((i+1<records.size()) ? ",\n" : "\n");
+    }
+    ss << "  ]\n}\n";
+
+    if (argc > 1) {
+        std::ofstream out(argv[1]);
+        out << ss.str();
+    }
+    else {
+        std::cout << ss.str();
+    }
+    return 0;
+}
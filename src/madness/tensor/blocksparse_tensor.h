@@ -0,0 +1,324 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+#ifndef MADNESS_TENSOR_BLOCKSPARSE_TENSOR_H__INCLUDED
+#define MADNESS_TENSOR_BLOCKSPARSE_TENSOR_H__INCLUDED
+
+/// \file tensor/blocksparse_tensor.h
+/// \brief Tensors stored as a grid of dense blocks, with the small blocks screened away
+
+#include <madness/tensor/tensor.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace madness {
+
+    /// A tensor stored as a grid of dense blocks, of which only the significant ones are kept
+
+    /// Each dimension is divided into consecutive blocks, its tiling, and a
+    /// block is stored only if its Frobenius norm is at least the threshold.
+    /// Tensors over the indices of localized orbitals, like the exchange and
+    /// Fock matrices or the overlaps of the pair spaces in PNO-MP2, decay with
+    /// the distance of the orbitals, so that with the orbitals grouped by
+    /// locality most blocks are dropped.  In contractions the product of the
+    /// norms of two blocks bounds the norm of their contribution, and pairs
+    /// of blocks with a product below the threshold are skipped.
+    template <typename T>
+    class BlockSparseTensor {
+    public:
+        typedef std::vector<long> tilingT;      ///< Sizes of the blocks of one dimension
+        typedef std::vector<long> indexT;       ///< Index of a block
+        typedef std::map<indexT, Tensor<T> > mapT;
+
+    private:
+        std::vector<tilingT> tiling_;
+        std::vector<tilingT> offset_;           ///< First element of each block, followed by the dimension
+        mapT blocks_;
+        double thresh_=0.0;
+
+        void make_offsets() {
+            offset_.resize(tiling_.size());
+            for (std::size_t d=0; d<tiling_.size(); ++d) {
+                offset_[d].assign(1,0);
+                for (long n : tiling_[d]) {
+                    TENSOR_ASSERT(n > 0, "BlockSparseTensor: blocks must not be empty", n, 0);
+                    offset_[d].push_back(offset_[d].back()+n);
+                }
+            }
+        }
+
+    public:
+        BlockSparseTensor() = default;
+
+        /// A tensor with all blocks zero
+        BlockSparseTensor(const std::vector<tilingT>& tiling, double thresh)
+            : tiling_(tiling), thresh_(thresh) {
+            TENSOR_ASSERT(tiling.size() > 0 && tiling.size() <= TENSOR_MAXDIM,
+                          "BlockSparseTensor: invalid number of dimensions", tiling.size(), 0);
+            make_offsets();
+        }
+
+        /// Copies the blocks of a dense tensor with a norm of at least thresh
+        BlockSparseTensor(const Tensor<T>& t, const std::vector<tilingT>& tiling, double thresh)
+            : BlockSparseTensor(tiling, thresh) {
+            TENSOR_ASSERT(t.ndim() == ndim(), "BlockSparseTensor: tiling does not match the tensor", t.ndim(), &t);
+            for (long d=0; d<ndim(); ++d)
+                TENSOR_ASSERT(t.dim(d) == dim(d), "BlockSparseTensor: tiling does not match the tensor", d, &t);
+
+            indexT b(ndim(),0);
+            while (true) {
+                set_block(b, copy(t(block_slices(b))));
+                long d = ndim()-1;
+                while (d >= 0 && ++b[d] == nblock(d)) b[d--] = 0;
+                if (d < 0) break;
+            }
+        }
+
+        /// @return the tiling of n elements into blocks of blocksize, the last one may be smaller
+        static tilingT uniform_tiling(long n, long blocksize) {
+            tilingT tiling(n/blocksize, blocksize);
+            if (n%blocksize) tiling.push_back(n%blocksize);
+            return tiling;
+        }
+
+        long ndim() const {return tiling_.size();}
+
+        /// @return the number of elements in dimension d
+        long dim(long d) const {return offset_[d].back();}
+
+        /// @return the number of blocks in dimension d
+        long nblock(long d) const {return tiling_[d].size();}
+
+        const tilingT& tiling(long d) const {return tiling_[d];}
+
+        double thresh() const {return thresh_;}
+
+        /// @return the stored blocks, ordered by their index
+        const mapT& blocks() const {return blocks_;}
+
+        /// @return the number of stored elements
+        long nnz() const {
+            long n = 0;
+            for (const auto& b : blocks_) n += b.second.size();
+            return n;
+        }
+
+        bool has_block(const indexT& b) const {return blocks_.count(b) != 0;}
+
+        /// @return the block, or an empty tensor if it is not stored
+        Tensor<T> block(const indexT& b) const {
+            auto it = blocks_.find(b);
+            return (it == blocks_.end()) ? Tensor<T>() : it->second;
+        }
+
+        /// @return the dimensions of block b
+        std::vector<long> block_dims(const indexT& b) const {
+            std::vector<long> dims(ndim());
+            for (long d=0; d<ndim(); ++d) dims[d] = tiling_[d][b[d]];
+            return dims;
+        }
+
+        /// @return the slices of block b in the dense tensor
+        std::vector<Slice> block_slices(const indexT& b) const {
+            std::vector<Slice> s(ndim());
+            for (long d=0; d<ndim(); ++d) s[d] = Slice(offset_[d][b[d]], offset_[d][b[d]+1]-1);
+            return s;
+        }
+
+        /// @return the first element of block i in dimension d
+        long block_offset(long d, long i) const {return offset_[d][i];}
+
+        /// Stores a block if its norm is at least the threshold, else removes it
+        void set_block(const indexT& b, const Tensor<T>& t) {
+            TENSOR_ASSERT(long(b.size()) == ndim(), "BlockSparseTensor: invalid block index", b.size(), &t);
+            if (t.has_data() && t.normf() >= thresh_) {
+                TENSOR_ASSERT(t.ndim() == ndim() && t.iscontiguous(), "BlockSparseTensor: block must be contiguous", t.ndim(), &t);
+                for (long d=0; d<ndim(); ++d)
+                    TENSOR_ASSERT(t.dim(d) == tiling_[d][b[d]], "BlockSparseTensor: block has the wrong size", d, &t);
+                blocks_[b] = t;
+            }
+            else {
+                blocks_.erase(b);
+            }
+        }
+
+        /// @return the dense tensor
+        Tensor<T> full() const {
+            std::vector<long> dims(ndim());
+            for (long d=0; d<ndim(); ++d) dims[d] = dim(d);
+            Tensor<T> r(dims);
+            for (const auto& b : blocks_) r(block_slices(b.first)) = b.second;
+            return r;
+        }
+
+        double normf() const {
+            double sum = 0.0;
+            for (const auto& b : blocks_) sum += std::pow(double(b.second.normf()),2);
+            return std::sqrt(sum);
+        }
+
+        /// Removes the blocks with a norm below thresh, which becomes the threshold
+        void truncate(double thresh) {
+            thresh_ = thresh;
+            for (auto it=blocks_.begin(); it!=blocks_.end(); ) {
+                if (it->second.normf() < thresh) it = blocks_.erase(it);
+                else ++it;
+            }
+        }
+
+        /// @return the index pairs (i,j) of a matrix with |a(i,j)| >= thresh, in ascending order
+
+        /// Only the stored blocks are searched, e.g. the pairs of localized
+        /// orbitals i and j with a significant exchange or overlap.
+        std::vector< std::pair<long,long> > pairs(double thresh) const {
+            TENSOR_ASSERT(ndim() == 2, "BlockSparseTensor: pairs requires a matrix", ndim(), 0);
+            std::vector< std::pair<long,long> > ij;
+            for (const auto& b : blocks_) {
+                const Tensor<T>& t = b.second;
+                const long i0 = offset_[0][b.first[0]], j0 = offset_[1][b.first[1]];
+                for (long i=0; i<t.dim(0); ++i)
+                    for (long j=0; j<t.dim(1); ++j)
+                        if (std::abs(t(i,j)) >= thresh) ij.push_back(std::make_pair(i0+i,j0+j));
+            }
+            std::sort(ij.begin(), ij.end());
+            return ij;
+        }
+    };
+
+    /// Contraction of two block-sparse tensors, as inner() of dense tensors
+
+    /// The contracted dimensions must have the same tiling, the result has the
+    /// tiling of the remaining dimensions and the threshold of left.
+    template <typename T>
+    BlockSparseTensor<T> inner(const BlockSparseTensor<T>& left, const BlockSparseTensor<T>& right,
+                               long k0=-1, long k1=0) {
+        typedef typename BlockSparseTensor<T>::indexT indexT;
+        if (k0 < 0) k0 += left.ndim();
+        if (k1 < 0) k1 += right.ndim();
+        const long nd = left.ndim() + right.ndim() - 2;
+        TENSOR_ASSERT(nd > 0 && nd <= TENSOR_MAXDIM, "invalid number of dimensions in the result", nd, 0);
+        TENSOR_ASSERT(left.tiling(k0) == right.tiling(k1), "common index must have the same tiling", k1, 0);
+
+        std::vector<typename BlockSparseTensor<T>::tilingT> tiling;
+        for (long d=0; d<left.ndim(); ++d) if (d != k0) tiling.push_back(left.tiling(d));
+        for (long d=0; d<right.ndim(); ++d) if (d != k1) tiling.push_back(right.tiling(d));
+
+        // the blocks of right with their norms, by their index in the contracted dimension
+        typedef std::pair<const typename BlockSparseTensor<T>::mapT::value_type*, double> blockT;
+        std::vector< std::vector<blockT> > rblocks(right.nblock(k1));
+        for (const auto& b : right.blocks())
+            rblocks[b.first[k1]].push_back(blockT(&b, b.second.normf()));
+
+        std::map<indexT, Tensor<T> > sum;
+        for (const auto& a : left.blocks()) {
+            const double anorm = a.second.normf();
+            indexT ij;
+            for (long d=0; d<left.ndim(); ++d) if (d != k0) ij.push_back(a.first[d]);
+            const long nleft = ij.size();
+            for (const blockT& b : rblocks[a.first[k0]]) {
+                if (anorm*b.second < left.thresh()) continue;
+                ij.resize(nleft);
+                for (long d=0; d<right.ndim(); ++d) if (d != k1) ij.push_back(b.first->first[d]);
+                Tensor<T>& r = sum[ij];
+                if (!r.has_data()) {
+                    std::vector<long> dims(nd);
+                    for (long d=0; d<nd; ++d) dims[d] = tiling[d][ij[d]];
+                    r = Tensor<T>(dims);
+                }
+                inner_result(a.second, b.first->second, k0, k1, r);
+            }
+        }
+
+        BlockSparseTensor<T> result(tiling, left.thresh());
+        for (const auto& r : sum) result.set_block(r.first, r.second);
+        return result;
+    }
+
+    /// Contraction of a block-sparse and a dense tensor, as inner() of dense tensors
+    template <typename T>
+    Tensor<T> inner(const BlockSparseTensor<T>& left, const Tensor<T>& right, long k0=-1, long k1=0) {
+        if (k0 < 0) k0 += left.ndim();
+        if (k1 < 0) k1 += right.ndim();
+        const long nd = left.ndim() + right.ndim() - 2;
+        TENSOR_ASSERT(nd > 0 && nd <= TENSOR_MAXDIM, "invalid number of dimensions in the result", nd, 0);
+        TENSOR_ASSERT(left.dim(k0) == right.dim(k1), "common index must be same length", right.dim(k1), &right);
+
+        std::vector<long> dims;
+        for (long d=0; d<left.ndim(); ++d) if (d != k0) dims.push_back(left.dim(d));
+        for (long d=0; d<right.ndim(); ++d) if (d != k1) dims.push_back(right.dim(d));
+        Tensor<T> result(dims);
+
+        // each block multiplies the slice of right in its range of the contracted index
+        std::vector<Slice> rs(right.ndim(), _);
+        for (const auto& a : left.blocks()) {
+            const std::vector<Slice> as = left.block_slices(a.first);
+            rs[k1] = as[k0];
+            std::vector<Slice> s;
+            for (long d=0; d<left.ndim(); ++d) if (d != k0) s.push_back(as[d]);
+            for (long d=0; d<right.ndim(); ++d) if (d != k1) s.push_back(_);
+            result(s) += inner(a.second, right(rs), k0, k1);
+        }
+        return result;
+    }
+
+    /// Contraction of a dense and a block-sparse tensor, as inner() of dense tensors
+    template <typename T>
+    Tensor<T> inner(const Tensor<T>& left, const BlockSparseTensor<T>& right, long k0=-1, long k1=0) {
+        if (k0 < 0) k0 += left.ndim();
+        if (k1 < 0) k1 += right.ndim();
+        const long nd = left.ndim() + right.ndim() - 2;
+        TENSOR_ASSERT(nd > 0 && nd <= TENSOR_MAXDIM, "invalid number of dimensions in the result", nd, 0);
+        TENSOR_ASSERT(left.dim(k0) == right.dim(k1), "common index must be same length", left.dim(k0), &left);
+
+        std::vector<long> dims;
+        for (long d=0; d<left.ndim(); ++d) if (d != k0) dims.push_back(left.dim(d));
+        for (long d=0; d<right.ndim(); ++d) if (d != k1) dims.push_back(right.dim(d));
+        Tensor<T> result(dims);
+
+        std::vector<Slice> ls(left.ndim(), _);
+        for (const auto& b : right.blocks()) {
+            const std::vector<Slice> bs = right.block_slices(b.first);
+            ls[k0] = bs[k1];
+            std::vector<Slice> s;
+            for (long d=0; d<left.ndim(); ++d) if (d != k0) s.push_back(_);
+            for (long d=0; d<right.ndim(); ++d) if (d != k1) s.push_back(bs[d]);
+            result(s) += inner(left(ls), b.second, k0, k1);
+        }
+        return result;
+    }
+
+}
+
+#endif // MADNESS_TENSOR_BLOCKSPARSE_TENSOR_H__INCLUDED
@@ -44,6 +44,12 @@ using std::endl;
 using std::min;
 using std::max;
 
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <numeric>
+#include <thread>
+
 /// \file lapack.cc
 /// \brief Partial interface from Tensor to LAPACK
 
@@ -607,6 +613,42 @@ namespace madness {
         if ( (info&0xffffffff) == 0) info = 0;
     }
 
+    /// Matrices up to this number of elements use the workspace of the calling thread
+    static const long LAPACK_SMALL_SIZE = 64*64;
+
+    /// @return the workspace of the calling thread for small matrices
+    template <typename T>
+    static LapackWorkspace<T>& thread_workspace() {
+        thread_local LapackWorkspace<T> ws;
+        return ws;
+    }
+
+    /// copies the matrix a, or its transpose, into contiguous memory
+    template <typename T>
+    static void copy_matrix(const Tensor<T>& a, T* p, bool trans) {
+        const long m = a.dim(0), n = a.dim(1);
+        if (!trans && a.iscontiguous()) {
+            std::copy(a.ptr(), a.ptr()+m*n, p);
+        }
+        else if (trans) {
+            for (long i=0; i<m; ++i)
+                for (long j=0; j<n; ++j) p[j*m+i] = a(i,j);
+        }
+        else {
+            for (long i=0; i<m; ++i)
+                for (long j=0; j<n; ++j) p[i*n+j] = a(i,j);
+        }
+    }
+
+    /// @return the (m,n) matrix of which p holds the transpose
+    template <typename T>
+    static Tensor<T> transpose_from(const T* p, long m, long n) {
+        Tensor<T> r(m,n);
+        for (long i=0; i<m; ++i)
+            for (long j=0; j<n; ++j) r(i,j) = p[j*m+i];
+        return r;
+    }
+
     /** \brief   Compute the singluar value decomposition of an n-by-m matrix using *gesvd.
 
     Returns via arguments U, s, VT where
@@ -626,27 +668,162 @@ namespace madness {
     template <typename T>
     void svd(const Tensor<T>& a, Tensor<T>& U,
              Tensor< typename Tensor<T>::scalar_type >& s, Tensor<T>& VT) {
+        if (a.size() <= LAPACK_SMALL_SIZE) return svd(a,U,s,VT,thread_workspace<T>());
+        LapackWorkspace<T> ws;
+        svd(a,U,s,VT,ws);
+    }
+
+    template <typename T>
+    void svd(const Tensor<T>& a, Tensor<T>& U,
+             Tensor< typename Tensor<T>::scalar_type >& s, Tensor<T>& VT,
+             LapackWorkspace<T>& ws) {
         TENSOR_ASSERT(a.ndim() == 2, "svd requires matrix",a.ndim(),&a);
         integer m = a.dim(0), n = a.dim(1), rmax = min<integer>(m,n);
         integer lwork = max<integer>(3*min(m,n)+max(m,n),5*min(m,n)-4)*32;
         integer info;
-        Tensor<T> A(copy(a)), work(lwork);
+        T* A = ws.a(m*n);
+        copy_matrix(a,A,false);
 
         s = Tensor< typename Tensor<T>::scalar_type >(rmax);
         U = Tensor<T>(m,rmax);
         VT = Tensor<T>(rmax,n);
-        dgesvd_("S","S", &n, &m, A.ptr(), &n, s.ptr(),
-                VT.ptr(), &n, U.ptr(), &rmax, work.ptr(), &lwork,
+        dgesvd_("S","S", &n, &m, A, &n, s.ptr(),
+                VT.ptr(), &n, U.ptr(), &rmax, ws.work(lwork), &lwork,
                 &info, (char_len) 1, (char_len) 1);
 
-        //std::cout << "n " << n << " m " << m << " lwork " << lwork << std::endl;
-	//std::cout << sizeof(long) << " " << sizeof(int) << " " << sizeof(integer) << std::endl;
-	//std::cout << sizeof(real4) << " " << sizeof(float)  << std::endl;
         mask_info(info);
 
         TENSOR_ASSERT(info == 0, "svd: Lapack failed", info, &a);
     }
 
+    /// complex conjugate that leaves real numbers real
+    static inline float jacobi_conj(float x) {return x;}
+    static inline double jacobi_conj(double x) {return x;}
+    static inline float_complex jacobi_conj(const float_complex& x) {return std::conj(x);}
+    static inline double_complex jacobi_conj(const double_complex& x) {return std::conj(x);}
+
+    /// x <- c*x - s*ph*y, y <- s*x + c*ph*y for vectors of length n
+    template <typename T, typename scalar_type>
+    static inline void jacobi_rotate(T* x, T* y, long n, scalar_type c, scalar_type s, const T& ph) {
+        for (long i=0; i<n; ++i) {
+            const T xi = x[i], yi = y[i]*ph;
+            x[i] = c*xi - s*yi;
+            y[i] = s*xi + c*yi;
+        }
+    }
+
+    template <typename T>
+    void svd_jacobi(const Tensor<T>& a, Tensor<T>& U,
+                    Tensor< typename Tensor<T>::scalar_type >& s, Tensor<T>& VT,
+                    LapackWorkspace<T>& ws) {
+        typedef typename Tensor<T>::scalar_type scalar_type;
+        TENSOR_ASSERT(a.ndim() == 2, "svd requires matrix",a.ndim(),&a);
+        const long m = a.dim(0), n = a.dim(1);
+
+        // the rows of g are the p columns of a, or of its adjoint if a is wide,
+        // and the rows of v are the columns of the accumulated rotation
+        const bool tall = (m >= n);
+        const long p = tall ? n : m, len = tall ? m : n;
+        T* g = ws.a(p*len);
+        T* v = ws.work(p*p);
+        copy_matrix(a,g,tall);
+        if (!tall) for (long i=0; i<p*len; ++i) g[i] = jacobi_conj(g[i]);
+        std::fill(v,v+p*p,T(0));
+        for (long j=0; j<p; ++j) v[j*p+j] = T(1);
+
+        // squared norms of the columns, recomputed after each sweep
+        std::vector<scalar_type> sigma(p);
+        auto column_norms = [&]() {
+            for (long j=0; j<p; ++j) {
+                scalar_type sum = 0;
+                for (long i=0; i<len; ++i) sum += std::real(jacobi_conj(g[j*len+i])*g[j*len+i]);
+                sigma[j] = sum;
+            }
+        };
+
+        // sweep over all pairs until the columns are orthogonal
+        const scalar_type tol = std::numeric_limits<scalar_type>::epsilon()*len;
+        column_norms();
+        for (int sweep=0; sweep<60; ++sweep) {
+            bool rotated = false;
+            for (long j=0; j<p-1; ++j) {
+                for (long k=j+1; k<p; ++k) {
+                    T* gj = g+j*len;
+                    T* gk = g+k*len;
+                    T gamma = 0;
+                    for (long i=0; i<len; ++i) gamma += jacobi_conj(gj[i])*gk[i];
+                    const scalar_type alpha = sigma[j], beta = sigma[k];
+                    const scalar_type agamma = std::abs(gamma);
+                    if (agamma <= tol*std::sqrt(alpha)*std::sqrt(beta)) continue;
+                    rotated = true;
+
+                    // the phase makes the off-diagonal element real, then
+                    // the rotation angle is that of the real 2x2 problem
+                    const T ph = jacobi_conj(T(gamma/agamma));
+                    const scalar_type zeta = (beta-alpha)/(2*agamma);
+                    const scalar_type t = (zeta >= 0 ? 1 : -1)/(std::abs(zeta) + std::sqrt(1 + zeta*zeta));
+                    const scalar_type c = 1/std::sqrt(1 + t*t), sn = c*t;
+                    jacobi_rotate(gj, gk, len, c, sn, ph);
+                    jacobi_rotate(v+j*p, v+k*p, p, c, sn, ph);
+                    sigma[j] = alpha - t*agamma;
+                    sigma[k] = beta + t*agamma;
+                }
+            }
+            column_norms();
+            if (!rotated) break;
+        }
+
+        // the singular values are the norms of the columns, in descending order
+        std::vector<long> perm(p);
+        for (long j=0; j<p; ++j) sigma[j] = std::sqrt(sigma[j]);
+        std::iota(perm.begin(), perm.end(), 0);
+        std::stable_sort(perm.begin(), perm.end(), [&sigma](long i, long j) {return sigma[i] > sigma[j];});
+
+        // normalized columns, a zero column is replaced by a unit vector
+        // orthogonal to the previous ones
+        Tensor<T> q(p,len);
+        s = Tensor<scalar_type>(p);
+        for (long k=0; k<p; ++k) {
+            const long j = perm[k];
+            s(k) = sigma[j];
+            if (sigma[j] > std::numeric_limits<scalar_type>::min()) {
+                const scalar_type rnorm = 1/sigma[j];
+                for (long i=0; i<len; ++i) q(k,i) = g[j*len+i]*rnorm;
+                continue;
+            }
+            for (long e=0; e<len; ++e) {
+                Tensor<T> u(len);
+                u(e) = T(1);
+                for (int pass=0; pass<2; ++pass) {
+                    for (long l=0; l<k; ++l) {
+                        T ov = 0;
+                        for (long i=0; i<len; ++i) ov += jacobi_conj(q(l,i))*u(i);
+                        for (long i=0; i<len; ++i) u(i) -= ov*q(l,i);
+                    }
+                }
+                const scalar_type unorm = u.normf();
+                if (unorm > 0.5) {
+                    for (long i=0; i<len; ++i) q(k,i) = u(i)/unorm;
+                    break;
+                }
+            }
+        }
+
+        U = Tensor<T>(m,p);
+        VT = Tensor<T>(p,n);
+        for (long k=0; k<p; ++k) {
+            const T* vk = v+perm[k]*p;
+            if (tall) {
+                for (long i=0; i<m; ++i) U(i,k) = q(k,i);
+                for (long j=0; j<n; ++j) VT(k,j) = jacobi_conj(vk[j]);
+            }
+            else {
+                for (long i=0; i<m; ++i) U(i,k) = vk[i];
+                for (long j=0; j<n; ++j) VT(k,j) = jacobi_conj(q(k,j));
+            }
+        }
+    }
+
     /// same as svd, but it optimizes away the tensor construction: a = U * diag(s) * VT
 
     /// note that S and VT are swapped in the calling list for c/fortran consistency!
@@ -690,24 +867,33 @@ namespace madness {
     */
     template <typename T>
     void gesv(const Tensor<T>& a, const Tensor<T>& b, Tensor<T>& x) {
+        if (a.size() <= LAPACK_SMALL_SIZE) return gesv(a,b,x,thread_workspace<T>());
+        LapackWorkspace<T> ws;
+        gesv(a,b,x,ws);
+    }
+
+    template <typename T>
+    void gesv(const Tensor<T>& a, const Tensor<T>& b, Tensor<T>& x,
+              LapackWorkspace<T>& ws) {
         TENSOR_ASSERT(a.ndim() == 2, "gesv requires matrix",a.ndim(),&a);
-        integer n = a.dim(0), m = a.dim(1), nrhs = b.dim(1);
-        TENSOR_ASSERT(m == n, "gesv requires square matrix",0,&a);
         TENSOR_ASSERT(b.ndim() <= 2, "gesv require a vector or matrix for the RHS",b.ndim(),&b);
+        integer n = a.dim(0), m = a.dim(1), nrhs = (b.ndim() == 1) ? 1 : b.dim(1);
+        TENSOR_ASSERT(m == n, "gesv requires square matrix",0,&a);
         TENSOR_ASSERT(a.dim(0) == b.dim(0), "gesv matrix and RHS must conform",b.ndim(),&b);
 
         // The input matrix & vectors are destroyed by gesv and we also need Fortran order
-        Tensor<T> AT = transpose(a);
+        T* AT = ws.a(n*n);
+        copy_matrix(a,AT,true);
         if (b.ndim() == 1)
             x = copy(b);
         else
             x = transpose(b);
 
-        Tensor<integer> piv(n);
+        integer* piv = ws.iwork(n);
         integer info;
 
         // note overriding of dgesv for other types above
-        dgesv_(&n, &nrhs, AT.ptr(), &n, piv.ptr(), x.ptr(), &n, &info);
+        dgesv_(&n, &nrhs, AT, &n, piv, x.ptr(), &n, &info);
         mask_info(info);
 
         TENSOR_ASSERT((info == 0), "gesv failed", info, &a);
@@ -856,20 +1042,28 @@ namespace madness {
     template <typename T>
     void syev(const Tensor<T>& A,
               Tensor<T>& V, Tensor< typename Tensor<T>::scalar_type >& e) {
+        if (A.size() <= LAPACK_SMALL_SIZE) return syev(A,V,e,thread_workspace<T>());
+        LapackWorkspace<T> ws;
+        syev(A,V,e,ws);
+    }
+
+    template <typename T>
+    void syev(const Tensor<T>& A, Tensor<T>& V,
+              Tensor< typename Tensor<T>::scalar_type >& e, LapackWorkspace<T>& ws) {
         TENSOR_ASSERT(A.ndim() == 2, "syev requires a matrix",A.ndim(),&A);
         TENSOR_ASSERT(A.dim(0) == A.dim(1), "syev requires square matrix",0,&A);
         integer n = A.dim(0);
         integer lwork = max(max((integer) 1,(integer) (3*n-1)),(integer) (34*n));
         integer info;
-        Tensor<T> work(lwork);
-        V = transpose(A);		// For Hermitian case
+        T* VT = ws.a(n*n);
+        copy_matrix(A,VT,true);		// For Hermitian case
         e = Tensor<typename Tensor<T>::scalar_type>(n);
-        dsyev_("V", "U", &n, V.ptr(), &n, e.ptr(), work.ptr(), &lwork, &info,
+        dsyev_("V", "U", &n, VT, &n, e.ptr(), ws.work(lwork), &lwork, &info,
                (char_len) 1, (char_len) 1);
 
         mask_info(info);
         TENSOR_ASSERT(info == 0, "(s/d)syev/(c/z)heev failed", info, &A);
-        V = transpose(V);
+        V = transpose_from(VT,n,n);
     }
 // bryan edits
     /** \brief   Real non-symmetric or complex non-Hermitian eigenproblem.
@@ -1123,18 +1317,110 @@ namespace madness {
     */
     template<typename T>
     void geqp3(Tensor<T>& A, Tensor<T>& tau, Tensor<integer>& jpvt) {
+    	LapackWorkspace<T> ws;
+    	geqp3(A,tau,jpvt,ws);
+    }
 
+    template<typename T>
+    void geqp3(Tensor<T>& A, Tensor<T>& tau, Tensor<integer>& jpvt,
+    		LapackWorkspace<T>& ws) {
     	TENSOR_ASSERT(A.ndim() == 2, "geqp requires a matrix",A.ndim(),&A);
 
-    	A=transpose(A);
     	integer m=A.dim(0);
     	integer n=A.dim(1);
-    	jpvt=Tensor<integer>(n);
-    	tau=Tensor<T>(std::min(n,m));
     	integer lwork=2*n+(n+1)*64;
-    	Tensor<T> work(lwork);
-    	geqp3_result(A,tau,jpvt,work);
-    	A=transpose(A);
+    	integer info;
+    	T* AT=ws.a(m*n);
+    	copy_matrix(A,AT,true);
+    	jpvt=Tensor<integer>(n);	// zero marks all columns as free
+    	tau=Tensor<T>(std::min(n,m));
+    	dgeqp3_(&m, &n, AT, &m, jpvt.ptr(), tau.ptr(), ws.work(lwork),
+    			&lwork, &info);
+    	mask_info(info);
+    	TENSOR_ASSERT(info == 0, "dgeqp3: Lapack failed", info, &A);
+    	A=transpose_from(AT,m,n);
+    }
+
+    /// calls op(i,ws) for i in [0,n) on nthread threads, each with its own workspace
+    template <typename T, typename opT>
+    static void lapack_batch(long n, int nthread, const opT& op) {
+        nthread = std::max(1,int(std::min<long>(nthread,n)));
+        if (nthread == 1) {
+            LapackWorkspace<T> ws;
+            for (long i=0; i<n; ++i) op(i,ws);
+            return;
+        }
+
+        // the matrices are handed out one by one since their sizes may differ
+        std::atomic<long> next(0);
+        std::vector<std::exception_ptr> error(nthread);
+        auto worker = [&](int id) {
+            LapackWorkspace<T> ws;
+            try {
+                for (long i=next++; i<n; i=next++) op(i,ws);
+            }
+            catch (...) {
+                error[id] = std::current_exception();
+                next = n;
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int id=1; id<nthread; ++id) threads.emplace_back(worker,id);
+        worker(0);
+        for (std::thread& t : threads) t.join();
+        for (std::exception_ptr& e : error)
+            if (e) std::rethrow_exception(e);
+    }
+
+    template <typename T>
+    void svd_batched(const std::vector< Tensor<T> >& a, std::vector< Tensor<T> >& U,
+                     std::vector< Tensor< typename Tensor<T>::scalar_type > >& s,
+                     std::vector< Tensor<T> >& VT, int nthread) {
+        const long n = a.size();
+        U.resize(n);
+        s.resize(n);
+        VT.resize(n);
+        lapack_batch<T>(n, nthread, [&](long i, LapackWorkspace<T>& ws) {
+            if (a[i].ndim() == 2 && std::min(a[i].dim(0),a[i].dim(1)) <= SVD_JACOBI_MAXDIM
+                && std::max(a[i].dim(0),a[i].dim(1)) <= SVD_JACOBI_MAXLEN)
+                svd_jacobi(a[i],U[i],s[i],VT[i],ws);
+            else
+                svd(a[i],U[i],s[i],VT[i],ws);
+        });
+    }
+
+    template <typename T>
+    void syev_batched(const std::vector< Tensor<T> >& A, std::vector< Tensor<T> >& V,
+                      std::vector< Tensor< typename Tensor<T>::scalar_type > >& e,
+                      int nthread) {
+        const long n = A.size();
+        V.resize(n);
+        e.resize(n);
+        lapack_batch<T>(n, nthread, [&](long i, LapackWorkspace<T>& ws) {
+            syev(A[i],V[i],e[i],ws);
+        });
+    }
+
+    template <typename T>
+    void gesv_batched(const std::vector< Tensor<T> >& a, const std::vector< Tensor<T> >& b,
+                      std::vector< Tensor<T> >& x, int nthread) {
+        TENSOR_ASSERT(a.size() == b.size(), "gesv_batched: need one right-hand side per matrix", b.size(), 0);
+        const long n = a.size();
+        x.resize(n);
+        lapack_batch<T>(n, nthread, [&](long i, LapackWorkspace<T>& ws) {
+            gesv(a[i],b[i],x[i],ws);
+        });
+    }
+
+    template <typename T>
+    void geqp3_batched(std::vector< Tensor<T> >& A, std::vector< Tensor<T> >& tau,
+                       std::vector< Tensor<integer> >& jpvt, int nthread) {
+        const long n = A.size();
+        tau.resize(n);
+        jpvt.resize(n);
+        lapack_batch<T>(n, nthread, [&](long i, LapackWorkspace<T>& ws) {
+            geqp3(A[i],tau[i],jpvt[i],ws);
+        });
     }
 
     template<typename T>
@@ -1336,6 +1622,102 @@ namespace madness {
         return b.absmax();
     }
 
+    /// @return the deviation of the columns of U from orthonormality
+    template <typename T>
+    double orthonormality_error(const Tensor<T>& U) {
+        Tensor<T> S = inner(my_conj_transpose(U),U);
+        for (long i=0; i<S.dim(0); ++i) S(i,i) -= T(1);
+        return S.absmax();
+    }
+
+    /// Test of the Jacobi SVD against LAPACK for a matrix with a zero singular value
+    template <typename T>
+    double test_svd_jacobi(int n, int m) {
+        typedef typename TensorTypeData<T>::scalar_type scalar_type;
+        Tensor<T> a(n,m), U, VT, U0, VT0;
+        Tensor<scalar_type> s, s0;
+        a.fillrandom();
+        if (n >= m) a(_,m-1) = a(_,0);
+        else a(n-1,_) = a(0,_);
+
+        svd_jacobi(a,U,s,VT);
+        svd(a,U0,s0,VT0);
+
+        Tensor<T> b(n,m);
+        for (long i=0; i<n; ++i)
+            for (long j=0; j<m; ++j)
+                for (long k=0; k<s.dim(0); ++k)
+                    b(i,j) += U(i,k) * T(s(k)) * VT(k,j);
+        b -= a;
+
+        return b.absmax() + (s-s0).absmax() + orthonormality_error(U)
+            + orthonormality_error(my_conj_transpose(VT));
+    }
+
+    /// Test of the batched routines against the single-matrix ones
+    template <typename T>
+    double test_batched(int nmat, int nthread) {
+        typedef typename TensorTypeData<T>::scalar_type scalar_type;
+        std::vector< Tensor<T> > a(nmat), h(nmat), b(nmat), U, VT, V, x;
+        std::vector< Tensor<scalar_type> > s, e;
+        for (int i=0; i<nmat; ++i) {
+            const long n = 2 + (i*7)%31, m = 1 + (i*5)%23;
+            a[i] = Tensor<T>(n,m);
+            a[i].fillrandom();
+            h[i] = Tensor<T>(n,n);
+            h[i].fillrandom();
+            h[i] += my_conj_transpose(h[i]);
+            for (long j=0; j<n; ++j) h[i](j,j) += T(n);
+            b[i] = Tensor<T>(n,i%3+1);
+            b[i].fillrandom();
+        }
+
+        svd_batched(a,U,s,VT,nthread);
+        syev_batched(h,V,e,nthread);
+        gesv_batched(h,b,x,nthread);
+
+        double err = 0.0;
+        for (int i=0; i<nmat; ++i) {
+            Tensor<T> U0, VT0, V0, x0;
+            Tensor<scalar_type> s0, e0;
+            svd(a[i],U0,s0,VT0);
+            syev(h[i],V0,e0);
+            gesv(h[i],b[i],x0);
+            Tensor<T> us = copy(U[i]);
+            for (long k=0; k<s[i].dim(0); ++k) us(_,k) *= T(s[i](k));
+            err = max(err, (double) (inner(us,VT[i]) - a[i]).absmax());
+            err = max(err, (double) (s[i]-s0).absmax());
+            err = max(err, (double) (e[i]-e0).absmax());
+            err = max(err, (double) (x[i]-x0).absmax());
+            for (long k=0; k<e[i].dim(0); ++k)
+                err = max(err, (double) (inner(h[i],V[i](_,k)) - V[i](_,k)*T(e[i](k))).absmax()/h[i].dim(0));
+        }
+        return err;
+    }
+
+    /// Test of the batched pivoted QR: since Q is orthogonal, (AP)^T AP = R^T R
+    double test_geqp3_batched(int nmat, int nthread) {
+        std::vector< Tensor<double> > a(nmat), qr(nmat), tau;
+        std::vector< Tensor<integer> > jpvt;
+        for (int i=0; i<nmat; ++i) {
+            a[i] = Tensor<double>(3 + (i*7)%17, 2 + (i*3)%11);
+            a[i].fillrandom();
+            qr[i] = copy(a[i]);
+        }
+        geqp3_batched(qr,tau,jpvt,nthread);
+
+        double err = 0.0;
+        for (int i=0; i<nmat; ++i) {
+            const long m = a[i].dim(0), n = a[i].dim(1);
+            Tensor<double> ap(m,n), r(std::min(m,n),n);
+            for (long j=0; j<n; ++j) ap(_,j) = a[i](_,jpvt[i](j)-1);
+            for (long k=0; k<r.dim(0); ++k)
+                for (long j=k; j<n; ++j) r(k,j) = qr[i](k,j);
+            err = max(err, (inner(ap,ap,0,0) - inner(r,r,0,0)).absmax());
+        }
+        return err;
+    }
+
     /// Example and test code for interface to LAPACK SVD interfae
     template <typename T>
     double test_inverse(int n) {
@@ -1587,6 +1969,28 @@ namespace madness {
             cout << "error in double inverse " << test_inverse<double>(32) << endl;
             cout << "error in double inverse " << test_inverse<double>(47) << endl;
             cout << endl;
+
+            double err;
+            err = test_svd_jacobi<double>(9,6) + test_svd_jacobi<double>(5,12);
+            cout << "error in double svd_jacobi " << err << endl;
+            if (!(err < 1e-12)) return false;
+            err = test_svd_jacobi<double_complex>(9,6) + test_svd_jacobi<double_complex>(5,12);
+            cout << "error in double_complex svd_jacobi " << err << endl;
+            if (!(err < 1e-12)) return false;
+            err = test_svd_jacobi<float>(7,4);
+            cout << "error in float svd_jacobi " << err << endl;
+            if (!(err < 1e-4)) return false;
+
+            err = test_batched<double>(40,3);
+            cout << "error in double batched svd/syev/gesv " << err << endl;
+            if (!(err < 1e-10)) return false;
+            err = test_batched<double_complex>(20,2);
+            cout << "error in double_complex batched svd/syev/gesv " << err << endl;
+            if (!(err < 1e-10)) return false;
+            err = test_geqp3_batched(20,3);
+            cout << "error in double batched geqp3 " << err << endl;
+            if (!(err < 1e-12)) return false;
+            cout << endl;
         }
 
         catch (TensorException& e) {
@@ -1631,10 +2035,6 @@ namespace madness {
                Tensor<double>& x, Tensor<Tensor<double>::scalar_type >& s,
                long &rank, Tensor<Tensor<double>::scalar_type>& sumsq);
 
-    template
-    void syev(const Tensor<double>& A,
-              Tensor<double>& V, Tensor<Tensor<double>::scalar_type >& e);
-
 
     template
     void cholesky(Tensor<double>& A);
@@ -1703,10 +2103,6 @@ namespace madness {
                Tensor<double_complex>& x, Tensor<Tensor<double_complex>::scalar_type >& s,
                long &rank, Tensor<Tensor<double_complex>::scalar_type>& sumsq);
 
-    template
-    void syev(const Tensor<double_complex>& A,
-              Tensor<double_complex>& V, Tensor<Tensor<double_complex>::scalar_type >& e);
-
 // bryan edits start
     template
     void geev(const Tensor<double>& A, Tensor<double>& V, Tensor<std::complex<double>>& e);
@@ -1724,12 +2120,6 @@ namespace madness {
 //     template
 //     void triangular_solve(const Tensor<double_complex>& L, Tensor<double_complex>& B,
 //                           const char* side, const char* transa);
-    template
-    void gesv(const Tensor<double>& a, const Tensor<double>& b, Tensor<double>& x);
-
-    template
-    void gesv(const Tensor<double_complex>& a, const Tensor<double_complex>& b, Tensor<double_complex>& x);
-
     template
     void sygv(const Tensor<double>& A, const Tensor<double>& B, int itype,
               Tensor<double>& V, Tensor<Tensor<double>::scalar_type >& e);
@@ -1743,5 +2133,46 @@ namespace madness {
     template
     void orgqr(Tensor<double_complex>& A, const Tensor<double_complex>& tau);
 
+#define MADNESS_LAPACK_WORKSPACE_INSTANTIATE(T) \
+    template \
+    void svd(const Tensor<T>& a, Tensor<T>& U, Tensor<Tensor<T>::scalar_type >& s, \
+             Tensor<T>& VT, LapackWorkspace<T>& ws); \
+    template \
+    void svd_jacobi(const Tensor<T>& a, Tensor<T>& U, Tensor<Tensor<T>::scalar_type >& s, \
+                    Tensor<T>& VT, LapackWorkspace<T>& ws); \
+    template \
+    void syev(const Tensor<T>& A, Tensor<T>& V, Tensor<Tensor<T>::scalar_type >& e); \
+    template \
+    void syev(const Tensor<T>& A, Tensor<T>& V, Tensor<Tensor<T>::scalar_type >& e, \
+              LapackWorkspace<T>& ws); \
+    template \
+    void gesv(const Tensor<T>& a, const Tensor<T>& b, Tensor<T>& x); \
+    template \
+    void gesv(const Tensor<T>& a, const Tensor<T>& b, Tensor<T>& x, LapackWorkspace<T>& ws); \
+    template \
+    void svd_batched(const std::vector< Tensor<T> >& a, std::vector< Tensor<T> >& U, \
+                     std::vector< Tensor<Tensor<T>::scalar_type> >& s, \
+                     std::vector< Tensor<T> >& VT, int nthread); \
+    template \
+    void syev_batched(const std::vector< Tensor<T> >& A, std::vector< Tensor<T> >& V, \
+                      std::vector< Tensor<Tensor<T>::scalar_type> >& e, int nthread); \
+    template \
+    void gesv_batched(const std::vector< Tensor<T> >& a, const std::vector< Tensor<T> >& b, \
+                      std::vector< Tensor<T> >& x, int nthread);
+
+    MADNESS_LAPACK_WORKSPACE_INSTANTIATE(float)
+    MADNESS_LAPACK_WORKSPACE_INSTANTIATE(double)
+    MADNESS_LAPACK_WORKSPACE_INSTANTIATE(float_complex)
+    MADNESS_LAPACK_WORKSPACE_INSTANTIATE(double_complex)
+
+#undef MADNESS_LAPACK_WORKSPACE_INSTANTIATE
+
+    template
+    void geqp3(Tensor<double>& A, Tensor<double>& tau, Tensor<integer>& jpvt,
+               LapackWorkspace<double>& ws);
+
+    template
+    void geqp3_batched(std::vector< Tensor<double> >& A, std::vector< Tensor<double> >& tau,
+                       std::vector< Tensor<integer> >& jpvt, int nthread);
 
 } // namespace madness
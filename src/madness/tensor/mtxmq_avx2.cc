@@ -0,0 +1,48 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/// \file tensor/mtxmq_avx2.cc
+/// \brief The mTxmq and vectorized tensor kernels compiled for AVX2 and FMA (-mavx2 -mfma)
+
+#include <madness/tensor/mtxmq_kernels_impl.h>
+#include <madness/tensor/tensor_simd_impl.h>
+
+namespace madness {
+    namespace detail {
+        void mtxmq_fill_avx2(mtxmq_kernelT* real, mtxmq_kernelT* complex) {
+            mtxmq_fill_tables<4,12>(real, complex);
+        }
+
+        void tensor_simd_fill_avx2(TensorSimdKernels& k) {
+            tensor_simd_fill_table<4>(k);
+        }
+    }
+}
@@ -0,0 +1,218 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/// \file tensor/mtxmq_kernels.cc
+/// \brief Selects the mTxmq and vectorized tensor kernels for the instruction set of the CPU
+
+#include <madness/tensor/mtxmq_kernels_impl.h>
+#include <madness/tensor/tensor_simd_impl.h>
+#include <madness/world/madness_exception.h>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace madness {
+
+    namespace {
+
+        /// Kernels indexed by dimj, null where there is none, and the vectorized tensor kernels
+        struct MtxmqTable {
+            mtxmq_kernelT real[MTXMQ_MAX_DIMJ+1] = {};
+            mtxmq_kernelT complex[MTXMQ_MAX_DIMJ+1] = {};
+            TensorSimdKernels simd = {};
+
+            explicit MtxmqTable(MtxmqISA isa) {
+                if (isa == MtxmqISA::Generic) detail::mtxmq_fill_generic(real, complex);
+                // without mTxmq kernels the tensor kernels still use the baseline instruction set
+                if (isa == MtxmqISA::BLAS || isa == MtxmqISA::Generic) detail::tensor_simd_fill_generic(simd);
+#ifdef MADNESS_MTXMQ_AVX2
+                if (isa == MtxmqISA::AVX2) {
+                    detail::mtxmq_fill_avx2(real, complex);
+                    detail::tensor_simd_fill_avx2(simd);
+                }
+#endif
+#ifdef MADNESS_MTXMQ_AVX512
+                if (isa == MtxmqISA::AVX512) {
+                    detail::mtxmq_fill_avx512(real, complex);
+                    detail::tensor_simd_fill_avx512(simd);
+                }
+#endif
+            }
+        };
+
+        const MtxmqTable& mtxmq_table(MtxmqISA isa) {
+            static const MtxmqTable tables[] = {MtxmqTable(MtxmqISA::BLAS), MtxmqTable(MtxmqISA::Generic),
+                                                MtxmqTable(MtxmqISA::AVX2), MtxmqTable(MtxmqISA::AVX512)};
+            return tables[int(isa)];
+        }
+
+        /// The fastest supported instruction set, unless MAD_MTXMQ_ISA says otherwise
+        MtxmqISA mtxmq_select() {
+            if (const char* name = std::getenv("MAD_MTXMQ_ISA")) {
+                for (MtxmqISA isa : {MtxmqISA::BLAS, MtxmqISA::Generic, MtxmqISA::AVX2, MtxmqISA::AVX512}) {
+                    if (std::strcmp(name, mtxmq_isa_name(isa)) == 0 && mtxmq_isa_supported(isa)) return isa;
+                }
+            }
+            if (mtxmq_isa_supported(MtxmqISA::AVX512)) return MtxmqISA::AVX512;
+            if (mtxmq_isa_supported(MtxmqISA::AVX2)) return MtxmqISA::AVX2;
+            return MtxmqISA::Generic;
+        }
+
+        std::atomic<const MtxmqTable*>& mtxmq_current() {
+            static std::atomic<const MtxmqTable*> current(&mtxmq_table(mtxmq_select()));
+            return current;
+        }
+
+        const TensorSimdKernels& tensor_simd() {
+            return mtxmq_current().load(std::memory_order_relaxed)->simd;
+        }
+
+        /// Selects the kernels before main, so that the first multiplication does not pay for it
+        const bool mtxmq_initialized = (mtxmq_current(), true);
+    }
+
+    const char* mtxmq_isa_name(MtxmqISA isa) {
+        switch (isa) {
+            case MtxmqISA::BLAS: return "blas";
+            case MtxmqISA::Generic: return "generic";
+            case MtxmqISA::AVX2: return "avx2";
+            case MtxmqISA::AVX512: return "avx512";
+        }
+        return "unknown";
+    }
+
+    bool mtxmq_isa_supported(MtxmqISA isa) {
+        switch (isa) {
+            case MtxmqISA::BLAS:
+            case MtxmqISA::Generic:
+                return true;
+#ifdef MADNESS_MTXMQ_AVX2
+            case MtxmqISA::AVX2:
+                __builtin_cpu_init(); // may run before the constructors of the runtime
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#ifdef MADNESS_MTXMQ_AVX512
+            case MtxmqISA::AVX512:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx512f");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    MtxmqISA mtxmq_isa() {
+        const MtxmqTable* current = mtxmq_current().load(std::memory_order_relaxed);
+        for (MtxmqISA isa : {MtxmqISA::BLAS, MtxmqISA::Generic, MtxmqISA::AVX2, MtxmqISA::AVX512}) {
+            if (current == &mtxmq_table(isa)) return isa;
+        }
+        return MtxmqISA::BLAS;
+    }
+
+    void set_mtxmq_isa(MtxmqISA isa) {
+        MADNESS_CHECK_THROW(mtxmq_isa_supported(isa), "set_mtxmq_isa: instruction set not supported");
+        mtxmq_current().store(&mtxmq_table(isa), std::memory_order_relaxed);
+    }
+
+    bool mtxmq_kernel(long dimi, long dimj, long dimk,
+                      double* c, const double* a, const double* b, long ldb) {
+        if (dimj > MTXMQ_MAX_DIMJ) return false;
+        mtxmq_kernelT kernel = mtxmq_current().load(std::memory_order_relaxed)->real[dimj];
+        if (!kernel) return false;
+        kernel(dimi, dimk, c, a, b, ldb);
+        return true;
+    }
+
+    bool mtxmq_kernel(long dimi, long dimj, long dimk,
+                      std::complex<double>* c, const std::complex<double>* a,
+                      const std::complex<double>* b, long ldb) {
+        if (dimj > MTXMQ_MAX_DIMJ) return false;
+        mtxmq_kernelT kernel = mtxmq_current().load(std::memory_order_relaxed)->complex[dimj];
+        if (!kernel) return false;
+        kernel(dimi, dimk, reinterpret_cast<double*>(c), reinterpret_cast<const double*>(a),
+               reinterpret_cast<const double*>(b), ldb);
+        return true;
+    }
+
+    bool tensor_simd_normsq(const double* p, long n, double& result) {
+        result = tensor_simd().sumsq(p, n);
+        return true;
+    }
+
+    bool tensor_simd_normsq(const std::complex<double>* p, long n, double& result) {
+        result = tensor_simd().sumsq(reinterpret_cast<const double*>(p), 2*n);
+        return true;
+    }
+
+    bool tensor_simd_sumsq(const double* p, long n, double& result) {
+        result = tensor_simd().sumsq(p, n);
+        return true;
+    }
+
+    bool tensor_simd_sumsq(const std::complex<double>* p, long n, std::complex<double>& result) {
+        return tensor_simd_trace(p, p, n, result);
+    }
+
+    bool tensor_simd_absmax(const double* p, long n, double& result) {
+        result = tensor_simd().absmax(p, n);
+        return true;
+    }
+
+    bool tensor_simd_absmax(const std::complex<double>* p, long n, double& result) {
+        result = std::sqrt(tensor_simd().zabsmax(reinterpret_cast<const double*>(p), n));
+        return true;
+    }
+
+    bool tensor_simd_trace(const double* a, const double* b, long n, double& result) {
+        result = tensor_simd().dot(a, b, n);
+        return true;
+    }
+
+    bool tensor_simd_trace(const std::complex<double>* a, const std::complex<double>* b, long n,
+                           std::complex<double>& result) {
+        double r[2];
+        tensor_simd().zdot(reinterpret_cast<const double*>(a), reinterpret_cast<const double*>(b), n, r);
+        result = std::complex<double>(r[0], r[1]);
+        return true;
+    }
+
+    bool tensor_simd_emul(double* a, const double* b, long n) {
+        tensor_simd().emul(a, b, n);
+        return true;
+    }
+
+    bool tensor_simd_emul(std::complex<double>* a, const std::complex<double>* b, long n) {
+        tensor_simd().zemul(reinterpret_cast<double*>(a), reinterpret_cast<const double*>(b), n);
+        return true;
+    }
+
+}
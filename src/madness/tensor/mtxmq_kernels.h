@@ -0,0 +1,97 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_TENSOR_MTXMQ_KERNELS_H__INCLUDED
+#define MADNESS_TENSOR_MTXMQ_KERNELS_H__INCLUDED
+
+/// \file tensor/mtxmq_kernels.h
+/// \brief Size-specialized kernels for mTxmq at the shapes of MADNESS transforms
+
+/// The transforms multiply a long (dimi = k^(d-1)) by a short (dimj = k or 2k)
+/// matrix, where BLAS spends most of its time in setup and edge cases. For each
+/// dimj up to \c MTXMQ_MAX_DIMJ there is a kernel that keeps the rows of the
+/// result in vector registers while it runs over dimk. The kernels are built
+/// once for each instruction set and the fastest one supported by the CPU is
+/// selected at startup. Setting \c MAD_MTXMQ_ISA to blas, generic, avx2 or
+/// avx512 overrides the choice.
+
+#include <complex>
+
+namespace madness {
+
+    /// Largest dimj with a specialized mTxmq kernel
+    static const long MTXMQ_MAX_DIMJ = 24;
+
+    /// Instruction sets of the mTxmq kernels
+    enum class MtxmqISA {
+        BLAS,    ///< No kernels, always call BLAS
+        Generic, ///< Kernels compiled for the baseline instruction set
+        AVX2,    ///< Kernels using AVX2 and FMA
+        AVX512   ///< Kernels using AVX-512
+    };
+
+    /// Returns the name of the instruction set
+    const char* mtxmq_isa_name(MtxmqISA isa);
+
+    /// Returns true if the kernels of the instruction set were built and the CPU supports them
+    bool mtxmq_isa_supported(MtxmqISA isa);
+
+    /// Returns the instruction set of the kernels in use
+    MtxmqISA mtxmq_isa();
+
+    /// Selects the instruction set of the kernels, which must be supported
+
+    /// Not to be called while other threads multiply matrices.
+    void set_mtxmq_isa(MtxmqISA isa);
+
+    /// Computes \c c=a^T*b with a specialized kernel, if there is one for \c dimj
+
+    /// \return False if there is no kernel and nothing was done
+    bool mtxmq_kernel(long dimi, long dimj, long dimk,
+                      double* c, const double* a, const double* b, long ldb);
+
+    /// Computes \c c=a^T*b with a specialized kernel, if there is one for \c dimj
+
+    /// \return False if there is no kernel and nothing was done
+    bool mtxmq_kernel(long dimi, long dimj, long dimk,
+                      std::complex<double>* c, const std::complex<double>* a,
+                      const std::complex<double>* b, long ldb);
+
+    /// There are no kernels for other types
+    template <typename aT, typename bT, typename cT>
+    inline bool mtxmq_kernel(long /*dimi*/, long /*dimj*/, long /*dimk*/,
+                             cT* /*c*/, const aT* /*a*/, const bT* /*b*/, long /*ldb*/) {
+        return false;
+    }
+
+}
+
+#endif // MADNESS_TENSOR_MTXMQ_KERNELS_H__INCLUDED
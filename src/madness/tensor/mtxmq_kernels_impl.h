@@ -0,0 +1,190 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_TENSOR_MTXMQ_KERNELS_IMPL_H__INCLUDED
+#define MADNESS_TENSOR_MTXMQ_KERNELS_IMPL_H__INCLUDED
+
+/// \file tensor/mtxmq_kernels_impl.h
+/// \brief Internal use only ... the body of the mTxmq kernels
+
+// This file is ONLY included into the mtxmq_*.cc files, each compiled
+// for one instruction set.  Everything is in an anonymous namespace so
+// that code built for one instruction set cannot be picked by the linker
+// for another, and only builtins are called for the same reason.
+
+#include <madness/madness_config.h>
+#include <madness/tensor/mtxmq_kernels.h>
+#include <utility>
+
+namespace madness {
+
+    /// Signature of the kernels, complex matrices are passed as pairs of doubles
+    typedef void (*mtxmq_kernelT)(long dimi, long dimk, double* c, const double* a, const double* b, long ldb);
+
+    namespace {
+
+        /// Vector of W doubles, and the same for unaligned access to matrix elements
+        template <long W> struct mtxmq_vector;
+        template <> struct mtxmq_vector<2> {
+            typedef double type __attribute__((vector_size(16)));
+            typedef double unaligned __attribute__((vector_size(16), aligned(8), may_alias));
+        };
+        template <> struct mtxmq_vector<4> {
+            typedef double type __attribute__((vector_size(32)));
+            typedef double unaligned __attribute__((vector_size(32), aligned(8), may_alias));
+        };
+        template <> struct mtxmq_vector<8> {
+            typedef double type __attribute__((vector_size(64)));
+            typedef double unaligned __attribute__((vector_size(64), aligned(8), may_alias));
+        };
+
+        /// Number of rows of the result held in \c nreg registers of \c W doubles
+        constexpr long mtxmq_block_rows(long nd, long W, long nreg) {
+            return (nreg/((nd+W-1)/W) < 1) ? 1 : ((nreg/((nd+W-1)/W) > 8) ? 8 : nreg/((nd+W-1)/W));
+        }
+
+        /// Computes R rows of the result, each of ND doubles
+
+        /// For complex matrices (Z) the rows hold ND/2 interleaved complex
+        /// numbers. The products with the real and imaginary parts of a(k,i)
+        /// are accumulated separately, and combined when the row is stored.
+        /// \param[in] sa Stride between consecutive k in \c a
+        /// \param[in] sb Stride between consecutive k in \c b
+        template <long ND, long R, long W, bool Z>
+        inline void mtxmq_rows(long dimk, double* MADNESS_RESTRICT c, const double* MADNESS_RESTRICT a,
+                               const double* MADNESS_RESTRICT b, long sa, long sb) {
+            typedef typename mtxmq_vector<W>::type vecT;
+            typedef typename mtxmq_vector<W>::unaligned uvecT;
+            constexpr long WH = (W > 2) ? W/2 : W;
+            typedef typename mtxmq_vector<WH>::type hvecT;
+            typedef typename mtxmq_vector<WH>::unaligned uhvecT;
+            constexpr long NV = ND/W;                          // full vectors in a row
+            constexpr long NH = (WH < W && ND-NV*W >= WH);     // then a half vector
+            constexpr long NT = ND - NV*W - NH*WH;             // remaining doubles
+            constexpr long NZ = Z ? 2 : 1;                     // accumulators per element
+
+            // the loops are unrolled so that the accumulators stay in registers
+            vecT acc[NZ][R][NV ? NV : 1];
+            hvecT half[NZ][R];
+            double tail[NZ][R][NT ? NT : 1];
+#pragma GCC unroll 16
+            for (long z=0; z<NZ; ++z) {
+#pragma GCC unroll 16
+                for (long r=0; r<R; ++r) {
+#pragma GCC unroll 16
+                    for (long v=0; v<NV; ++v) acc[z][r][v] = vecT{};
+                    half[z][r] = hvecT{};
+#pragma GCC unroll 16
+                    for (long t=0; t<NT; ++t) tail[z][r][t] = 0.0;
+                }
+            }
+
+            for (long k=0; k<dimk; ++k, a+=sa, b+=sb) {
+                vecT bv[NV ? NV : 1];
+                hvecT bh{};
+#pragma GCC unroll 16
+                for (long v=0; v<NV; ++v) bv[v] = *reinterpret_cast<const uvecT*>(b+v*W);
+                if constexpr (NH) bh = *reinterpret_cast<const uhvecT*>(b+NV*W);
+#pragma GCC unroll 16
+                for (long r=0; r<R; ++r) {
+#pragma GCC unroll 16
+                    for (long z=0; z<NZ; ++z) {
+                        const double air = a[r*NZ+z];
+#pragma GCC unroll 16
+                        for (long v=0; v<NV; ++v) acc[z][r][v] += air*bv[v];
+                        if constexpr (NH) half[z][r] += air*bh;
+#pragma GCC unroll 16
+                        for (long t=0; t<NT; ++t) tail[z][r][t] += air*b[NV*W+NH*WH+t];
+                    }
+                }
+            }
+
+#pragma GCC unroll 16
+            for (long r=0; r<R; ++r) {
+                if constexpr (Z) {
+                    // (ar + i ai)*(br + i bi) = ar*br - ai*bi + i (ar*bi + ai*br)
+                    double row[NZ][ND];
+                    for (long z=0; z<NZ; ++z) {
+                        for (long v=0; v<NV; ++v) *reinterpret_cast<uvecT*>(&row[z][v*W]) = acc[z][r][v];
+                        if constexpr (NH) *reinterpret_cast<uhvecT*>(&row[z][NV*W]) = half[z][r];
+                        for (long t=0; t<NT; ++t) row[z][NV*W+NH*WH+t] = tail[z][r][t];
+                    }
+                    for (long j=0; j<ND; j+=2) {
+                        c[r*ND+j]   = row[0][j]   - row[1][j+1];
+                        c[r*ND+j+1] = row[0][j+1] + row[1][j];
+                    }
+                }
+                else {
+#pragma GCC unroll 16
+                    for (long v=0; v<NV; ++v) *reinterpret_cast<uvecT*>(c+r*ND+v*W) = acc[0][r][v];
+                    if constexpr (NH) *reinterpret_cast<uhvecT*>(c+r*ND+NV*W) = half[0][r];
+#pragma GCC unroll 16
+                    for (long t=0; t<NT; ++t) c[r*ND+NV*W+NH*WH+t] = tail[0][r][t];
+                }
+            }
+        }
+
+        /// Computes \c c=a^T*b for a fixed \c dimj, in blocks of rows
+        template <long NJ, long W, long NREG, bool Z>
+        void mtxmq_fixed(long dimi, long dimk, double* c, const double* a, const double* b, long ldb) {
+            constexpr long NZ = Z ? 2 : 1;
+            constexpr long ND = NZ*NJ;
+            constexpr long R = mtxmq_block_rows(NZ*ND, W, NREG);
+            long i = 0;
+            for (; i+R<=dimi; i+=R)
+                mtxmq_rows<ND,R,W,Z>(dimk, c+i*ND, a+i*NZ, b, dimi*NZ, ldb*NZ);
+            for (; i<dimi; ++i)
+                mtxmq_rows<ND,1,W,Z>(dimk, c+i*ND, a+i*NZ, b, dimi*NZ, ldb*NZ);
+        }
+
+        template <long W, long NREG, bool Z, long... J>
+        void mtxmq_fill(mtxmq_kernelT* table, std::integer_sequence<long, J...>) {
+            ((table[J+1] = &mtxmq_fixed<J+1,W,NREG,Z>), ...);
+        }
+
+        /// Fills the kernels for dimj=1..MTXMQ_MAX_DIMJ, for vectors of W doubles of which NREG hold the result
+        template <long W, long NREG>
+        void mtxmq_fill_tables(mtxmq_kernelT* real, mtxmq_kernelT* complex) {
+            mtxmq_fill<W,NREG,false>(real, std::make_integer_sequence<long, MTXMQ_MAX_DIMJ>());
+            mtxmq_fill<W,NREG,true>(complex, std::make_integer_sequence<long, MTXMQ_MAX_DIMJ>());
+        }
+
+    }
+
+    namespace detail {
+        /// Fills the tables of kernels indexed by dimj, one function per instruction set
+        void mtxmq_fill_generic(mtxmq_kernelT* real, mtxmq_kernelT* complex);
+        void mtxmq_fill_avx2(mtxmq_kernelT* real, mtxmq_kernelT* complex);
+        void mtxmq_fill_avx512(mtxmq_kernelT* real, mtxmq_kernelT* complex);
+    }
+}
+
+#endif // MADNESS_TENSOR_MTXMQ_KERNELS_IMPL_H__INCLUDED
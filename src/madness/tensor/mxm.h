@@ -42,6 +42,7 @@
 //#ifdef HAVE_INTEL_MKL
 #include <madness/tensor/cblas.h>
 #endif
+#include <madness/tensor/mtxmq_kernels.h>
 
 /// \file tensor/mxm.h
 /// \brief Internal use only
@@ -255,6 +256,7 @@ namespace madness {
         MADNESS_ASSERT(ldb>=dimj);
 
         if (dimi==0 || dimj==0) return; // nothing to do and *GEMM will complain
+        if (mtxmq_kernel(dimi, dimj, dimk, c, a, b, ldb)) return; // specialized for small dimj
         if (dimk==0) {
             for (long i=0; i<dimi*dimj; i++) c[i] = 0.0;
         }
@@ -337,6 +339,7 @@ namespace madness {
         MADNESS_ASSERT(ldb>=dimj);
 
         if (dimi==0 || dimj==0) return; // nothing to do and *GEMM will complain
+        if (mtxmq_kernel(dimi, dimj, dimk, c, a, b, ldb)) return; // specialized for small dimj
         if (dimk==0) {
             for (long i=0; i<dimi*dimj; i++) c[i] = 0.0;
         }
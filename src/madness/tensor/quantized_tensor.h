@@ -0,0 +1,252 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_TENSOR_QUANTIZED_TENSOR_H__INCLUDED
+#define MADNESS_TENSOR_QUANTIZED_TENSOR_H__INCLUDED
+
+/// \file quantized_tensor.h
+/// \brief Error-bounded lossy encoding of tensors for storage
+
+#include <madness/tensor/tensor.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace madness {
+
+    /// A tensor encoded with a bound on the error, for compact storage
+
+    /// The elements are rounded to a uniform grid whose spacing is chosen so
+    /// that the Frobenius norm of the error is at most the requested
+    /// tolerance, which discards all mantissa bits below the error bound.
+    /// The integers are zig-zag mapped and Golomb-Rice coded with the
+    /// parameter adapted to the running mean of the preceding values, as in
+    /// JPEG-LS, which follows the decaying multiwavelet coefficients of smooth
+    /// functions.  If the encoding does not pay off the elements are kept exactly.
+    template <typename T>
+    class QuantizedTensor {
+        typedef typename TensorTypeData<T>::scalar_type scalar_type;
+        static const int nescape = 32; ///< unary quotients this long are followed by the raw value
+
+        std::vector<long> dims; ///< Dimensions of the tensor, empty if it has no data
+        double tol=0.0;         ///< Requested bound on the Frobenius norm of the error
+        double err=0.0;         ///< Frobenius norm of the error made when encoding
+        double delta=0.0;       ///< Quantization step, zero if the elements are stored exactly
+        std::vector<unsigned char> bytes; ///< The encoded elements
+
+        /// Appends bits to a byte vector, least significant bit first
+        class BitWriter {
+            std::vector<unsigned char>& out;
+            uint64_t buf=0;
+            int nbuf=0;
+        public:
+            BitWriter(std::vector<unsigned char>& out) : out(out) {}
+
+            void put(uint64_t value, int nbit) {
+                while (nbit > 0) {
+                    const int n = std::min(nbit, 64-nbuf);
+                    const uint64_t v = (n == 64) ? value : (value & ((uint64_t(1)<<n)-1));
+                    buf |= v << nbuf;
+                    nbuf += n;
+                    value = (n == 64) ? 0 : (value >> n);
+                    nbit -= n;
+                    while (nbuf >= 8) {
+                        out.push_back(buf & 0xff);
+                        buf >>= 8;
+                        nbuf -= 8;
+                    }
+                }
+            }
+
+            void flush() {
+                if (nbuf > 0) out.push_back(buf & 0xff);
+                buf = 0;
+                nbuf = 0;
+            }
+        };
+
+        /// Reads bits written by BitWriter
+        class BitReader {
+            const std::vector<unsigned char>& in;
+            std::size_t pos=0;
+            uint64_t buf=0;
+            int nbuf=0;
+        public:
+            BitReader(const std::vector<unsigned char>& in) : in(in) {}
+
+            uint64_t get(int nbit) {
+                uint64_t value = 0;
+                int shift = 0;
+                while (nbit > 0) {
+                    if (nbuf == 0) {
+                        MADNESS_CHECK(pos < in.size());
+                        buf = in[pos++];
+                        nbuf = 8;
+                    }
+                    const int n = std::min(nbit, nbuf);
+                    value |= (buf & ((uint64_t(1)<<n)-1)) << shift;
+                    buf >>= n;
+                    nbuf -= n;
+                    shift += n;
+                    nbit -= n;
+                }
+                return value;
+            }
+        };
+
+        /// Adapts the Golomb-Rice parameter to the running mean of the coded values
+        class RiceContext {
+            double sum=0.0;
+            double count=1.0;
+        public:
+            /// The smallest parameter with 2^k at least the mean
+            int parameter() const {
+                int k = 0;
+                while (k < 62 and std::ldexp(count, k) < sum) ++k;
+                return k;
+            }
+
+            void update(uint64_t u) {
+                sum += double(u);
+                count += 1.0;
+                if (count >= 16.0) {
+                    sum *= 0.5;
+                    count *= 0.5;
+                }
+            }
+        };
+
+        void store_exactly(const scalar_type* x, long n) {
+            delta = 0.0;
+            err = 0.0;
+            bytes.resize(n*sizeof(scalar_type));
+            if (n > 0) std::memcpy(bytes.data(), x, n*sizeof(scalar_type));
+        }
+
+    public:
+        QuantizedTensor() = default;
+
+        /// Encodes \c t such that the Frobenius norm of the error is at most \c tolerance
+
+        /// A non-positive tolerance stores the elements exactly.
+        QuantizedTensor(const Tensor<T>& t, const double tolerance) : tol(std::max(tolerance,0.0)) {
+            if (not t.has_data()) return;
+            dims.assign(t.dims(), t.dims()+t.ndim());
+
+            const Tensor<T> c = t.iscontiguous() ? t : copy(t);
+            const long n = c.size()*(sizeof(T)/sizeof(scalar_type));
+            const scalar_type* x = reinterpret_cast<const scalar_type*>(c.ptr());
+
+            // uniform rounding errors of at most delta/2 add up to at most tol
+            delta = 2.0*tol/std::sqrt(double(n));
+            double maxabs = 0.0;
+            for (long i=0; i<n; ++i) maxabs = std::max(maxabs, std::abs(double(x[i])));
+            if (not (delta > 0.0) or maxabs/delta > 4.5e15) {
+                store_exactly(x, n);
+                return;
+            }
+
+            std::vector<uint64_t> u(n);
+            double err2 = 0.0;
+            for (long i=0; i<n; ++i) {
+                const int64_t q = std::llround(double(x[i])/delta);
+                const double e = double(x[i]) - q*delta;
+                err2 += e*e;
+                u[i] = (uint64_t(q) << 1) ^ uint64_t(q >> 63);
+            }
+            err = std::sqrt(err2);
+
+            bytes.reserve(n);
+            BitWriter writer(bytes);
+            RiceContext context;
+            for (long i=0; i<n; ++i) {
+                const int k = context.parameter();
+                const uint64_t q = u[i] >> k;
+                if (q < uint64_t(nescape)) {
+                    writer.put((uint64_t(1) << q) - 1, q+1);
+                    writer.put(u[i], k);
+                } else {
+                    writer.put((uint64_t(1) << nescape) - 1, nescape);
+                    writer.put(u[i], 64);
+                }
+                context.update(u[i]);
+            }
+            writer.flush();
+            if (bytes.size() >= n*sizeof(scalar_type)) store_exactly(x, n);
+        }
+
+        /// Returns the requested bound on the Frobenius norm of the error
+        double tolerance() const {return tol;}
+
+        /// Returns the Frobenius norm of the error made when encoding
+        double error() const {return err;}
+
+        /// Returns the number of bytes of the encoded elements
+        std::size_t nbyte() const {return bytes.size();}
+
+        /// Decodes the tensor, checking that the stored error is within the tolerance
+        Tensor<T> decode() const {
+            if (dims.empty()) return Tensor<T>();
+            Tensor<T> t(dims, false);
+            const long n = t.size()*(sizeof(T)/sizeof(scalar_type));
+            scalar_type* x = reinterpret_cast<scalar_type*>(t.ptr());
+
+            if (delta == 0.0) {
+                MADNESS_CHECK(bytes.size() == n*sizeof(scalar_type));
+                if (n > 0) std::memcpy(x, bytes.data(), bytes.size());
+                return t;
+            }
+
+            MADNESS_CHECK(err <= tol and 0.5*delta*std::sqrt(double(n)) <= tol*(1.0+1e-12));
+            BitReader reader(bytes);
+            RiceContext context;
+            for (long i=0; i<n; ++i) {
+                const int k = context.parameter();
+                uint64_t q = 0;
+                while (q < uint64_t(nescape) and reader.get(1)) ++q;
+                const uint64_t u = (q < uint64_t(nescape)) ? ((q << k) | reader.get(k)) : reader.get(64);
+                context.update(u);
+                const int64_t v = int64_t(u >> 1) ^ -int64_t(u & 1);
+                x[i] = scalar_type(v*delta);
+            }
+            return t;
+        }
+
+        template <typename Archive>
+        void serialize(Archive& ar) {
+            ar & dims & tol & err & delta & bytes;
+        }
+    };
+
+}
+
+#endif // MADNESS_TENSOR_QUANTIZED_TENSOR_H__INCLUDED
@@ -35,6 +35,7 @@
 #include <madness/madness_config.h>
 #include <madness/misc/ran.h>
 #include <madness/world/posixmem.h>
+#include <madness/world/worldmem.h>
 
 #include <memory>
 #include <complex>
@@ -45,6 +46,7 @@
 #include <cstddef>
 
 #include <madness/world/archive.h>
+#include <madness/world/iovec_archive.h>
 // #include <madness/world/print.h>
 //
 // typedef std::complex<float> float_complex;
@@ -59,6 +61,8 @@
 #include <madness/tensor/aligned.h>
 #include <madness/tensor/mxm.h>
 #include <madness/tensor/tensorexcept.h>
+#include <madness/tensor/tensor_pool.h>
+#include <madness/tensor/tensor_simd.h>
 #include <madness/tensor/tensoriter.h>
 
 #ifdef USE_GENTENSOR
@@ -359,8 +363,12 @@ namespace madness {
                     _p = new T[_size];
                     _shptr = std::shared_ptr<T>(_p);
 #else
-                    if (posix_memalign((void **) &_p, TENSOR_ALIGNMENT, sizeof(T)*_size)) throw 1;
-                    _shptr.reset(_p, &free);
+                    static_assert(TENSOR_POOL_ALIGNMENT >= TENSOR_ALIGNMENT, "tensor pool alignment too small");
+                    const std::size_t nbyte = sizeof(T)*_size;
+                    _p = static_cast<T*>(tensor_pool_allocate(nbyte));
+                    if (!_p) throw 1;
+                    const int tag = memory_tags_enabled() ? memory_tag_allocate(nbyte) : -1;
+                    _shptr.reset(_p, TensorPoolDeleter{nbyte, tag}, TensorPoolAllocator<T>());
 #endif
                 }
                 catch (...) {
@@ -1665,6 +1673,7 @@ namespace madness {
         /// Returns the sum of the squares of the elements
         T sumsq() const {
             T result = 0;
+            if (iscontiguous() && tensor_simd_sumsq(ptr(), _size, result)) return result;
             UNARY_OPTIMIZED_ITERATOR(const T,(*this),result += (*_p0) * (*_p0));
             return result;
         }
@@ -1722,7 +1731,9 @@ namespace madness {
         /// Returns the Frobenius norm of the tensor
         float_scalar_type normf() const {
             float_scalar_type result = 0;
-            UNARY_OPTIMIZED_ITERATOR(const T,(*this),result += ::madness::detail::mynorm(*_p0));
+            if (!(iscontiguous() && tensor_simd_normsq(ptr(), _size, result))) {
+                UNARY_OPTIMIZED_ITERATOR(const T,(*this),result += ::madness::detail::mynorm(*_p0));
+            }
             return (float_scalar_type) std::sqrt(result);
         }
 
@@ -1762,7 +1773,7 @@ namespace madness {
                                            }
                                            );
             }
-            else {
+            else if (!(iscontiguous() && tensor_simd_absmax(ptr(), _size, result))) {
                 UNARY_OPTIMIZED_ITERATOR(const T,(*this),result=std::max<scalar_type>(result,std::abs(*_p0)));
             }
             return result;
@@ -1772,6 +1783,10 @@ namespace madness {
         /// Return the trace of two tensors (no complex conjugate invoked)
         T trace(const Tensor<T>& t) const {
             T result = 0;
+            if (iscontiguous() && t.iscontiguous()) {
+                TENSOR_ASSERT(BaseTensor::conforms(&t), "trace: tensors do not conform", _size, &t);
+                if (tensor_simd_trace(ptr(), t.ptr(), _size, result)) return result;
+            }
             BINARY_OPTIMIZED_ITERATOR(const T,(*this),const T,t,result += (*_p0)*(*_p1));
             return result;
         }
@@ -1787,12 +1802,21 @@ namespace madness {
         /// Inplace apply a unary function to each element of the tensor
         template <typename opT>
         Tensor<T>& unaryop(opT& op) {
+            if (iscontiguous()) {
+                T* MADNESS_RESTRICT p = ptr();
+                for (long i=0; i<_size; ++i) p[i] = op(p[i]);
+                return *this;
+            }
             UNARY_OPTIMIZED_ITERATOR(T,(*this),*_p0=op(*_p0));
             return *this;
         }
 
         /// Inplace multiply by corresponding elements of argument Tensor
         Tensor<T>& emul(const Tensor<T>& t) {
+            if (iscontiguous() && t.iscontiguous()) {
+                TENSOR_ASSERT(BaseTensor::conforms(&t), "emul: tensors do not conform", _size, &t);
+                if (tensor_simd_emul(ptr(), t.ptr(), _size)) return *this;
+            }
             BINARY_OPTIMIZED_ITERATOR(T,(*this),const T,t,*_p0 *= *_p1);
             return *this;
         }
@@ -1903,6 +1927,28 @@ namespace madness {
             };
         };
 
+        /// Serialize a tensor into a scatter-gather archive, referencing rather than copying its elements
+
+        /// The archive shares ownership of the elements until it is destroyed.
+        template <typename T>
+        struct ArchiveStoreImpl< IovecOutputArchive, Tensor<T> > {
+            static void store(const IovecOutputArchive& s, const Tensor<T>& t) {
+                const Tensor<T> c = t.iscontiguous() ? t : copy(t);
+                s & c.size() & c.id();
+                if (c.size()) {
+                    s & c.ndim() & wrap(c.dims(),TENSOR_MAXDIM);
+                    if (c.size()*sizeof(T) < IovecOutputArchive::min_reference_nbyte) s & wrap(c.ptr(),c.size());
+                    else {
+                        // complex elements are stored as consecutive real and imaginary parts
+                        typedef typename TensorTypeData<T>::scalar_type scalar_type;
+                        s.store_reference(reinterpret_cast<const scalar_type*>(c.ptr()),
+                                          c.size()*long(sizeof(T)/sizeof(scalar_type)),
+                                          std::make_shared<const Tensor<T> >(c));
+                    }
+                }
+            };
+        };
+
 
         /// Deserialize a tensor ... existing tensor is replaced
         template <class Archive, typename T>
@@ -2481,6 +2527,107 @@ namespace madness {
         return result;
     }
 
+    /// Transforms a batch of tensors that share the matrix c, each pass in a single mTxmq
+
+    /// \ingroup tensor
+    /// The \c nbatch tensors, each with \c ndim dimensions of size \c c.dim(0),
+    /// are packed into the matrix \c t with the batch index fastest
+    /// \code
+    ///     t(i*nbatch + n) = tn(i)       i = flattened index (i1,i2,...)
+    /// \endcode
+    /// Each pass contracts the slowest index and appends the new index as the
+    /// fastest one, so after \c ndim passes the batch index has moved to the
+    /// front and the transformed tensors follow each other in \c result
+    /// \code
+    ///     result(n*size + j) = sum(i1,i2,...) tn(i1,i2,...) c(i1,j1) c(i2,j2) ...
+    /// \endcode
+    /// Thus all tensors are transformed by \c ndim calls of mTxmq with a long
+    /// \c dimi, instead of \c nbatch*ndim calls with a short one, and \c c stays
+    /// in cache.
+    ///
+    /// As for fast_transform, \c c must be square, all tensors must be contiguous
+    /// and distinct, and the workspace and result must be of the same size as \c t.
+    template <class T, class Q>
+    Tensor< TENSOR_RESULT_TYPE(T,Q) >& fast_transform_batch(long ndim, long nbatch, const Tensor<T>& t, const Tensor<Q>& c,
+            Tensor< TENSOR_RESULT_TYPE(T,Q) >& result, Tensor< TENSOR_RESULT_TYPE(T,Q) >& workspace) {
+        typedef  TENSOR_RESULT_TYPE(T,Q) resultT;
+        TENSOR_ASSERT(c.ndim()==2 && c.dim(0)==c.dim(1), "fast_transform_batch: matrix must be square", c.ndim(), &c);
+        const Q *pc=c.ptr();
+        resultT *t0=workspace.ptr(), *t1=result.ptr();
+        if (ndim&1) {
+            t0 = result.ptr();
+            t1 = workspace.ptr();
+        }
+
+        long dimj = c.dim(1);
+        long dimi = nbatch;
+        for (int n=1; n<ndim; ++n) dimi *= dimj;
+        TENSOR_ASSERT(t.size()==dimi*dimj && result.size()==t.size() && workspace.size()==t.size(),
+                      "fast_transform_batch: inconsistent sizes", t.size(), &t);
+
+        mTxmq(dimi, dimj, dimj, t0, t.ptr(), pc);
+        for (int n=1; n<ndim; ++n) {
+            mTxmq(dimi, dimj, dimj, t1, t0, pc);
+            std::swap(t0,t1);
+        }
+
+        return result;
+    }
+
+    /// Transforms all dimensions of each tensor in \c t by the square matrix \c c
+
+    /// \ingroup tensor
+    /// Same as calling fast_transform on each tensor. Small tensors, for which
+    /// the overhead of the calls dominates, are transformed together by
+    /// fast_transform_batch. Empty tensors are allowed and give empty results,
+    /// all others must be contiguous and of the same shape. The results are
+    /// views of a single tensor holding the whole batch.
+    template <class T, class Q>
+    std::vector< Tensor<TENSOR_RESULT_TYPE(T,Q)> > transform_batch(const std::vector< Tensor<T> >& t, const Tensor<Q>& c) {
+        typedef TENSOR_RESULT_TYPE(T,Q) resultT;
+        std::vector< Tensor<resultT> > r(t.size());
+
+        std::vector<std::size_t> index;
+        for (std::size_t n=0; n<t.size(); ++n) {
+            if (t[n].size()) index.push_back(n);
+        }
+        if (index.empty()) return r;
+
+        const Tensor<T>& t0 = t[index[0]];
+        const long nbatch = index.size(), size = t0.size();
+        const std::vector<long> result_dims = {nbatch, size};
+        Tensor<resultT> result(result_dims, false);
+        for (long m=0; m<nbatch; ++m) {
+            const Tensor<T>& tm = t[index[m]];
+            TENSOR_ASSERT(tm.iscontiguous() && tm.conforms(t0), "transform_batch: tensors must be contiguous and conform", m, &tm);
+            Tensor<resultT> row = result(Slice(m,m,0),_);
+            r[index[m]] = row.reshape(t0.ndim(), t0.dims());
+        }
+
+        if (size > 256) {
+            // larger tensors stay in cache between the passes of fast_transform, which
+            // is then faster than transposing the batch; only the workspace is shared
+            Tensor<resultT> work(t0.ndim(), t0.dims(), false);
+            for (long m=0; m<nbatch; ++m) fast_transform(t[index[m]], c, r[index[m]], work);
+            return r;
+        }
+
+        // transpose in blocks, so that both the reads and the writes run along cache lines
+        const std::vector<long> packed_dims = {size, nbatch};
+        Tensor<resultT> packed(packed_dims, false), work(result_dims, false);
+        const long B = 8;
+        resultT* MADNESS_RESTRICT p = packed.ptr();
+        for (long i0=0; i0<size; i0+=B) {
+            const long i1 = std::min(i0+B, size);
+            for (long m=0; m<nbatch; ++m) {
+                const T* MADNESS_RESTRICT q = t[index[m]].ptr();
+                for (long i=i0; i<i1; ++i) p[i*nbatch+m] = q[i];
+            }
+        }
+        fast_transform_batch(t0.ndim(), nbatch, packed, c, result, work);
+        return r;
+    }
+
     /// Return a new tensor holding the absolute value of each element of t
 
     /// \ingroup tensor
@@ -0,0 +1,304 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_TENSOR_TENSOR_EXPR_H__INCLUDED
+#define MADNESS_TENSOR_TENSOR_EXPR_H__INCLUDED
+
+/// \file tensor/tensor_expr.h
+/// \brief Lazy elementwise expressions of tensors, evaluated in a single loop
+
+/// Each eager operation on tensors makes a pass over memory, so that
+/// \code
+///     Tensor<double> r = copy(c).gaxpy(a, x, b).emul(y);
+/// \endcode
+/// reads and writes the elements three times.  The same expression built from
+/// lazy() tensors is only a description of the computation
+/// \code
+///     Tensor<double> r = evaluate(lazy(c).gaxpy(a, x, b).emul(y));
+///     assign(c, lazy(c)*a + lazy(x)*b);      // in place
+/// \endcode
+/// and evaluate() or assign() compute all elements in one loop that the
+/// compiler can vectorize.  Between expressions \c * is the elementwise product,
+/// as emul().  All tensors must conform.  Tensors that are not contiguous,
+/// e.g. slices, are copied when they enter the expression; the result of
+/// assign() may be a non-contiguous tensor.
+
+#include <madness/tensor/tensor.h>
+#include <type_traits>
+
+namespace madness {
+
+    /// Base of all lazy tensor expressions, \c E is the derived class
+
+    /// Provides the operations of Tensor that do not change the shape, so that
+    /// a chain of them reads the same as the eager code.
+    template <typename E>
+    class TensorExpr {
+    public:
+        const E& derived() const {return static_cast<const E&>(*this);}
+
+        /// Multiplication by a scalar
+        template <typename Q>
+        auto scale(const Q& x) const;
+
+        /// Elementwise product with another expression
+        template <typename F>
+        auto emul(const TensorExpr<F>& f) const;
+
+        /// this*alpha + f*beta
+        template <typename Q, typename F>
+        auto gaxpy(const Q& alpha, const TensorExpr<F>& f, const Q& beta) const;
+    };
+
+    namespace detail {
+
+        /// Leaf of an expression, holding a shallow copy of a contiguous tensor
+        template <typename T>
+        class TensorExprLeaf : public TensorExpr< TensorExprLeaf<T> > {
+            Tensor<T> t;
+            const T* p;
+        public:
+            typedef T value_type;
+
+            explicit TensorExprLeaf(const Tensor<T>& t)
+                : t(t.iscontiguous() ? t : copy(t)), p(this->t.ptr()) {}
+
+            TensorExprLeaf(const TensorExprLeaf& other) : t(other.t), p(t.ptr()) {}
+
+            T operator[](long i) const {return p[i];}
+
+            /// The first tensor of the expression, which gives its shape
+            const BaseTensor* shape() const {return &t;}
+
+            /// Checks that the tensor conforms to \c s
+            void check(const BaseTensor* s) const {
+                TENSOR_ASSERT(t.BaseTensor::conforms(s), "tensor expression: tensors do not conform", t.ndim(), &t);
+            }
+        };
+
+        /// Leaf of an expression holding a scalar
+        template <typename Q>
+        class TensorExprScalar : public TensorExpr< TensorExprScalar<Q> > {
+            Q x;
+        public:
+            typedef Q value_type;
+
+            explicit TensorExprScalar(const Q& x) : x(x) {}
+
+            Q operator[](long) const {return x;}
+
+            const BaseTensor* shape() const {return 0;}
+
+            void check(const BaseTensor*) const {}
+        };
+
+        /// Elementwise binary operation
+        template <typename opT, typename L, typename R>
+        class TensorExprBinary : public TensorExpr< TensorExprBinary<opT,L,R> > {
+            L left;
+            R right;
+        public:
+            typedef TENSOR_RESULT_TYPE(typename L::value_type, typename R::value_type) value_type;
+
+            TensorExprBinary(const L& left, const R& right) : left(left), right(right) {}
+
+            value_type operator[](long i) const {return opT::apply(left[i], right[i]);}
+
+            const BaseTensor* shape() const {
+                const BaseTensor* s = left.shape();
+                return s ? s : right.shape();
+            }
+
+            void check(const BaseTensor* s) const {
+                left.check(s);
+                right.check(s);
+            }
+        };
+
+        /// Elementwise function of an expression
+        template <typename opT, typename E>
+        class TensorExprUnary : public TensorExpr< TensorExprUnary<opT,E> > {
+            opT op;
+            E e;
+        public:
+            typedef typename std::decay<decltype(std::declval<const opT&>()(std::declval<typename E::value_type>()))>::type value_type;
+
+            TensorExprUnary(const opT& op, const E& e) : op(op), e(e) {}
+
+            value_type operator[](long i) const {return op(e[i]);}
+
+            const BaseTensor* shape() const {return e.shape();}
+
+            void check(const BaseTensor* s) const {e.check(s);}
+        };
+
+        struct TensorExprPlus {
+            template <typename A, typename B> static auto apply(const A& a, const B& b) {return a + b;}
+        };
+        struct TensorExprMinus {
+            template <typename A, typename B> static auto apply(const A& a, const B& b) {return a - b;}
+        };
+        struct TensorExprTimes {
+            template <typename A, typename B> static auto apply(const A& a, const B& b) {return a * b;}
+        };
+        struct TensorExprNegate {
+            template <typename A> A operator()(const A& a) const {return -a;}
+        };
+
+        template <typename E>
+        const E& tensor_expr_check(const TensorExpr<E>& e) {
+            const E& x = e.derived();
+            TENSOR_ASSERT(x.shape(), "tensor expression: no tensor in expression", 0, 0);
+            x.check(x.shape());
+            return x;
+        }
+
+    }
+
+    /// Makes a tensor the leaf of a lazy expression
+    template <typename T>
+    detail::TensorExprLeaf<T> lazy(const Tensor<T>& t) {
+        return detail::TensorExprLeaf<T>(t);
+    }
+
+    /// Elementwise sum
+    template <typename L, typename R>
+    detail::TensorExprBinary<detail::TensorExprPlus,L,R> operator+(const TensorExpr<L>& l, const TensorExpr<R>& r) {
+        return detail::TensorExprBinary<detail::TensorExprPlus,L,R>(l.derived(), r.derived());
+    }
+
+    /// Elementwise difference
+    template <typename L, typename R>
+    detail::TensorExprBinary<detail::TensorExprMinus,L,R> operator-(const TensorExpr<L>& l, const TensorExpr<R>& r) {
+        return detail::TensorExprBinary<detail::TensorExprMinus,L,R>(l.derived(), r.derived());
+    }
+
+    /// Elementwise product
+    template <typename L, typename R>
+    detail::TensorExprBinary<detail::TensorExprTimes,L,R> operator*(const TensorExpr<L>& l, const TensorExpr<R>& r) {
+        return detail::TensorExprBinary<detail::TensorExprTimes,L,R>(l.derived(), r.derived());
+    }
+
+    /// Multiplication by a scalar
+    template <typename L, typename Q>
+    typename IsSupported<TensorTypeData<Q>, detail::TensorExprBinary<detail::TensorExprTimes,L,detail::TensorExprScalar<Q> > >::type
+    operator*(const TensorExpr<L>& l, const Q& x) {
+        return detail::TensorExprBinary<detail::TensorExprTimes,L,detail::TensorExprScalar<Q> >(l.derived(), detail::TensorExprScalar<Q>(x));
+    }
+
+    /// Multiplication by a scalar
+    template <typename Q, typename R>
+    typename IsSupported<TensorTypeData<Q>, detail::TensorExprBinary<detail::TensorExprTimes,detail::TensorExprScalar<Q>,R> >::type
+    operator*(const Q& x, const TensorExpr<R>& r) {
+        return detail::TensorExprBinary<detail::TensorExprTimes,detail::TensorExprScalar<Q>,R>(detail::TensorExprScalar<Q>(x), r.derived());
+    }
+
+    /// Adds a scalar to each element
+    template <typename L, typename Q>
+    typename IsSupported<TensorTypeData<Q>, detail::TensorExprBinary<detail::TensorExprPlus,L,detail::TensorExprScalar<Q> > >::type
+    operator+(const TensorExpr<L>& l, const Q& x) {
+        return detail::TensorExprBinary<detail::TensorExprPlus,L,detail::TensorExprScalar<Q> >(l.derived(), detail::TensorExprScalar<Q>(x));
+    }
+
+    /// Subtracts a scalar from each element
+    template <typename L, typename Q>
+    typename IsSupported<TensorTypeData<Q>, detail::TensorExprBinary<detail::TensorExprMinus,L,detail::TensorExprScalar<Q> > >::type
+    operator-(const TensorExpr<L>& l, const Q& x) {
+        return detail::TensorExprBinary<detail::TensorExprMinus,L,detail::TensorExprScalar<Q> >(l.derived(), detail::TensorExprScalar<Q>(x));
+    }
+
+    /// Elementwise negation
+    template <typename E>
+    detail::TensorExprUnary<detail::TensorExprNegate,E> operator-(const TensorExpr<E>& e) {
+        return detail::TensorExprUnary<detail::TensorExprNegate,E>(detail::TensorExprNegate(), e.derived());
+    }
+
+    /// Applies \c op to each element, \c op must be cheap to copy
+    template <typename opT, typename E>
+    detail::TensorExprUnary<opT,E> map(const TensorExpr<E>& e, const opT& op) {
+        return detail::TensorExprUnary<opT,E>(op, e.derived());
+    }
+
+    template <typename E>
+    template <typename Q>
+    auto TensorExpr<E>::scale(const Q& x) const {
+        return (*this)*x;
+    }
+
+    template <typename E>
+    template <typename F>
+    auto TensorExpr<E>::emul(const TensorExpr<F>& f) const {
+        return (*this)*f;
+    }
+
+    template <typename E>
+    template <typename Q, typename F>
+    auto TensorExpr<E>::gaxpy(const Q& alpha, const TensorExpr<F>& f, const Q& beta) const {
+        return (*this)*alpha + f*beta;
+    }
+
+    /// Assigns the expression to each element of \c t, which may appear in the expression
+
+    /// A contiguous \c t must not overlap any other tensor of the expression
+    /// except by appearing itself, e.g. as a shifted slice of the same data.
+    template <typename T, typename E>
+    Tensor<T>& assign(Tensor<T>& t, const TensorExpr<E>& e) {
+        const E& x = detail::tensor_expr_check(e);
+        TENSOR_ASSERT(t.BaseTensor::conforms(x.shape()), "tensor expression: result does not conform", t.ndim(), &t);
+        if (t.iscontiguous()) {
+            // t may appear in the expression, but an element of t is only
+            // read to compute the same element, so there is no dependence
+            // between iterations
+            T* p = t.ptr();
+            const long n = t.size();
+            MADNESS_PRAGMA_GCC(ivdep)
+            for (long i=0; i<n; ++i) p[i] = x[i];
+        }
+        else {
+            typedef typename E::value_type resultT;
+            Tensor<resultT> r(x.shape()->ndim(), x.shape()->dims(), false);
+            assign(r, e);
+            BINARY_OPTIMIZED_ITERATOR(T, t, const resultT, r, *_p0 = *_p1);
+        }
+        return t;
+    }
+
+    /// Returns a new contiguous tensor with the value of the expression
+    template <typename E>
+    Tensor<typename E::value_type> evaluate(const TensorExpr<E>& e) {
+        const E& x = detail::tensor_expr_check(e);
+        Tensor<typename E::value_type> r(x.shape()->ndim(), x.shape()->dims(), false);
+        return assign(r, e);
+    }
+
+}
+
+#endif // MADNESS_TENSOR_TENSOR_EXPR_H__INCLUDED
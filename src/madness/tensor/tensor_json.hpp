@@ -6,7 +6,15 @@
 #define MADNESS_TENSOR_JSON_H
 
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 // #include "catch.hpp"
 #include <madness/external/nlohmann_json/json.hpp>
@@ -37,24 +45,88 @@ nlohmann::json tensor_to_json(const Tensor<T>& m) {
     j["vals"] = m_vals_vector;
     j["dims"] = m_dims_vector;
 
-    print(j);
     return j;
 }
 
+/// Returns the numpy name of the element type of a tensor
+template<typename T>
+std::string tensor_json_dtype() {
+    typedef typename TensorTypeData<T>::scalar_type scalar_type;
+    const std::string kind = std::is_floating_point<scalar_type>::value
+            ? (TensorTypeData<T>::iscomplex ? "complex" : "float")
+            : (std::is_signed<scalar_type>::value ? "int" : "uint");
+    return kind + std::to_string(8*sizeof(T));
+}
+
+/// Returns true if this process stores numbers little-endian
+inline bool tensor_json_little_endian() {
+    const int one = 1;
+    return *reinterpret_cast<const char*>(&one) == 1;
+}
+
+/// Reverses the byte order of each scalar in a buffer
+inline void tensor_json_swap_bytes(std::vector<std::uint8_t>& bytes, const std::size_t nbyte) {
+    for (std::size_t i=0; i+nbyte<=bytes.size(); i+=nbyte) std::reverse(&bytes[i], &bytes[i+nbyte]);
+}
+
+/// Encodes a tensor with its elements as raw little-endian binary data
+
+/// The byte order is recorded in the field "byteorder" and checked when the
+/// tensor is read.  The elements are a JSON binary value, which text JSON can only write as a
+/// list of bytes but CBOR and MessagePack store as they are.  Use it with
+/// output_schema(..., true) for large tensors such as Fock matrices.
+template<typename T>
+nlohmann::json tensor_to_json_binary(const Tensor<T>& m) {
+    typedef typename TensorTypeData<T>::scalar_type scalar_type;
+    const Tensor<T> c = m.iscontiguous() ? m : copy(m);
+    const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(c.ptr());
+    std::vector<std::uint8_t> bytes(p, p + c.size()*sizeof(T));
+    if (!tensor_json_little_endian()) tensor_json_swap_bytes(bytes, sizeof(scalar_type));
+
+    nlohmann::json j = nlohmann::json{};
+    j["size"] = c.size();
+    j["dims"] = std::vector<long>(c.dims(), c.dims() + c.ndim());
+    j["dtype"] = tensor_json_dtype<T>();
+    j["byteorder"] = "little";
+    j["data"] = nlohmann::json::binary(std::move(bytes));
+    return j;
+}
+
+/// Decodes a tensor written by tensor_to_json or tensor_to_json_binary
 template<typename T>
 Tensor<T> tensor_from_json(const nlohmann::json& j) {
-    // need to be explicit here about types so we find the proper Tensor
-    // constructors
-    long size = j["size"];
-    std::vector<T> m_vals_vector = j["vals"];
-    std::vector<long> m_dims_vector = j["dims"];
-
-    Tensor<T> flat_m(size);
-    // copy the values from the vector to the flat tensor
-    std::copy(m_vals_vector.begin(), m_vals_vector.end(), &flat_m[0]);
-    // reshape the tensor using dimension vector
-    Tensor<T> m = flat_m.reshape(m_dims_vector);
-    return m;
+    if (j.contains("data")) {
+        typedef typename TensorTypeData<T>::scalar_type scalar_type;
+        MADNESS_CHECK_THROW(j["dtype"].get<std::string>() == tensor_json_dtype<T>(),
+                            "tensor_from_json: element type does not match");
+        MADNESS_CHECK_THROW(j.value("byteorder", std::string("little")) == "little",
+                            "tensor_from_json: binary data is not little-endian");
+        std::vector<long> dims = j["dims"];
+        if (dims.empty()) return Tensor<T>();
+        std::vector<std::uint8_t> bytes = j["data"].get_binary();
+        Tensor<T> m(dims, false);
+        MADNESS_CHECK_THROW(bytes.size() == m.size()*sizeof(T), "tensor_from_json: wrong size of binary data");
+        if (!tensor_json_little_endian()) tensor_json_swap_bytes(bytes, sizeof(scalar_type));
+        if (!bytes.empty()) std::memcpy(m.ptr(), bytes.data(), bytes.size());
+        return m;
+    }
+
+    if constexpr (TensorTypeData<T>::iscomplex) {
+        MADNESS_EXCEPTION("tensor_from_json: complex tensors are only stored in binary", 0);
+    } else {
+        // need to be explicit here about types so we find the proper Tensor
+        // constructors
+        long size = j["size"];
+        std::vector<T> m_vals_vector = j["vals"];
+        std::vector<long> m_dims_vector = j["dims"];
+
+        Tensor<T> flat_m(size);
+        // copy the values from the vector to the flat tensor
+        std::copy(m_vals_vector.begin(), m_vals_vector.end(), &flat_m[0]);
+        // reshape the tensor using dimension vector
+        Tensor<T> m = flat_m.reshape(m_dims_vector);
+        return m;
+    }
 }
 
 using vec_pair_ints = std::vector<std::pair<std::string, int>>;
@@ -79,10 +151,37 @@ void to_json(nlohmann::json& j, const vec_pair_T<T>& num_vals) {
     }
 }
 
+/// Writes a schema to schema_name.json, or as CBOR to schema_name.cbor if binary is true
+
+/// CBOR stores binary tensors from tensor_to_json_binary as they are and is
+/// much faster to parse than text.  Any stale file in the other format is
+/// removed so that input_schema finds the one just written.
 template<typename... Vecs>
-void output_schema(std::string schema_name, const nlohmann::json& j) {
-    std::ofstream ofs(schema_name + ".json");
-    ofs << j;
+void output_schema(std::string schema_name, const nlohmann::json& j, const bool binary=false) {
+    std::remove((schema_name + (binary ? ".json" : ".cbor")).c_str());
+    if (binary) {
+        const std::vector<std::uint8_t> cbor = nlohmann::json::to_cbor(j);
+        std::ofstream ofs(schema_name + ".cbor", std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(cbor.data()), cbor.size());
+    } else {
+        std::ofstream ofs(schema_name + ".json");
+        ofs << j;
+    }
+}
+
+/// Reads a schema written by output_schema, preferring the CBOR form when present
+
+/// Returns null if neither schema_name.cbor nor schema_name.json exists.
+inline nlohmann::json input_schema(std::string schema_name) {
+    std::ifstream cbor(schema_name + ".cbor", std::ios::binary);
+    if (cbor) {
+        return nlohmann::json::from_cbor(std::vector<std::uint8_t>((std::istreambuf_iterator<char>(cbor)),
+                                                                   std::istreambuf_iterator<char>()));
+    }
+    nlohmann::json j;
+    std::ifstream text(schema_name + ".json");
+    if (text) text >> j;
+    return j;
 }
 }
 
@@ -176,6 +176,120 @@ namespace madness {
     template <typename T>
     void orgqr(Tensor<T>& A, const Tensor<T>& tau);
 
+    /// \name Small matrices
+    /// The localizer, the low-rank tensors and the rank reduction of the
+    /// function coefficients decompose very many matrices of less than 64x64
+    /// elements, for which allocating the LAPACK work arrays and transposing
+    /// the input costs about as much as the decomposition.  The overloads
+    /// taking a LapackWorkspace reuse its arrays; the batched routines process
+    /// a vector of matrices on several threads, each with its own workspace.
+    ///@{
+
+    /// Work arrays for repeated LAPACK calls
+
+    /// The arrays grow to the largest size requested and are then reused.  A
+    /// workspace must not be used by two threads at once.  For complex types
+    /// the real work array of LAPACK is still allocated by each call.
+    template <typename T>
+    class LapackWorkspace {
+        std::vector<T> a_, work_;
+        std::vector<integer> iwork_;
+
+        template <typename Q>
+        static Q* reserve(std::vector<Q>& v, long n) {
+            if (long(v.size()) < n) v.resize(n);
+            return v.data();
+        }
+
+    public:
+        /// @return space for a copy of the input matrix, at least n elements
+        T* a(long n) {return reserve(a_,n);}
+
+        /// @return the work array, at least n elements
+        T* work(long n) {return reserve(work_,n);}
+
+        /// @return the integer work array, at least n elements
+        integer* iwork(long n) {return reserve(iwork_,n);}
+    };
+
+    /// svd() taking the work arrays from \c ws
+    template <typename T>
+    void svd(const Tensor<T>& a, Tensor<T>& U,
+             Tensor< typename Tensor<T>::scalar_type >& s, Tensor<T>& VT,
+             LapackWorkspace<T>& ws);
+
+    /// Singular value decomposition by one-sided Jacobi rotations
+
+    /// Same result as svd(), a = U * diag(s) * VT with the singular values in
+    /// descending order, but without the bidiagonalization of LAPACK, which
+    /// makes it faster for matrices with few rows or columns.  Rotations are
+    /// applied to the columns of a, or of its adjoint if it has more columns
+    /// than rows, until they are orthogonal to machine precision.
+    template <typename T>
+    void svd_jacobi(const Tensor<T>& a, Tensor<T>& U,
+                    Tensor< typename Tensor<T>::scalar_type >& s, Tensor<T>& VT,
+                    LapackWorkspace<T>& ws);
+
+    /// svd_jacobi() with a temporary workspace
+    template <typename T>
+    void svd_jacobi(const Tensor<T>& a, Tensor<T>& U,
+                    Tensor< typename Tensor<T>::scalar_type >& s, Tensor<T>& VT) {
+        LapackWorkspace<T> ws;
+        svd_jacobi(a,U,s,VT,ws);
+    }
+
+    /// syev() taking the work arrays from \c ws
+    template <typename T>
+    void syev(const Tensor<T>& A, Tensor<T>& V,
+              Tensor< typename Tensor<T>::scalar_type >& e, LapackWorkspace<T>& ws);
+
+    /// gesv() taking the work arrays from \c ws
+    template <typename T>
+    void gesv(const Tensor<T>& a, const Tensor<T>& b, Tensor<T>& x,
+              LapackWorkspace<T>& ws);
+
+    /// QR decomposition with column pivoting taking the work arrays from \c ws
+
+    /// On exit A holds R in its upper triangle and the Householder vectors
+    /// below, with tau their scale factors.  jpvt holds the Fortran (1-based)
+    /// index of the column of A moved to position i.
+    template <typename T>
+    void geqp3(Tensor<T>& A, Tensor<T>& tau, Tensor<integer>& jpvt,
+               LapackWorkspace<T>& ws);
+
+    /// svd_batched() uses svd_jacobi() for matrices with at most SVD_JACOBI_MAXDIM
+    /// rows or columns, and at most SVD_JACOBI_MAXLEN in the other dimension
+    static const long SVD_JACOBI_MAXDIM = 8;
+    static const long SVD_JACOBI_MAXLEN = 64;
+
+    /// Singular value decompositions of a vector of matrices on nthread threads
+
+    /// Small matrices are decomposed by svd_jacobi(), larger ones by LAPACK,
+    /// which is faster once the bidiagonalization pays off.  The threads are created for
+    /// this call, code running in the MADNESS thread pool should use one.
+    template <typename T>
+    void svd_batched(const std::vector< Tensor<T> >& a, std::vector< Tensor<T> >& U,
+                     std::vector< Tensor< typename Tensor<T>::scalar_type > >& s,
+                     std::vector< Tensor<T> >& VT, int nthread=1);
+
+    /// Eigenproblems of a vector of symmetric or Hermitian matrices on nthread threads
+    template <typename T>
+    void syev_batched(const std::vector< Tensor<T> >& A, std::vector< Tensor<T> >& V,
+                      std::vector< Tensor< typename Tensor<T>::scalar_type > >& e,
+                      int nthread=1);
+
+    /// Solves a[i] x[i] = b[i] for a vector of linear systems on nthread threads
+    template <typename T>
+    void gesv_batched(const std::vector< Tensor<T> >& a, const std::vector< Tensor<T> >& b,
+                      std::vector< Tensor<T> >& x, int nthread=1);
+
+    /// Pivoted QR decompositions of a vector of matrices on nthread threads, see geqp3()
+    template <typename T>
+    void geqp3_batched(std::vector< Tensor<T> >& A, std::vector< Tensor<T> >& tau,
+                       std::vector< Tensor<integer> >& jpvt, int nthread=1);
+
+    ///@}
+
 
     /// Dunno
     
@@ -0,0 +1,338 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/// \file tensor/tensor_pool.cc
+/// \brief Thread-caching pool for tensors of frequently used sizes
+
+#include <madness/tensor/tensor_pool.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace madness {
+
+    namespace detail {
+
+        static bool tensor_pool_initial_state() {
+            const char* env = std::getenv("MAD_TENSOR_POOL");
+            return !(env && std::strcmp(env, "0") == 0);
+        }
+
+        bool tensor_pool_enabled_flag = tensor_pool_initial_state();
+
+        static const int max_tensor_pool_classes = 64;
+        static const int max_magazine = 64;                         ///< Largest number of blocks in a magazine
+        static const std::size_t magazine_bytes = 512*1024;         ///< Bytes in a magazine of small blocks
+        static const std::size_t max_pool_block = 16*1024*1024;     ///< Larger blocks are never pooled
+
+        /// The size classes are only appended, so that they can be read without a lock
+        static std::atomic<std::size_t> pool_class_size[max_tensor_pool_classes];
+        static std::atomic<int> pool_class_capacity[max_tensor_pool_classes];
+        static std::atomic<int> pool_nclass{0};
+        static std::mutex pool_class_mutex;
+
+        static std::atomic<long> pool_hits{0}, pool_misses{0}, pool_unpooled{0}, pool_released{0};
+        static std::atomic<long> pool_depot_bytes{0};
+        static std::atomic<std::size_t> pool_limit{std::size_t(256)*1024*1024};
+
+        /// A stack of blocks of one size class
+        struct PoolMagazine {
+            int n = 0;
+            void* p[max_magazine];
+        };
+
+        /// Magazines exchanged between the threads of one size class
+        struct PoolDepot {
+            std::mutex mutex;
+            std::vector<PoolMagazine*> full;    ///< Magazines holding blocks
+            std::vector<PoolMagazine*> empty;
+        };
+
+        /// Never destroyed, since tensors may be freed during static destruction
+        static PoolDepot* pool_depots() {
+            static PoolDepot* depots = new PoolDepot[max_tensor_pool_classes];
+            return depots;
+        }
+
+        static int pool_class(std::size_t nbyte) {
+            const int n = pool_nclass.load(std::memory_order_acquire);
+            for (int c=0; c<n; ++c) {
+                if (pool_class_size[c].load(std::memory_order_relaxed) == nbyte) return c;
+            }
+            return -1;
+        }
+
+        static void* pool_system_allocate(std::size_t nbyte) {
+            void* p = 0;
+            if (posix_memalign(&p, TENSOR_POOL_ALIGNMENT, nbyte)) return 0;
+            return p;
+        }
+
+        /// Puts the magazine into the depot, or frees its blocks if the depot is full; call with the lock held
+        static void pool_deposit(PoolDepot& depot, PoolMagazine* m, std::size_t nbyte) {
+            const long bytes = m->n*nbyte;
+            if (m->n && pool_depot_bytes.load(std::memory_order_relaxed) + bytes <= long(pool_limit.load())) {
+                pool_depot_bytes += bytes;
+                depot.full.push_back(m);
+            }
+            else {
+                for (int i=0; i<m->n; ++i) std::free(m->p[i]);
+                pool_released += m->n;
+                m->n = 0;
+                depot.empty.push_back(m);
+            }
+        }
+
+        /// Two magazines per size class, the loaded one is used first
+        struct PoolThreadCache {
+            PoolMagazine* loaded[max_tensor_pool_classes] = {};
+            PoolMagazine* previous[max_tensor_pool_classes] = {};
+            long hits=0, misses=0, unpooled=0;
+            int nop=0;
+
+            void flush_counters() {
+                pool_hits += hits;
+                pool_misses += misses;
+                pool_unpooled += unpooled;
+                hits = misses = unpooled = nop = 0;
+            }
+
+            void count() {
+                if (++nop == 256) flush_counters();
+            }
+
+            void* allocate(int c, std::size_t nbyte) {
+                PoolMagazine*& l = loaded[c];
+                PoolMagazine*& pr = previous[c];
+                if (!(l && l->n) && pr && pr->n) std::swap(l, pr);
+                if (!(l && l->n)) {
+                    PoolDepot& depot = pool_depots()[c];
+                    std::lock_guard<std::mutex> lock(depot.mutex);
+                    if (depot.full.empty()) return 0;
+                    PoolMagazine* m = depot.full.back();
+                    depot.full.pop_back();
+                    pool_depot_bytes -= m->n*nbyte;
+                    if (pr) depot.empty.push_back(pr);
+                    pr = l;
+                    l = m;
+                }
+                return l->p[--l->n];
+            }
+
+            void deallocate(int c, void* p, std::size_t nbyte) {
+                const int capacity = pool_class_capacity[c].load(std::memory_order_relaxed);
+                PoolMagazine*& l = loaded[c];
+                PoolMagazine*& pr = previous[c];
+                if (!l) l = new PoolMagazine;
+                if (l->n == capacity) {
+                    if (!pr) pr = new PoolMagazine;
+                    if (pr->n < capacity) {
+                        std::swap(l, pr);
+                    }
+                    else {
+                        PoolMagazine* e = 0;
+                        {
+                            PoolDepot& depot = pool_depots()[c];
+                            std::lock_guard<std::mutex> lock(depot.mutex);
+                            pool_deposit(depot, pr, nbyte);
+                            if (!depot.empty.empty()) {
+                                e = depot.empty.back();
+                                depot.empty.pop_back();
+                            }
+                        }
+                        pr = l;
+                        l = e ? e : new PoolMagazine;
+                    }
+                }
+                l->p[l->n++] = p;
+            }
+
+            /// Returns the blocks to the depot
+            void flush() {
+                const int n = pool_nclass.load(std::memory_order_acquire);
+                for (int c=0; c<n; ++c) {
+                    const std::size_t nbyte = pool_class_size[c].load(std::memory_order_relaxed);
+                    PoolDepot& depot = pool_depots()[c];
+                    std::lock_guard<std::mutex> lock(depot.mutex);
+                    for (PoolMagazine** m : {&loaded[c], &previous[c]}) {
+                        if (*m) pool_deposit(depot, *m, nbyte);
+                        *m = 0;
+                    }
+                }
+                flush_counters();
+            }
+
+            /// Frees the blocks
+            void release() {
+                for (int c=0; c<max_tensor_pool_classes; ++c) {
+                    for (PoolMagazine* m : {loaded[c], previous[c]}) {
+                        if (!m) continue;
+                        for (int i=0; i<m->n; ++i) std::free(m->p[i]);
+                        pool_released += m->n;
+                        m->n = 0;
+                    }
+                }
+            }
+        };
+
+        // The cache is reached through a trivially destructible pointer, so that
+        // tensors freed after the thread's destructors have run still find out
+        // that it is gone.
+        static thread_local PoolThreadCache* pool_thread_cache = 0;
+        static thread_local bool pool_thread_exited = false;
+
+        struct PoolThreadCacheOwner {
+            ~PoolThreadCacheOwner() {
+                if (pool_thread_cache) {
+                    pool_thread_cache->flush();
+                    delete pool_thread_cache;
+                    pool_thread_cache = 0;
+                }
+                pool_thread_exited = true;
+            }
+        };
+        static thread_local PoolThreadCacheOwner pool_thread_cache_owner;
+
+        static PoolThreadCache* pool_cache() {
+            if (!pool_thread_cache && !pool_thread_exited) {
+                (void) &pool_thread_cache_owner; // registers the destructor
+                pool_thread_cache = new PoolThreadCache;
+            }
+            return pool_thread_cache;
+        }
+
+    } // namespace detail
+
+    void tensor_pool_enable() {
+        detail::tensor_pool_enabled_flag = true;
+    }
+
+    void tensor_pool_disable() {
+        detail::tensor_pool_enabled_flag = false;
+    }
+
+    bool tensor_pool_add_size(std::size_t nbyte) {
+        using namespace detail;
+        if (nbyte == 0 || nbyte > max_pool_block) return false;
+        std::lock_guard<std::mutex> lock(pool_class_mutex);
+        if (pool_class(nbyte) >= 0) return true;
+        const int n = pool_nclass.load();
+        if (n == max_tensor_pool_classes) return false;
+        const std::size_t capacity = magazine_bytes/nbyte;
+        pool_class_size[n] = nbyte;
+        pool_class_capacity[n] = (capacity < 1) ? 1 : ((capacity > std::size_t(max_magazine)) ? max_magazine : capacity);
+        pool_nclass.store(n+1, std::memory_order_release);
+        return true;
+    }
+
+    void* tensor_pool_allocate(std::size_t nbyte) {
+        using namespace detail;
+        const int c = tensor_pool_enabled() ? pool_class(nbyte) : -1;
+        PoolThreadCache* cache = pool_cache();
+        if (c >= 0) {
+            void* p = cache ? cache->allocate(c, nbyte) : 0;
+            if (cache) {
+                if (p) cache->hits++; else cache->misses++;
+                cache->count();
+            }
+            else {
+                pool_misses++;
+            }
+            if (p) return p;
+        }
+        else if (cache) {
+            cache->unpooled++;
+            cache->count();
+        }
+        else {
+            pool_unpooled++;
+        }
+        return pool_system_allocate(nbyte);
+    }
+
+    void tensor_pool_deallocate(void* p, std::size_t nbyte) {
+        using namespace detail;
+        if (!p) return;
+        // blocks are pooled even while the pool is disabled, all come from pool_system_allocate
+        const int c = pool_class(nbyte);
+        PoolThreadCache* cache = (c >= 0) ? pool_cache() : 0;
+        if (cache) {
+            cache->deallocate(c, p, nbyte);
+        }
+        else {
+            std::free(p);
+        }
+    }
+
+    TensorPoolInfo tensor_pool_statistics() {
+        using namespace detail;
+        if (pool_thread_cache) pool_thread_cache->flush_counters();
+        TensorPoolInfo info;
+        info.nclass = pool_nclass.load();
+        info.hits = pool_hits;
+        info.misses = pool_misses;
+        info.unpooled = pool_unpooled;
+        info.released = pool_released;
+        info.depot_bytes = pool_depot_bytes;
+        return info;
+    }
+
+    void tensor_pool_set_limit(std::size_t nbyte) {
+        detail::pool_limit = nbyte;
+    }
+
+    std::size_t tensor_pool_limit() {
+        return detail::pool_limit;
+    }
+
+    void tensor_pool_release() {
+        using namespace detail;
+        if (pool_thread_cache) pool_thread_cache->release();
+        const int n = pool_nclass.load(std::memory_order_acquire);
+        for (int c=0; c<n; ++c) {
+            const std::size_t nbyte = pool_class_size[c].load(std::memory_order_relaxed);
+            PoolDepot& depot = pool_depots()[c];
+            std::lock_guard<std::mutex> lock(depot.mutex);
+            for (PoolMagazine* m : depot.full) {
+                for (int i=0; i<m->n; ++i) std::free(m->p[i]);
+                pool_released += m->n;
+                pool_depot_bytes -= m->n*nbyte;
+                m->n = 0;
+                depot.empty.push_back(m);
+            }
+            depot.full.clear();
+        }
+    }
+
+}
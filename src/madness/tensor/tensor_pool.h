@@ -0,0 +1,155 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_TENSOR_TENSOR_POOL_H__INCLUDED
+#define MADNESS_TENSOR_TENSOR_POOL_H__INCLUDED
+
+/// \file tensor/tensor_pool.h
+/// \brief Thread-caching pool for tensors of frequently used sizes
+
+#include <madness/world/worldmem.h>
+#include <cstddef>
+#include <new>
+
+namespace madness {
+
+    /// \name Pool of tensor memory
+    /// Nearly all tensors in MRA hold k^d or (2k)^d elements.  Blocks of
+    /// these sizes, which are registered as size classes by
+    /// tensor_pool_add_size(), are kept for reuse instead of being returned
+    /// to the system.  Each thread caches blocks in two magazines per size
+    /// class, so most allocations and frees touch no shared state.  Full
+    /// and empty magazines are exchanged with a global depot under a lock,
+    /// which is also how blocks freed by another thread find their way back.
+    /// The depot holds at most tensor_pool_limit() bytes, blocks beyond that
+    /// are freed.
+    ///
+    /// The pool is enabled by default, setting the environment variable
+    /// \c MAD_TENSOR_POOL to 0 disables it.
+    ///@{
+
+    /// Alignment of all blocks handed out by the pool
+    static const std::size_t TENSOR_POOL_ALIGNMENT = 64;
+
+    /// Statistics of the tensor pool
+    struct TensorPoolInfo {
+        long nclass=0;          ///< Number of size classes
+        long hits=0;            ///< Allocations served from the pool
+        long misses=0;          ///< Allocations of a size class made by the system
+        long unpooled=0;        ///< Allocations of other sizes
+        long released=0;        ///< Blocks returned to the system because the depot was full
+        long depot_bytes=0;     ///< Bytes in the depot, not counting the thread caches
+
+        template <typename Archive>
+        void serialize(Archive& ar) {
+            ar & nclass & hits & misses & unpooled & released & depot_bytes;
+        }
+    };
+
+    namespace detail {
+        extern bool tensor_pool_enabled_flag;
+    }
+
+    /// enables the tensor pool
+    void tensor_pool_enable();
+    /// disables the tensor pool, blocks already cached stay until tensor_pool_release()
+    void tensor_pool_disable();
+    /// @return true if tensors of the registered sizes are allocated from the pool
+    inline bool tensor_pool_enabled() {
+        return detail::tensor_pool_enabled_flag;
+    }
+
+    /// registers blocks of nbyte bytes as a size class
+    /// @return false if the table of size classes is full or the blocks are too large
+    bool tensor_pool_add_size(std::size_t nbyte);
+
+    /// @return a block of nbyte bytes aligned to TENSOR_POOL_ALIGNMENT, or null if the system has no memory
+    void* tensor_pool_allocate(std::size_t nbyte);
+
+    /// returns a block obtained from tensor_pool_allocate() with the same nbyte
+    void tensor_pool_deallocate(void* p, std::size_t nbyte);
+
+    /// @return the statistics of the pool
+
+    /// The counters of other threads are merged every few hundred operations,
+    /// those of the calling thread are exact.
+    TensorPoolInfo tensor_pool_statistics();
+
+    /// sets the largest number of bytes held in the depot
+    void tensor_pool_set_limit(std::size_t nbyte);
+
+    /// @return the largest number of bytes held in the depot
+    std::size_t tensor_pool_limit();
+
+    /// returns the blocks in the depot and in the cache of the calling thread to the system
+    void tensor_pool_release();
+
+    /// Deleter of a tensor allocated from the pool, optionally accounted to a memory tag
+    struct TensorPoolDeleter {
+        std::size_t nbyte;
+        int tag;                ///< memory tag, or -1 if not accounted
+
+        template <typename T>
+        void operator()(T* p) const {
+            if (tag >= 0) memory_tag_deallocate(tag, nbyte);
+            tensor_pool_deallocate(p, nbyte);
+        }
+    };
+
+    /// Allocator for the control blocks of shared pointers to pooled tensors
+    template <typename T>
+    struct TensorPoolAllocator {
+        typedef T value_type;
+
+        TensorPoolAllocator() = default;
+        template <typename U> TensorPoolAllocator(const TensorPoolAllocator<U>&) {}
+
+        T* allocate(std::size_t n) {
+            static const bool registered = tensor_pool_add_size(sizeof(T));
+            (void) registered;
+            void* p = tensor_pool_allocate(n*sizeof(T));
+            if (!p) throw std::bad_alloc();
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, std::size_t n) {
+            tensor_pool_deallocate(p, n*sizeof(T));
+        }
+
+        template <typename U> bool operator==(const TensorPoolAllocator<U>&) const {return true;}
+        template <typename U> bool operator!=(const TensorPoolAllocator<U>&) const {return false;}
+    };
+
+    ///@}
+
+}
+
+#endif // MADNESS_TENSOR_TENSOR_POOL_H__INCLUDED
@@ -0,0 +1,90 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+#ifndef MADNESS_TENSOR_TENSOR_SIMD_H__INCLUDED
+#define MADNESS_TENSOR_TENSOR_SIMD_H__INCLUDED
+
+/// \file tensor/tensor_simd.h
+/// \brief Vectorized reductions and products of contiguous tensors
+
+/// The norms, traces and elementwise products of tensors are computed millions
+/// of times by norm_tree, truncate and inner.  For contiguous tensors of double
+/// and double_complex there are kernels that use vectors of the widest
+/// instruction set of the CPU, which are built and selected together with the
+/// mTxmq kernels (see mtxmq_kernels.h, \c MAD_MTXMQ_ISA).  Complex numbers are
+/// handled as interleaved pairs of doubles, so that the complex types vectorize
+/// as well as the real ones.
+///
+/// Each function returns false, and does nothing, if there is no kernel for
+/// the type; the caller then uses the generic iterators.  Sums are accumulated
+/// in several vectors, so that the rounding differs from a sequential sum.
+
+#include <complex>
+
+namespace madness {
+
+    /// Computes the sum of |p[i]|^2
+    bool tensor_simd_normsq(const double* p, long n, double& result);
+    bool tensor_simd_normsq(const std::complex<double>* p, long n, double& result);
+
+    /// Computes the sum of p[i]*p[i], without complex conjugate
+    bool tensor_simd_sumsq(const double* p, long n, double& result);
+    bool tensor_simd_sumsq(const std::complex<double>* p, long n, std::complex<double>& result);
+
+    /// Computes the largest |p[i]|
+    bool tensor_simd_absmax(const double* p, long n, double& result);
+    bool tensor_simd_absmax(const std::complex<double>* p, long n, double& result);
+
+    /// Computes the sum of a[i]*b[i], without complex conjugate
+    bool tensor_simd_trace(const double* a, const double* b, long n, double& result);
+    bool tensor_simd_trace(const std::complex<double>* a, const std::complex<double>* b, long n,
+                           std::complex<double>& result);
+
+    /// Computes a[i] *= b[i], a and b may be the same array
+    bool tensor_simd_emul(double* a, const double* b, long n);
+    bool tensor_simd_emul(std::complex<double>* a, const std::complex<double>* b, long n);
+
+    /// There are no kernels for other types
+    template <typename T, typename R>
+    inline bool tensor_simd_normsq(const T*, long, R&) {return false;}
+    template <typename T, typename R>
+    inline bool tensor_simd_sumsq(const T*, long, R&) {return false;}
+    template <typename T, typename R>
+    inline bool tensor_simd_absmax(const T*, long, R&) {return false;}
+    template <typename T, typename R>
+    inline bool tensor_simd_trace(const T*, const T*, long, R&) {return false;}
+    template <typename T>
+    inline bool tensor_simd_emul(T*, const T*, long) {return false;}
+
+}
+
+#endif // MADNESS_TENSOR_TENSOR_SIMD_H__INCLUDED
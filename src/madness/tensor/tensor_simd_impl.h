@@ -0,0 +1,281 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+#ifndef MADNESS_TENSOR_TENSOR_SIMD_IMPL_H__INCLUDED
+#define MADNESS_TENSOR_TENSOR_SIMD_IMPL_H__INCLUDED
+
+/// \file tensor/tensor_simd_impl.h
+/// \brief Internal use only ... the body of the vectorized tensor kernels
+
+// Like mtxmq_kernels_impl.h this is ONLY included into the mtxmq_*.cc files,
+// each compiled for one instruction set.
+
+#include <madness/tensor/mtxmq_kernels_impl.h>
+#include <madness/tensor/tensor_simd.h>
+
+namespace madness {
+
+    /// The vectorized kernels of one instruction set, complex numbers are pairs of doubles
+    struct TensorSimdKernels {
+        double (*sumsq)(const double* p, long n);                           ///< sum of p[i]^2
+        double (*absmax)(const double* p, long n);                          ///< largest |p[i]|
+        double (*zabsmax)(const double* p, long n);                         ///< largest |z|^2 of n complex z
+        double (*dot)(const double* a, const double* b, long n);            ///< sum of a[i]*b[i]
+        void (*zdot)(const double* a, const double* b, long n, double* r);  ///< the same for n complex
+        void (*emul)(double* a, const double* b, long n);                   ///< a[i] *= b[i]
+        void (*zemul)(double* a, const double* b, long n);                  ///< the same for n complex
+    };
+
+    namespace {
+
+        /// Number of vectors accumulated in parallel, to hide the latency of the additions
+        static const long SIMD_NACC = 4;
+
+        /// Vector of W indices for __builtin_shuffle
+        template <long W> struct simd_mask;
+        template <> struct simd_mask<2> {typedef long type __attribute__((vector_size(16)));};
+        template <> struct simd_mask<4> {typedef long type __attribute__((vector_size(32)));};
+        template <> struct simd_mask<8> {typedef long type __attribute__((vector_size(64)));};
+
+        template <long W>
+        struct simd_types {
+            typedef typename mtxmq_vector<W>::type vecT;
+            typedef typename mtxmq_vector<W>::unaligned uvecT;
+            typedef typename simd_mask<W>::type maskT;
+
+            static vecT load(const double* p) {return *reinterpret_cast<const uvecT*>(p);}
+            static void store(double* p, const vecT& v) {*reinterpret_cast<uvecT*>(p) = v;}
+
+            /// Swaps the real and imaginary parts
+            static vecT swap(const vecT& v) {
+                maskT m;
+                for (long j=0; j<W; ++j) m[j] = j^1;
+                return __builtin_shuffle(v, m);
+            }
+
+            /// Copies the real (odd=0) or imaginary (odd=1) parts to both
+            static vecT dup(const vecT& v, long odd) {
+                maskT m;
+                for (long j=0; j<W; ++j) m[j] = (j&~1L) + odd;
+                return __builtin_shuffle(v, m);
+            }
+
+            static double sum(const vecT& v) {
+                double s = 0.0;
+                for (long j=0; j<W; ++j) s += v[j];
+                return s;
+            }
+
+            static double max(const vecT& v) {
+                double s = v[0];
+                for (long j=1; j<W; ++j) s = (s > v[j]) ? s : v[j];
+                return s;
+            }
+        };
+
+        template <long W>
+        double simd_sumsq(const double* MADNESS_RESTRICT p, long n) {
+            typedef simd_types<W> S;
+            typename S::vecT acc[SIMD_NACC] = {};
+            long i = 0;
+            for (; i+SIMD_NACC*W<=n; i+=SIMD_NACC*W) {
+#pragma GCC unroll 4
+                for (long u=0; u<SIMD_NACC; ++u) {
+                    const typename S::vecT x = S::load(p+i+u*W);
+                    acc[u] += x*x;
+                }
+            }
+            for (; i+W<=n; i+=W) {
+                const typename S::vecT x = S::load(p+i);
+                acc[0] += x*x;
+            }
+            double s = S::sum((acc[0] + acc[1]) + (acc[2] + acc[3]));
+            for (; i<n; ++i) s += p[i]*p[i];
+            return s;
+        }
+
+        template <long W>
+        double simd_absmax(const double* MADNESS_RESTRICT p, long n) {
+            typedef simd_types<W> S;
+            typename S::vecT acc[SIMD_NACC] = {};
+            long i = 0;
+            for (; i+SIMD_NACC*W<=n; i+=SIMD_NACC*W) {
+#pragma GCC unroll 4
+                for (long u=0; u<SIMD_NACC; ++u) {
+                    const typename S::vecT x = S::load(p+i+u*W);
+                    const typename S::vecT a = (x < 0.0) ? -x : x;
+                    acc[u] = (acc[u] > a) ? acc[u] : a;
+                }
+            }
+            for (; i+W<=n; i+=W) {
+                const typename S::vecT x = S::load(p+i);
+                const typename S::vecT a = (x < 0.0) ? -x : x;
+                acc[0] = (acc[0] > a) ? acc[0] : a;
+            }
+            for (long u=1; u<SIMD_NACC; ++u) acc[0] = (acc[0] > acc[u]) ? acc[0] : acc[u];
+            double s = S::max(acc[0]);
+            for (; i<n; ++i) {
+                const double a = (p[i] < 0.0) ? -p[i] : p[i];
+                s = (s > a) ? s : a;
+            }
+            return s;
+        }
+
+        template <long W>
+        double simd_zabsmax(const double* MADNESS_RESTRICT p, long n) {
+            typedef simd_types<W> S;
+            typename S::vecT acc[SIMD_NACC] = {};
+            const long nd = 2*n;
+            long i = 0;
+            for (; i+SIMD_NACC*W<=nd; i+=SIMD_NACC*W) {
+#pragma GCC unroll 4
+                for (long u=0; u<SIMD_NACC; ++u) {
+                    const typename S::vecT x = S::load(p+i+u*W);
+                    const typename S::vecT x2 = x*x;
+                    const typename S::vecT a = x2 + S::swap(x2);
+                    acc[u] = (acc[u] > a) ? acc[u] : a;
+                }
+            }
+            for (; i+W<=nd; i+=W) {
+                const typename S::vecT x = S::load(p+i);
+                const typename S::vecT x2 = x*x;
+                const typename S::vecT a = x2 + S::swap(x2);
+                acc[0] = (acc[0] > a) ? acc[0] : a;
+            }
+            for (long u=1; u<SIMD_NACC; ++u) acc[0] = (acc[0] > acc[u]) ? acc[0] : acc[u];
+            double s = S::max(acc[0]);
+            for (; i<nd; i+=2) {
+                const double a = p[i]*p[i] + p[i+1]*p[i+1];
+                s = (s > a) ? s : a;
+            }
+            return s;
+        }
+
+        template <long W>
+        double simd_dot(const double* MADNESS_RESTRICT a, const double* MADNESS_RESTRICT b, long n) {
+            typedef simd_types<W> S;
+            typename S::vecT acc[SIMD_NACC] = {};
+            long i = 0;
+            for (; i+SIMD_NACC*W<=n; i+=SIMD_NACC*W) {
+#pragma GCC unroll 4
+                for (long u=0; u<SIMD_NACC; ++u) acc[u] += S::load(a+i+u*W)*S::load(b+i+u*W);
+            }
+            for (; i+W<=n; i+=W) acc[0] += S::load(a+i)*S::load(b+i);
+            double s = S::sum((acc[0] + acc[1]) + (acc[2] + acc[3]));
+            for (; i<n; ++i) s += a[i]*b[i];
+            return s;
+        }
+
+        template <long W>
+        void simd_zdot(const double* MADNESS_RESTRICT a, const double* MADNESS_RESTRICT b, long n, double* r) {
+            // the even lanes of rr hold ar*br and the odd ones ai*bi, all lanes of ri add to the imaginary part
+            typedef simd_types<W> S;
+            typename S::vecT rr[2] = {}, ri[2] = {};
+            const long nd = 2*n;
+            long i = 0;
+            for (; i+2*W<=nd; i+=2*W) {
+#pragma GCC unroll 2
+                for (long u=0; u<2; ++u) {
+                    const typename S::vecT x = S::load(a+i+u*W), y = S::load(b+i+u*W);
+                    rr[u] += x*y;
+                    ri[u] += x*S::swap(y);
+                }
+            }
+            for (; i+W<=nd; i+=W) {
+                const typename S::vecT x = S::load(a+i), y = S::load(b+i);
+                rr[0] += x*y;
+                ri[0] += x*S::swap(y);
+            }
+            const typename S::vecT sr = rr[0] + rr[1];
+            double re = 0.0;
+            for (long j=0; j<W; j+=2) re += sr[j] - sr[j+1];
+            double im = S::sum(ri[0] + ri[1]);
+            for (; i<nd; i+=2) {
+                re += a[i]*b[i] - a[i+1]*b[i+1];
+                im += a[i]*b[i+1] + a[i+1]*b[i];
+            }
+            r[0] = re;
+            r[1] = im;
+        }
+
+        // a and b may be the same array, as in t.emul(t), so they are not restrict
+        template <long W>
+        void simd_emul(double* a, const double* b, long n) {
+            typedef simd_types<W> S;
+            long i = 0;
+            for (; i+W<=n; i+=W) S::store(a+i, S::load(a+i)*S::load(b+i));
+            for (; i<n; ++i) a[i] *= b[i];
+        }
+
+        template <long W>
+        void simd_zemul(double* a, const double* b, long n) {
+            // (ar + i ai)*(br + i bi) = (ar*br - ai*bi) + i (ar*bi + ai*br)
+            typedef simd_types<W> S;
+            typename S::vecT sign;
+            for (long j=0; j<W; ++j) sign[j] = (j&1) ? 1.0 : -1.0;
+            const long nd = 2*n;
+            long i = 0;
+            for (; i+W<=nd; i+=W) {
+                const typename S::vecT x = S::load(a+i), y = S::load(b+i);
+                S::store(a+i, S::dup(x,0)*y + S::dup(x,1)*S::swap(y)*sign);
+            }
+            for (; i<nd; i+=2) {
+                const double re = a[i]*b[i] - a[i+1]*b[i+1];
+                const double im = a[i]*b[i+1] + a[i+1]*b[i];
+                a[i] = re;
+                a[i+1] = im;
+            }
+        }
+
+        /// Fills the kernels for vectors of W doubles
+        template <long W>
+        void tensor_simd_fill_table(TensorSimdKernels& k) {
+            k.sumsq = &simd_sumsq<W>;
+            k.absmax = &simd_absmax<W>;
+            k.zabsmax = &simd_zabsmax<W>;
+            k.dot = &simd_dot<W>;
+            k.zdot = &simd_zdot<W>;
+            k.emul = &simd_emul<W>;
+            k.zemul = &simd_zemul<W>;
+        }
+
+    }
+
+    namespace detail {
+        /// Fills the vectorized kernels, one function per instruction set
+        void tensor_simd_fill_generic(TensorSimdKernels& k);
+        void tensor_simd_fill_avx2(TensorSimdKernels& k);
+        void tensor_simd_fill_avx512(TensorSimdKernels& k);
+    }
+}
+
+#endif // MADNESS_TENSOR_TENSOR_SIMD_IMPL_H__INCLUDED
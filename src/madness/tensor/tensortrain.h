@@ -1056,6 +1056,17 @@ namespace madness {
 		    if (not verify()) MADNESS_EXCEPTION("ranks in TensorTrain inconsistent",1);
 		}
 
+		/// this = alpha*this + beta*rhs, truncated to eps without forming the sum first
+
+		/// see round_sum()
+		/// @param[in]	eps	the truncation threshold
+		template<typename R=T>
+		typename std::enable_if<std::is_arithmetic<R>::value, TensorTrain<T>&>::type
+		gaxpy_truncate(T alpha, const TensorTrain<T>& rhs, T beta, double eps) {
+		    *this=round_sum(std::vector<TensorTrain<T> >{*this,rhs},std::vector<T>{alpha,beta},eps);
+		    return *this;
+		}
+
 //		/// return the number of dimensions
 //		long ndim() const {return core.size();}
 
@@ -1605,6 +1616,153 @@ public:
     }
 
 
+    /// sum of tensor trains, truncated to the accuracy eps without forming the sum
+
+    /// Randomized rounding (randomize-then-orthogonalize) as described in
+    /// H. Al Daas et al., SIAM J. Sci. Comput. 45, A74 (2023): the sum is
+    /// contracted with a random tensor train whose ranks exceed the largest
+    /// ranks of the addends by \c oversampling, which gives orthonormal bases
+    /// for the ranges of all unfoldings of the sum in one left-to-right sweep.
+    /// The addends enter the sweep separately, so that the cores of the sum,
+    /// whose ranks are the sums of the ranks of the addends, are never formed.
+    /// The result is then truncated by TensorTrain::truncate().
+    ///
+    /// If the truncated ranks come close to the ranks of the random tensor
+    /// train the sketch may have missed part of the range; in that case, and
+    /// if the sketch would not reduce the ranks, the sum is formed and
+    /// truncated as usual.
+    /// @param[in]  addends     tensor trains (not operators) of the same dimensions
+    /// @param[in]  factors     the factors of the addends
+    /// @param[in]  eps         the truncation threshold
+    /// @param[in]  oversampling    the number of additional random vectors
+    /// @return a new tensor train
+    template<typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value, TensorTrain<T> >::type
+    round_sum(const std::vector<TensorTrain<T> >& addends, const std::vector<T>& factors,
+            const double eps, const long oversampling=12) {
+
+        MADNESS_ASSERT(addends.size()==factors.size());
+        if (addends.size()==0) return TensorTrain<T>();
+        const TensorTrain<T>& ref=addends.front();
+        const long nd=ref.ndim();
+
+        // skip zero addends
+        std::vector<const TensorTrain<T>*> a;
+        std::vector<T> f;
+        for (std::size_t i=0; i<addends.size(); ++i) {
+            MADNESS_ASSERT(addends[i].ndim()==nd);
+            for (long d=0; d<nd; ++d) MADNESS_ASSERT(addends[i].dim(d)==ref.dim(d));
+            if (addends[i].is_zero_rank() or (factors[i]==T(0.0))) continue;
+            MADNESS_ASSERT(addends[i].is_tensor());
+            a.push_back(&addends[i]);
+            f.push_back(factors[i]);
+        }
+        if (a.size()==0) return TensorTrain<T>(nd,ref.dims());
+
+        // the deterministic algorithm
+        auto sum_and_truncate=[&]() {
+            TensorTrain<T> result=copy(*a[0]);
+            result.scale(f[0]);
+            for (std::size_t i=1; i<a.size(); ++i) result.gaxpy(1.0,*a[i],f[i]);
+            result.truncate(eps);
+            return result;
+        };
+        if (nd==1) return sum_and_truncate();
+
+        // ranks of the random tensor train: the largest rank of the addends
+        // plus oversampling, but not more than the rank of the sum
+        std::vector<long> l(nd+1,1), rsum(nd-1,0), lmax(nd-1);
+        bool reduces=false;
+        for (long d=0; d<nd-1; ++d) {
+            long rmax=0;
+            for (auto t : a) {
+                rmax=std::max(rmax,t->ranks(d));
+                rsum[d]+=t->ranks(d);
+            }
+            long kleft=1, kright=1;
+            for (long i=0; i<=d; ++i) kleft*=ref.dim(i);
+            for (long i=d+1; i<nd; ++i) kright*=ref.dim(i);
+            lmax[d]=std::min({rsum[d],kleft,kright});
+            l[d+1]=std::min(rmax+oversampling,lmax[d]);
+            if (l[d+1]<rsum[d]) reduces=true;
+        }
+        if (not reduces) return sum_and_truncate();
+
+        // core d as a 3-index tensor (r0,k,r1), with r0=1 for the first and r1=1 for the last core
+        auto core3=[nd](const TensorTrain<T>& t, const long d) {
+            const Tensor<T>& c=t.get_core(d);
+            const Tensor<T> cc=c.iscontiguous() ? c : copy(c);
+            if (d==0) return cc.reshape(1,c.dim(0),c.dim(1));
+            if (d==nd-1) return cc.reshape(c.dim(0),c.dim(1),1);
+            return cc;
+        };
+
+        // random tensor train with cores (l[d],k,l[d+1])
+        std::vector<Tensor<T> > y(nd);
+        for (long d=0; d<nd; ++d) {
+            y[d]=Tensor<T>(l[d],ref.dim(d),l[d+1]);
+            y[d].fillrandom();
+            y[d]-=0.5;
+        }
+
+        // contractions of the addends with the random tensor train from the right,
+        // w[i][d] has the shape (r[d-1],l[d]) and contains the cores d..nd-1
+        std::vector<std::vector<Tensor<T> > > w(a.size(),std::vector<Tensor<T> >(nd+1));
+        for (std::size_t i=0; i<a.size(); ++i) {
+            w[i][nd]=Tensor<T>(1,1);
+            w[i][nd]=1.0;
+            for (long d=nd-1; d>0; --d) {
+                const Tensor<T> c=core3(*a[i],d);
+                const long r0=c.dim(0), k=c.dim(1);
+                Tensor<T> tmp=inner(c,w[i][d+1],2,0);                 // (r0,k,l[d+1])
+                w[i][d]=inner(tmp.reshape(r0,k*l[d+1]),y[d].reshape(l[d],k*l[d+1]),1,1);
+            }
+        }
+
+        // left-to-right sweep: project the partial products of the sum onto the
+        // orthonormal range of their contraction with the random tensor train;
+        // m[i] maps the new rank index onto the rank index of addend i
+        std::vector<Tensor<T> > m(a.size()), result_core(nd);
+        for (std::size_t i=0; i<a.size(); ++i) {
+            m[i]=Tensor<T>(1,1);
+            m[i]=f[i];
+        }
+        std::vector<Tensor<T> > c(a.size());
+        for (long d=0; d<nd-1; ++d) {
+            const long q=m[0].dim(0), k=ref.dim(d);
+            Tensor<T> z(q,k,l[d+1]);
+            for (std::size_t i=0; i<a.size(); ++i) {
+                c[i]=inner(m[i],core3(*a[i],d),1,0);                   // (q,k,r1)
+                z+=inner(c[i],w[i][d+1],2,0);
+            }
+            z=z.reshape(q*k,l[d+1]);
+            Tensor<T> r;
+            qr(z,r);
+            const long qnew=z.dim(1);
+            for (std::size_t i=0; i<a.size(); ++i) {
+                m[i]=inner(z,c[i].reshape(q*k,c[i].dim(2)),0,0);      // (qnew,r1)
+            }
+            result_core[d]=(d==0) ? z.reshape(k,qnew) : z.reshape(q,k,qnew);
+        }
+        {
+            const long q=m[0].dim(0), k=ref.dim(nd-1);
+            Tensor<T> last(q,k);
+            for (std::size_t i=0; i<a.size(); ++i) last+=inner(m[i],a[i]->get_core(nd-1));
+            result_core[nd-1]=last;
+        }
+
+        TensorTrain<T> result(result_core);
+        result.truncate(eps);
+
+        // fall back if the sketch was possibly too small
+        const std::vector<long> r=result.ranks();
+        for (long d=0; d<nd-1; ++d) {
+            if ((l[d+1]<lmax[d]) and (r[d]>=l[d+1]-oversampling/2)) return sum_and_truncate();
+        }
+        return result;
+    }
+
+
     /// compute the n-D identity operator with k elements per dimension
     template<typename T>
     TensorTrain<T> tt_identity(const long ndim, const long k) {
@@ -92,6 +92,46 @@ void mTxm(long dimi, long dimj, long dimk,
     }
 }
 
+template <typename T>
+T ran_value() {return T(ran()-0.5);}
+
+template <>
+double_complex ran_value<double_complex>() {return double_complex(ran()-0.5, ran()-0.5);}
+
+/// Checks the kernels of every supported instruction set against the reference, with ldb >= dimj
+template <typename T>
+void test_kernels(const char* type) {
+    const long nimax=13*13, nkmax=2*MTXMQ_MAX_DIMJ+1, ldb=MTXMQ_MAX_DIMJ+3;
+    std::vector<T> a(nkmax*nimax), b(nkmax*ldb), c(nimax*MTXMQ_MAX_DIMJ), d(nimax*MTXMQ_MAX_DIMJ);
+    for (T& x : a) x = ran_value<T>();
+    for (T& x : b) x = ran_value<T>();
+
+    const MtxmqISA selected = mtxmq_isa();
+    for (MtxmqISA isa : {MtxmqISA::Generic, MtxmqISA::AVX2, MtxmqISA::AVX512}) {
+        if (!mtxmq_isa_supported(isa)) continue;
+        set_mtxmq_isa(isa);
+        double maxerr = 0.0;
+        for (long ni : {1L, 2L, 3L, 5L, 7L, 36L, 100L, 121L, nimax}) {
+            for (long nj=1; nj<=MTXMQ_MAX_DIMJ; ++nj) {
+                for (long nk : {0L, 1L, 2L, 6L, 7L, 12L, 13L, 24L, nkmax}) {
+                    for (long lb : {nj, ldb}) {
+                        for (long i=0; i<ni*nj; ++i) d[i] = c[i] = T(1e10);
+                        mTxmq_reference(ni,nj,nk,c.data(),a.data(),b.data(),lb);
+                        mTxmq(ni,nj,nk,d.data(),a.data(),b.data(),lb);
+                        for (long i=0; i<ni*nj; ++i) maxerr = std::max(maxerr, double(std::abs(d[i]-c[i])));
+                    }
+                }
+            }
+        }
+        printf("test_mtxmq: %-8s kernels %-14s max error %.1e\n", mtxmq_isa_name(isa), type, maxerr);
+        if (maxerr > 1e-12) {
+            printf("test_mtxmq: kernel error\n");
+            exit(1);
+        }
+    }
+    set_mtxmq_isa(selected);
+}
+
 void crap(double rate, double fastest, double start) {
     if (rate == 0) printf("darn compiler bug %e %e %lf\n",rate,fastest,start);
 }
@@ -225,6 +265,11 @@ int main(int argc, char * argv[]) {
     }
     printf("... OK!\n");
 
+    printf("Testing the kernels of each instruction set, %s in use ...\n", mtxmq_isa_name(mtxmq_isa()));
+    test_kernels<double>("double");
+    test_kernels<double_complex>("double_complex");
+    printf("... OK!\n");
+
     if (!smalltest) {
         printf("%20s %3s %3s %3s %8s %8s (GF/s)\n", "type", "M", "N", "K", "LOOP", "BLAS");
         for (ni=2; ni<60; ni+=2) timer("(m*m)T*(m*m)", ni,ni,ni,a,b,c);
@@ -33,6 +33,11 @@
 /// \brief New test code for Tensor class using Google unit test
 
 #include <madness/tensor/tensor.h>
+#include <madness/tensor/tensor_expr.h>
+#include <madness/tensor/blocksparse_tensor.h>
+#include <madness/tensor/mtxmq_kernels.h>
+#include <madness/tensor/quantized_tensor.h>
+#include <madness/tensor/tensor_json.hpp>
 #include <madness/world/print.h>
 
 #ifdef MADNESS_HAS_GOOGLE_TEST
@@ -45,6 +50,7 @@ using madness::___;
 using madness::_reverse;
 
 #include <iostream>
+#include <thread>
 #include <gtest/gtest.h>
 
 namespace {
@@ -415,6 +421,298 @@ namespace {
         ITERATOR3(b,ASSERT_EQ(b(_i,_j,_k), a(_j,_i,_k)));
     }
 
+    TEST(TensorMemoryTagTest, Scope) {
+        madness::memory_tags_enable();
+        const int tag = madness::memory_tag_id("test_tensor");
+        EXPECT_EQ(tag, madness::memory_tag_id("test_tensor"));
+        auto find = [](const std::string& name) {
+            for (const auto& info : madness::memory_tag_statistics()) if (info.name==name) return info;
+            return madness::MemoryTagInfo();
+        };
+        {
+            madness::MemoryTagScope scope(tag);
+            EXPECT_EQ(madness::memory_tag_current(), tag);
+            madness::Tensor<double> a(10,10);
+            madness::Tensor<double> b(5);
+            EXPECT_EQ(find("test_tensor").cur_bytes, 105*sizeof(double));
+        }
+        EXPECT_EQ(madness::memory_tag_current(), 0);
+        madness::Tensor<double> c(1000);
+        madness::MemoryTagInfo info = find("test_tensor");
+        EXPECT_EQ(info.cur_bytes, 0);
+        EXPECT_EQ(info.max_bytes, 105*sizeof(double));
+        EXPECT_EQ(info.nalloc, 2);
+
+        // a tag that still holds memory is reported after a reset
+        madness::Tensor<double> d;
+        {
+            madness::MemoryTagScope scope(tag);
+            d = madness::Tensor<double>(7);
+        }
+        madness::memory_tag_reset();
+        info = find("test_tensor");
+        EXPECT_EQ(info.name, "test_tensor");
+        EXPECT_EQ(info.cur_bytes, 7*sizeof(double));
+        EXPECT_EQ(info.max_bytes, 7*sizeof(double));
+        EXPECT_EQ(info.nalloc, 0);
+        d = madness::Tensor<double>();
+        EXPECT_EQ(find("test_tensor").cur_bytes, 0);
+        madness::memory_tags_disable();
+    }
+
+    TEST(TensorPoolTest, Reuse) {
+        if (!madness::tensor_pool_enabled()) return;
+        EXPECT_TRUE(madness::tensor_pool_add_size(9*9*9*sizeof(double)));
+        madness::TensorPoolInfo before = madness::tensor_pool_statistics();
+        // each tensor also allocates the control block of its shared pointer from the pool
+        for (int i=0; i<10; ++i) madness::Tensor<double> a(9,9,9);
+        madness::TensorPoolInfo after = madness::tensor_pool_statistics();
+        EXPECT_GE(after.hits - before.hits, 18);
+        EXPECT_LE(after.misses - before.misses, 2);
+
+        // blocks freed by one thread, or cached by a thread that exits, are reused by others
+        std::vector< madness::Tensor<double> > v(200);
+        std::thread([&v]() {
+            for (auto& t : v) t = madness::Tensor<double>(9,9,9);
+            std::vector< madness::Tensor<double> > w(200);
+            for (auto& t : w) t = madness::Tensor<double>(9,9,9);
+        }).join();
+        before = madness::tensor_pool_statistics();
+        v.clear();
+        for (int i=0; i<400; ++i) v.push_back(madness::Tensor<double>(9,9,9));
+        after = madness::tensor_pool_statistics();
+        EXPECT_GE(after.hits - before.hits, 400);
+        EXPECT_EQ(after.misses - before.misses, 0);
+        for (const auto& t : v) EXPECT_EQ(t.normf(), 0.0);
+
+        // other sizes are not pooled
+        before = madness::tensor_pool_statistics();
+        madness::Tensor<double> b(9,9,8);
+        EXPECT_EQ(madness::tensor_pool_statistics().unpooled - before.unpooled, 1);
+
+        v.clear();
+        madness::tensor_pool_release();
+        EXPECT_EQ(madness::tensor_pool_statistics().depot_bytes, 0);
+    }
+
+    TEST(QuantizedTensorTest, ErrorBound) {
+        // decaying coefficients as in a smooth function
+        madness::Tensor<double> a(10,10,10);
+        a.fillrandom();
+        ITERATOR3(a, a(_i,_j,_k) *= std::pow(0.1,_i+_j+_k));
+        for (double tol : {1e-4, 1e-8, 1e-12}) {
+            madness::QuantizedTensor<double> q(a, tol);
+            EXPECT_LE(q.error(), tol);
+            EXPECT_LE((q.decode()-a).normf(), tol);
+            EXPECT_LT(q.nbyte(), a.size()*sizeof(double)/2);
+        }
+
+        madness::Tensor<double_complex> z(6,6);
+        z.fillrandom();
+        madness::QuantizedTensor<double_complex> qz(z, 1e-6);
+        EXPECT_LE((qz.decode()-z).normf(), 1e-6);
+
+        // a zero tolerance keeps the elements exactly
+        madness::QuantizedTensor<double> exact(a, 0.0);
+        EXPECT_EQ((exact.decode()-a).normf(), 0.0);
+        EXPECT_FALSE(madness::QuantizedTensor<double>().decode().has_data());
+    }
+
+    TEST(TensorJsonTest, Binary) {
+        madness::Tensor<double> a(7,5);
+        a.fillrandom();
+        madness::Tensor<double_complex> z(4,3,2);
+        z.fillrandom();
+
+        nlohmann::json j;
+        j["a"] = madness::tensor_to_json_binary(a);
+        j["z"] = madness::tensor_to_json_binary(z(madness::_,madness::Slice(0,1),madness::_));
+        j["t"] = madness::tensor_to_json(a);
+        EXPECT_EQ(j["z"]["dtype"], "complex128");
+
+        madness::output_schema("test_tensor_json", j, true);
+        const nlohmann::json k = madness::input_schema("test_tensor_json");
+        std::remove("test_tensor_json.cbor");
+        EXPECT_EQ((madness::tensor_from_json<double>(k["a"])-a).normf(), 0.0);
+        EXPECT_EQ((madness::tensor_from_json<double>(k["t"])-a).normf(), 0.0);
+        const madness::Tensor<double_complex> zz = madness::tensor_from_json<double_complex>(k["z"]);
+        EXPECT_EQ((zz-z(madness::_,madness::Slice(0,1),madness::_)).normf(), 0.0);
+        EXPECT_THROW(madness::tensor_from_json<float>(k["a"]), madness::MadnessException);
+        EXPECT_EQ(k["a"]["byteorder"], "little");
+        nlohmann::json big = k["a"];
+        big["byteorder"] = "big";
+        EXPECT_THROW(madness::tensor_from_json<double>(big), madness::MadnessException);
+    }
+
+    TEST(TransformBatchTest, MatchesFastTransform) {
+        // small tensors are transformed as one batch, large ones in a loop
+        for (std::pair<long,long> shape : {std::make_pair(1L,7L), std::make_pair(3L,4L), std::make_pair(3L,7L), std::make_pair(6L,4L)}) {
+            const long ndim = shape.first, k = shape.second;
+            std::vector<long> dims(ndim, k);
+            madness::Tensor<double> c(k,k);
+            c.fillrandom();
+            std::vector< madness::Tensor<double_complex> > t(5);
+            for (long n : {0, 1, 3, 4}) {
+                t[n] = madness::Tensor<double_complex>(dims);
+                t[n].fillrandom();
+            }
+            const std::vector< madness::Tensor<double_complex> > r = madness::transform_batch(t, c);
+            ASSERT_EQ(r.size(), t.size());
+            EXPECT_EQ(r[2].size(), 0);
+            for (long n : {0, 1, 3, 4}) {
+                EXPECT_TRUE(r[n].conforms(t[n]));
+                EXPECT_LT((r[n]-madness::transform(t[n],c)).normf(), 1e-12*r[n].normf());
+            }
+        }
+        EXPECT_TRUE(madness::transform_batch(std::vector< madness::Tensor<double> >(3), madness::Tensor<double>(2,2))[1].size() == 0);
+    }
+
+    TEST(TensorExprTest, MatchesEager) {
+        madness::Tensor<double> c(6,5,4), x(6,5,4), y(6,5,4);
+        c.fillrandom(); x.fillrandom(); y.fillrandom();
+        const double a = 0.5, b = -2.0;
+
+        madness::Tensor<double> r = madness::evaluate(madness::lazy(c).gaxpy(a, madness::lazy(x), b).emul(madness::lazy(y)));
+        madness::Tensor<double> s = copy(c).gaxpy(a, x, b).emul(y);
+        EXPECT_LT((r-s).normf(), 1e-14*s.normf());
+
+        // in place, and with a unary function and a scalar
+        madness::Tensor<double> t = copy(c);
+        madness::assign(t, madness::map(-madness::lazy(t) + madness::lazy(x)*3.0 - 1.0, [](double v) {return v*v;}));
+        s = copy(x).scale(3.0) - c - 1.0;
+        s.emul(s);
+        EXPECT_LT((t-s).normf(), 1e-14*s.normf());
+
+        // mixed types give the type of the eager operations
+        madness::Tensor<double_complex> z(6,5,4);
+        z.fillrandom();
+        madness::Tensor<double_complex> w = madness::evaluate(madness::lazy(z)*madness::lazy(c) + madness::lazy(z));
+        EXPECT_LT((w - copy(z).emul(madness::convert<double_complex>(c)) - z).normf(), 1e-14*w.normf());
+
+        // non-contiguous leaves and results
+        madness::Tensor<double> u = copy(c);
+        madness::Tensor<double> uslice = u(madness::_,madness::Slice(1,3),madness::_);
+        madness::assign(uslice, madness::lazy(x(madness::_,madness::Slice(0,2),madness::_))*madness::lazy(y(madness::_,madness::Slice(2,4),madness::_)));
+        s = copy(c);
+        s(madness::_,madness::Slice(1,3),madness::_) = x(madness::_,madness::Slice(0,2),madness::_).emul(y(madness::_,madness::Slice(2,4),madness::_));
+        EXPECT_LT((u-s).normf(), 1e-14*s.normf());
+    }
+
+    TEST(TensorExprTest, Aliasing) {
+        madness::Tensor<double> c(7,6,5), x(7,6,5);
+        c.fillrandom(); x.fillrandom();
+
+        // the result appears several times in the expression
+        madness::Tensor<double> r = copy(c);
+        madness::assign(r, madness::lazy(r)*madness::lazy(r) + madness::lazy(r)*2.0 - madness::lazy(x));
+        madness::Tensor<double> s = copy(c).emul(c) + c*2.0 - x;
+        EXPECT_LT((r-s).normf(), 1e-14*s.normf());
+
+        // a sum of squares accumulated in place, as in a multiop functor
+        std::vector< madness::Tensor<double> > v = {c, x, copy(c).scale(-0.5)};
+        r = madness::evaluate(madness::lazy(v[0])*madness::lazy(v[0]));
+        for (std::size_t i=1; i<v.size(); ++i) madness::assign(r, madness::lazy(r) + madness::lazy(v[i])*madness::lazy(v[i]));
+        s = copy(v[0]).emul(v[0]);
+        for (std::size_t i=1; i<v.size(); ++i) s += copy(v[i]).emul(v[i]);
+        EXPECT_LT((r-s).normf(), 1e-14*s.normf());
+
+        // the KAIN update unew += (u - r)*c
+        madness::Tensor<double> unew = copy(x);
+        madness::assign(unew, madness::lazy(unew) + (madness::lazy(c) - madness::lazy(x))*0.25);
+        s = x + (c - x)*0.25;
+        EXPECT_LT((unew-s).normf(), 1e-14*s.normf());
+
+        // a slice of the result that overlaps the leaf it is computed from
+        r = copy(c);
+        madness::Tensor<double> rslice = r(madness::_,madness::Slice(1,4),madness::_);
+        madness::assign(rslice, madness::lazy(r(madness::_,madness::Slice(0,3),madness::_))*3.0);
+        s = copy(c);
+        s(madness::_,madness::Slice(1,4),madness::_) = c(madness::_,madness::Slice(0,3),madness::_)*3.0;
+        EXPECT_LT((r-s).normf(), 1e-14*s.normf());
+    }
+
+    template <typename T>
+    void check_simd_kernels(long n) {
+        typedef typename madness::Tensor<T>::scalar_type scalar_type;
+        madness::Tensor<T> a(n), b(n);
+        a.fillrandom();
+        b.fillrandom();
+        a -= T(0.5);
+        T sumsq = 0, trace = 0;
+        scalar_type normsq = 0, absmax = 0;
+        for (long i=0; i<n; ++i) {
+            sumsq += a(i)*a(i);
+            trace += a(i)*b(i);
+            normsq += std::norm(a(i));
+            absmax = std::max(absmax, std::abs(a(i)));
+        }
+        EXPECT_LT(std::abs(a.sumsq() - sumsq), 1e-13*n);
+        EXPECT_LT(std::abs(a.trace(b) - trace), 1e-13*n);
+        EXPECT_LT(std::abs(a.normf() - std::sqrt(normsq)), 1e-13*n);
+        EXPECT_LT(std::abs(a.absmax() - absmax), 1e-15);
+        madness::Tensor<T> c = copy(a);
+        c.emul(b);
+        for (long i=0; i<n; ++i) EXPECT_LT(std::abs(c(i) - a(i)*b(i)), 1e-15);
+        // the operand may be the result itself
+        c = copy(a);
+        c.emul(c);
+        for (long i=0; i<n; ++i) EXPECT_LT(std::abs(c(i) - a(i)*a(i)), 1e-15);
+    }
+
+    TEST(TensorSimdTest, MatchesLoops) {
+        const madness::MtxmqISA isa = madness::mtxmq_isa();
+        for (madness::MtxmqISA i : {madness::MtxmqISA::Generic, madness::MtxmqISA::AVX2, madness::MtxmqISA::AVX512}) {
+            if (!madness::mtxmq_isa_supported(i)) continue;
+            madness::set_mtxmq_isa(i);
+            for (long n : {1, 7, 33, 1000}) {
+                check_simd_kernels<double>(n);
+                check_simd_kernels<double_complex>(n);
+            }
+        }
+        madness::set_mtxmq_isa(isa);
+    }
+
+    TEST(BlockSparseTensorTest, Contraction) {
+        // a matrix decaying away from the diagonal, as exchange between localized orbitals
+        const long n = 80;
+        madness::Tensor<double> a(n,n), b(n,n);
+        ITERATOR2(a, a(_i,_j) = std::exp(-2.0*std::abs(_i-_j)));
+        b.fillrandom();
+        typedef madness::BlockSparseTensor<double> bstT;
+        const bstT::tilingT t = bstT::uniform_tiling(n,8);
+        bstT sa(a, {t,t}, 1e-8), sb(b, {t,t}, 1e-8);
+        EXPECT_EQ(t.size(), 10u);
+        EXPECT_LT(sa.nnz(), a.size()/2);
+        EXPECT_EQ(sb.nnz(), b.size());
+        EXPECT_LT((sa.full()-a).normf(), 1e-8*t.size()*t.size());
+
+        const madness::Tensor<double> ab = inner(a,b), aa = inner(a,a,0,1);
+        EXPECT_LT((inner(sa,sb).full()-ab).normf(), 1e-6);
+        EXPECT_LT((inner(sa,sa,0,1).full()-aa).normf(), 1e-6);
+        EXPECT_LT((inner(sa,b)-ab).normf(), 1e-6);
+        EXPECT_LT((inner(b,sa,0,1)-inner(b,a,0,1)).normf(), 1e-6);
+
+        // contraction of a middle index, all blocks kept
+        madness::Tensor<double> x(10,12,9), y(12,7);
+        x.fillrandom();
+        y.fillrandom();
+        bstT sx(x, {bstT::uniform_tiling(10,4), bstT::uniform_tiling(12,5), bstT::uniform_tiling(9,3)}, 0.0);
+        bstT sy(y, {bstT::uniform_tiling(12,5), bstT::uniform_tiling(7,7)}, 0.0);
+        EXPECT_LT((inner(sx,sy,1,0).full()-inner(x,y,1,0)).normf(), 1e-12);
+        EXPECT_LT((inner(sy,sx,0,1).full()-inner(y,x,0,1)).normf(), 1e-12);
+        EXPECT_LT((inner(x,sy,1,0)-inner(x,y,1,0)).normf(), 1e-12);
+
+        // the pair list holds the elements above the threshold
+        std::vector< std::pair<long,long> > ij = sa.pairs(1e-3);
+        long count = 0;
+        ITERATOR2(a, if (a(_i,_j) >= 1e-3) ++count);
+        EXPECT_EQ(long(ij.size()), count);
+        for (const auto& p : ij) EXPECT_LE(std::abs(p.first-p.second), 8);
+
+        sa.truncate(1.0);
+        EXPECT_EQ(long(sa.blocks().size()), long(t.size()));
+    }
+
 //     TYPED_TEST(TensorTest, Container) {
 //         typedef madness::ConcurrentHashMap< int, Tensor<TypeParam> > containerT;
 //         static const int N = 100;
@@ -17,6 +17,95 @@ std::string ok(const bool b) {if (b) return "ok   "; return "fail ";};
 bool is_large(const double& val, const double& eps) {
 	return (val>eps);
 }
+/// test the incremental accumulation of many low-rank tensors
+int testSVDTensor_accumulate(const long& k, const long& dim, const double& eps) {
+
+	print("entering SVDTensor accumulate");
+	const long kvec=std::pow(k,dim/2);
+	const long naddend=50, nbasis=6;
+	std::vector<long> d(dim,k);
+
+	// the addends share a few left and right vectors, so that the rank of
+	// the sum stays small while the concatenated rank is naddend*2
+	Tensor<double> x(nbasis,kvec), y(nbasis,kvec);
+	x.fillrandom();
+	y.fillrandom();
+	Tensor<double> sum(kvec,kvec);
+	SVDTensorAccumulator<double> acc(eps);
+	for (long i=0; i<naddend; ++i) {
+		Tensor<double> c(nbasis,nbasis);
+		c.fillrandom();
+		c=inner(c,y,1,0);
+		for (long r=0; r<nbasis; ++r) if (r!=i%nbasis and r!=(i+1)%nbasis) c(r,_)=0.0;
+		Tensor<double> m=inner(x,c,0,0);
+		sum+=m;
+		acc.add(SVDTensor<double>(m.reshape(d),eps*0.01));
+	}
+	SVDTensor<double> result=acc.finish();
+
+	int nerror=0;
+	const double norm=(sum.reshape(d)-result.reconstruct()).normf();
+	print(ok(is_small(norm,eps)),"accumulate error     ",norm,acc.error_bound());
+	if (!is_small(norm,eps) or !is_small(acc.error_bound(),eps)) nerror++;
+	print(ok(result.rank()<=nbasis),"accumulate rank      ",result.rank());
+	if (result.rank()>nbasis) nerror++;
+	print(ok(acc.peak_rank()<=nbasis+8*2),"accumulate peak rank ",acc.peak_rank());
+	if (acc.peak_rank()>nbasis+8*2) nerror++;
+
+	print("all done\n");
+	return nerror;
+}
+
+/// test the rounded sum of tensor trains against the sum of the full tensors
+int test_TT_round_sum(const long k, const long dim, const double eps) {
+
+	print("entering test_TT_round_sum");
+	std::vector<long> d(dim,k);
+	std::vector<Tensor<double> > t(3);
+	std::vector<TensorTrain<double> > tt(3);
+
+	// exp(-a (x-y)^2) with x the first and y the second half of the dimensions
+	for (int i=0; i<3; ++i) {
+		t[i]=Tensor<double>(d);
+		const double a=1.0+i;
+		for (long j=0; j<t[i].size(); ++j) {
+			double r2=0.0;
+			long idx=j;
+			std::vector<double> x(dim);
+			for (long m=dim-1; m>=0; --m) {
+				x[m]=(idx%k+0.5)/k;
+				idx/=k;
+			}
+			for (long m=0; m<dim/2; ++m) r2+=(x[m]-x[m+dim/2])*(x[m]-x[m+dim/2]);
+			t[i].ptr()[j]=exp(-a*r2);
+		}
+		tt[i]=TensorTrain<double>(t[i],eps*0.1);
+	}
+	const std::vector<double> factors={1.0,-0.5,2.0};
+	Tensor<double> ref=t[0]*factors[0]+t[1]*factors[1]+t[2]*factors[2];
+
+	int nerror=0;
+	TensorTrain<double> r=round_sum(tt,factors,eps);
+	double norm=(ref-r.reconstruct()).normf();
+	print(ok(is_small(norm,eps)),"round_sum            ",norm,r.ranks());
+	if (!is_small(norm,eps)) nerror++;
+
+	// without oversampling the sketch is too small and round_sum falls back to gaxpy and truncate
+	r=round_sum(tt,factors,eps,0);
+	norm=(ref-r.reconstruct()).normf();
+	print(ok(is_small(norm,eps)),"round_sum, fallback  ",norm,r.ranks());
+	if (!is_small(norm,eps)) nerror++;
+
+	r=copy(tt[0]);
+	r.gaxpy_truncate(factors[0],tt[1],factors[1],eps);
+	norm=(t[0]*factors[0]+t[1]*factors[1]-r.reconstruct()).normf();
+	print(ok(is_small(norm,eps)),"gaxpy_truncate       ",norm,r.ranks());
+	if (!is_small(norm,eps)) nerror++;
+
+	print("all done\n");
+	return nerror;
+}
+
 #if HAVE_GENTENSOR
 
 int testGenTensor_ctor(const long& k, const long& dim, const double& eps, const TensorType& tt) {
@@ -1013,6 +1102,8 @@ int main(int argc, char**argv) {
     error+=testGenTensor_deepcopy(k,dim,eps,TT_TENSORTRAIN);
 
     error+=testGenTensor_reduce(k,dim,eps,TT_2D);
+    error+=testSVDTensor_accumulate(k,dim,eps);
+    error+=test_TT_round_sum(k,dim,eps);
 
     print(ok(error==0),error,"finished test suite\n");
 #endif
@@ -1026,8 +1117,10 @@ int main(int argc, char**argv) {
 #else
 int main(int argc, char** argv) {
 
-    print("no testseprep without having a GenTensor");
-    return 0;
+    print("no GenTensor tests without having a GenTensor");
+    int error=testSVDTensor_accumulate(4,6,1.e-3);
+    error+=test_TT_round_sum(4,6,1.e-3);
+    return error;
 }
 
 #endif
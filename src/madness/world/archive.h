@@ -60,6 +60,12 @@
 /// \todo Brief description needed.
 #define ARCHIVE_COOKIE "archive"
 
+/// Cookie of binary archives in schema mode, same length as \c ARCHIVE_COOKIE.
+#define ARCHIVE_SCHEMA_COOKIE "archivs"
+
+/// Version of the schema descriptors, stored after \c ARCHIVE_SCHEMA_COOKIE.
+#define ARCHIVE_SCHEMA_VERSION 1
+
 /// Major version number for archive.
 #define ARCHIVE_MAJOR_VERSION 0
 /// Minor version number for archive.
@@ -500,6 +506,38 @@ namespace madness {
         }
 
 
+        /// Serialize the cookie of type \c T for type checking.
+
+        /// \param[in] ar The archive.
+        template <class T, class Archive>
+        inline void store_type_cookie(const Archive& ar) {
+            unsigned char ck = archive_typeinfo<T>::cookie;
+            ar.store(&ck, 1); // cannot use <<
+            MAD_ARCHIVE_DEBUG(std::cout << "wrote cookie " << archive_type_names[ck] << std::endl);
+        }
+
+        /// Deserialize a cookie and check that it is the one of type \c T.
+
+        /// \param[in] ar The archive.
+        template <class T, class Archive>
+        inline void load_type_cookie(const Archive& ar) {
+            unsigned char ck = archive_typeinfo<T>::cookie;
+            unsigned char cookie;
+            ar.load(&cookie, 1); // cannot use >>
+            if (cookie != ck) {
+                char msg[255];
+                std::sprintf(msg,"InputArchive type mismatch: expected cookie "
+                             "%u (%s) but got %u (%s) instead",
+                             ck, archive_type_names[ck],
+                             cookie,archive_type_names[cookie]);
+                std::cerr << msg << std::endl;
+                MADNESS_EXCEPTION(msg, static_cast<int>(cookie));
+            }
+            else {
+                MAD_ARCHIVE_DEBUG(std::cout << "read cookie " << archive_type_names[cookie] << std::endl);
+            }
+        }
+
         /// Default implementation of the pre/postamble for type checking.
 
         /// \tparam Archive The archive class.
@@ -510,30 +548,14 @@ namespace madness {
 
             /// \param[in] ar The archive.
             static inline void preamble_load(const Archive& ar) {
-                unsigned char ck = archive_typeinfo<T>::cookie;
-                unsigned char cookie;
-                ar.load(&cookie, 1); // cannot use >>
-                if (cookie != ck) {
-                    char msg[255];
-                    std::sprintf(msg,"InputArchive type mismatch: expected cookie "
-                                 "%u (%s) but got %u (%s) instead",
-                                 ck, archive_type_names[ck],
-                                 cookie,archive_type_names[cookie]);
-                    std::cerr << msg << std::endl;
-                    MADNESS_EXCEPTION(msg, static_cast<int>(cookie));
-                }
-                else {
-                    MAD_ARCHIVE_DEBUG(std::cout << "read cookie " << archive_type_names[cookie] << std::endl);
-                }
+                load_type_cookie<T>(ar);
             }
 
             /// Serialize a cookie for type checking.
 
             /// \param[in] ar The archive.
             static inline void preamble_store(const Archive& ar) {
-                unsigned char ck = archive_typeinfo<T>::cookie;
-                ar.store(&ck, 1); // cannot use <<
-                MAD_ARCHIVE_DEBUG(std::cout << "wrote cookie " << archive_type_names[ck] << std::endl);
+                store_type_cookie<T>(ar);
             }
 
             /// By default there is no postamble.
@@ -544,6 +566,66 @@ namespace madness {
         };
 
 
+        /// Nesting of the objects in an archive that supports schema mode.
+
+        /// Without schema mode every object and array carries a type cookie.
+        /// In schema mode only the outermost object of each \c & carries one,
+        /// the schema descriptor of everything inside it, so nested elements
+        /// and arrays are stored as raw data without per-element overhead.
+        class SchemaNesting {
+            bool schema = false; ///< True in schema mode.
+            mutable int depth = 0; ///< Number of objects being (de)serialized.
+
+        public:
+            /// Returns true in schema mode.
+            bool schema_mode() const {return schema;}
+
+            /// Switches schema mode on or off, between top-level objects.
+            void set_schema_mode(bool on) {
+                schema = on;
+                depth = 0;
+            }
+
+            /// Enters an object; returns true if its type cookie is (de)serialized.
+            bool enter_object() const {return depth++ == 0 || !schema;}
+
+            /// Leaves an object.
+            void leave_object() const {--depth;}
+        };
+
+
+        /// Pre/postamble for archives deriving from \c SchemaNesting.
+
+        /// \tparam Archive The archive class.
+        /// \tparam T The type to serialized or to expect upon deserialization.
+        template <class Archive, class T>
+        struct SchemaArchivePrePostImpl {
+            /// Deserialize and check the cookie, unless inside a top-level object in schema mode.
+
+            /// \param[in] ar The archive.
+            static inline void preamble_load(const Archive& ar) {
+                if (ar.enter_object()) load_type_cookie<T>(ar);
+            }
+
+            /// Serialize the cookie, unless inside a top-level object in schema mode.
+
+            /// \param[in] ar The archive.
+            static inline void preamble_store(const Archive& ar) {
+                if (ar.enter_object()) store_type_cookie<T>(ar);
+            }
+
+            /// Leave the object.
+
+            /// \param[in] ar The archive.
+            static inline void postamble_load(const Archive& ar) {ar.leave_object();}
+
+            /// Leave the object.
+
+            /// \param[in] ar The archive.
+            static inline void postamble_store(const Archive& ar) {ar.leave_object();}
+        };
+
+
         /// Default symmetric serialization of a non-fundamental type that has `serialize` method
 
         /// \tparam Archive The archive type.
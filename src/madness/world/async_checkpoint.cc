@@ -0,0 +1,157 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+/**
+ \file async_checkpoint.cc
+ \brief Implements \c AsyncCheckpoint, a parallel archive written to disk by a background thread.
+ \ingroup serialization
+*/
+
+#include <madness/world/async_checkpoint.h>
+#include <madness/world/thread.h>
+#include <madness/world/worldmutex.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <list>
+
+namespace madness {
+
+    namespace {
+
+        /// Background thread writing the committed checkpoints in order
+        class CheckpointWriter : public ThreadBase {
+            struct Job {
+                std::string filename;
+                std::vector<unsigned char> data;
+                Future<bool> written;
+            };
+
+            PthreadConditionVariable cv; ///< Protects and signals the queue.
+            std::list<Job> queue; ///< Jobs not yet started.
+            long npending = 0; ///< Jobs not yet finished.
+
+            void run() {
+                while (true) {
+                    cv.lock();
+                    while (queue.empty()) cv.wait();
+                    Job job = std::move(queue.front());
+                    queue.pop_front();
+                    cv.unlock();
+
+                    // Replace the previous file only once the new one is complete
+                    const std::string tmpname = job.filename + ".tmp";
+                    std::ofstream out(tmpname, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+                    out.write((const char*) job.data.data(), job.data.size());
+                    out.close();
+                    const bool ok = !out.fail() && std::rename(tmpname.c_str(), job.filename.c_str()) == 0;
+                    if (!ok) std::fprintf(stderr, "!! MADNESS: failed writing checkpoint %s\n", job.filename.c_str());
+                    std::vector<unsigned char>().swap(job.data);
+                    job.written.set(ok);
+
+                    cv.lock();
+                    --npending;
+                    cv.broadcast();
+                    cv.unlock();
+                }
+            }
+
+        public:
+            void add(const std::string& filename, std::vector<unsigned char>& data, const Future<bool>& written) {
+                cv.lock();
+                queue.push_back(Job{filename, std::vector<unsigned char>(), written});
+                queue.back().data.swap(data);
+                ++npending;
+                cv.broadcast();
+                cv.unlock();
+            }
+
+            void wait_all() {
+                cv.lock();
+                while (npending) cv.wait();
+                cv.unlock();
+            }
+        };
+
+        Mutex writer_mutex;
+        CheckpointWriter* writer = nullptr; ///< Started on first use, never deleted.
+
+        CheckpointWriter& get_writer() {
+            ScopedMutex<Mutex> lock(writer_mutex);
+            if (!writer) {
+                writer = new CheckpointWriter;
+                writer->start();
+            }
+            return *writer;
+        }
+    }
+
+    AsyncCheckpoint::AsyncCheckpoint(World& world, const std::string& filename, int nwriter)
+        : world(world)
+        , filename(filename)
+        , nio(archiveT::num_io_nodes(world, nwriter))
+        , localar(buffer)
+        , ar(new archiveT(world, localar, nio))
+    {
+        // Every I/O node writes its own file, which starts like a binary file
+        // archive, and process zero stores the number of writers as in
+        // BaseParallelArchive::open()
+        if (ar->is_io_node()) localar.store(ARCHIVE_COOKIE, strlen(ARCHIVE_COOKIE)+1);
+        if (world.rank() == 0) localar & nio;
+    }
+
+    AsyncCheckpoint::~AsyncCheckpoint() {
+        if (ar) commit();
+    }
+
+    Future<bool> AsyncCheckpoint::commit() {
+        MADNESS_ASSERT(ar);
+        const bool is_io_node = ar->is_io_node();
+        ar.reset();
+        if (!is_io_node) {
+            std::vector<unsigned char>().swap(buffer);
+            return Future<bool>(true);
+        }
+        char buf[256];
+        MADNESS_ASSERT(filename.size()+7 <= sizeof(buf));
+        snprintf(buf, sizeof(buf), "%s.%5.5d", filename.c_str(), world.rank());
+        Future<bool> written;
+        get_writer().add(buf, buffer, written);
+        return written;
+    }
+
+    void AsyncCheckpoint::wait_all() {
+        ScopedMutex<Mutex> lock(writer_mutex);
+        if (writer) writer->wait_all();
+    }
+
+} // namespace madness
@@ -0,0 +1,138 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+#ifndef MADNESS_WORLD_ASYNC_CHECKPOINT_H__INCLUDED
+#define MADNESS_WORLD_ASYNC_CHECKPOINT_H__INCLUDED
+
+/**
+ \file async_checkpoint.h
+ \brief Implements \c AsyncCheckpoint, a parallel archive written to disk by a background thread.
+ \ingroup serialization
+*/
+
+#include <madness/world/world.h>
+#include <madness/world/future.h>
+#include <madness/world/parallel_archive.h>
+#include <madness/world/vector_archive.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace madness {
+
+    /// A parallel checkpoint that is staged in memory and written to disk in the background.
+
+    /// \ingroup serialization
+    /// Objects are serialized into a buffer on each I/O node, in the format a
+    /// \c ParallelOutputArchive<BinaryFstreamOutputArchive> with the same
+    /// number of writers would produce. The files can therefore be read with
+    /// \c ParallelInputArchive and the same number of processes.
+    ///
+    /// Each file is written under a temporary name and renamed when
+    /// complete, so a crash while writing leaves the previous checkpoint
+    /// in place.
+    ///
+    /// Serialization copies the data (and is collective for parallel
+    /// containers such as the coefficients of a \c Function). Once
+    /// \c commit() returns, the objects may be modified while a background
+    /// thread writes the buffer of this process to disk.
+    /// \code
+    ///   AsyncCheckpoint checkpoint(world, "restart");
+    ///   checkpoint.archive() & f & g;
+    ///   Future<bool> written = checkpoint.commit();
+    /// \endcode
+    class AsyncCheckpoint {
+    public:
+        typedef archive::ParallelOutputArchive<archive::VectorOutputArchive> archiveT;
+
+    private:
+        World& world; ///< The world.
+        std::string filename; ///< Base name of the files.
+        int nio; ///< Number of I/O nodes.
+        std::vector<unsigned char> buffer; ///< Staged data of this process.
+        archive::VectorOutputArchive localar; ///< Archive writing into \c buffer.
+        std::unique_ptr<archiveT> ar; ///< The parallel archive, null after commit.
+
+    public:
+        /// Start a checkpoint with given base filename.
+
+        /// \param[in] world The world.
+        /// \param[in] filename Base name of the files.
+        /// \param[in] nwriter The number of writers, limited as in \c ParallelOutputArchive.
+        AsyncCheckpoint(World& world, const std::string& filename, int nwriter=1);
+
+        AsyncCheckpoint(const AsyncCheckpoint&) = delete;
+        AsyncCheckpoint& operator=(const AsyncCheckpoint&) = delete;
+
+        /// Commits the checkpoint, if this was not done explicitly.
+        ~AsyncCheckpoint();
+
+        /// The archive to serialize the checkpointed objects into.
+        archiveT& archive() {
+            MADNESS_ASSERT(ar);
+            return *ar;
+        }
+
+        /// Hand the staged data over to the background writer.
+
+        /// \return A future that is assigned \c true once the file of this
+        /// process is written, or \c false if writing failed. It is
+        /// assigned \c true immediately on processes that are not I/O nodes.
+        Future<bool> commit();
+
+        /// \return The number of bytes staged on this process so far.
+        std::size_t size() const {
+            return buffer.size();
+        }
+
+        /// Block until all committed checkpoints of this process are written.
+        static void wait_all();
+    };
+
+    /// Write an object to disk in the background, see \c AsyncCheckpoint.
+
+    /// \ingroup serialization
+    /// \param[in] world The world.
+    /// \param[in] t The object to write, it is copied before returning.
+    /// \param[in] filename Base name of the files.
+    /// \param[in] nwriter The number of writers.
+    /// \return A future assigned once the file of this process is written.
+    template <typename T>
+    Future<bool> save_async(World& world, const T& t, const std::string& filename, int nwriter=1) {
+        AsyncCheckpoint checkpoint(world, filename, nwriter);
+        checkpoint.archive() & t;
+        return checkpoint.commit();
+    }
+
+} // namespace madness
+
+#endif // MADNESS_WORLD_ASYNC_CHECKPOINT_H__INCLUDED
@@ -0,0 +1,281 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+/// \file bench_world.cc
+/// \brief Microbenchmarks of the MADworld runtime
+
+/// Measures task latency and throughput, active message latency and rate,
+/// global operations, WorldContainer access and ConcurrentHashMap contention.
+/// Results are printed by rank 0 as JSON, to stdout or to the file given as
+/// first command line argument, so they can be compared between releases.
+///
+///     mpirun -np 2 ./bench_world bench_world.json
+
+#define WORLD_INSTANTIATE_STATIC_TEMPLATES
+#include <madness/world/MADworld.h>
+#include <madness/world/worlddc.h>
+#include <madness/world/worldhashmap.h>
+#include <madness/world/atomicint.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace madness;
+
+namespace {
+
+    /// collects the measurements and formats them as JSON
+    class BenchmarkResults {
+        std::vector<std::string> records;
+    public:
+        void add(const std::string& name, const double value, const std::string& unit,
+                 const long payload=-1) {
+            std::ostringstream ss;
+            ss.precision(6);
+            ss << "    {\"name\": \"" << name << "\", \"value\": " << value << ", \"unit\": \"" << unit << "\"";
+            if (payload>=0) ss << ", \"payload_bytes\": " << payload;
+            ss << "}";
+            records.push_back(ss.str());
+        }
+
+        std::string json(const World& world) const {
+            std::ostringstream ss;
+            ss << "{\n  \"benchmark\": \"bench_world\",\n";
+            ss << "  \"nproc\": " << world.size() << ",\n";
+            ss << "  \"nthread\": " << ThreadPool::size() << ",\n";
+            ss << "  \"results\": [\n";
+            for (std::size_t i=0; i<records.size(); ++i) {
+                ss << records[i] << ((i+1<records.size()) ? ",\n" : "\n");
+            }
+            ss << "  ]\n}\n";
+            return ss.str();
+        }
+    };
+
+    AtomicInt ntask_done;
+
+    void empty_task() {
+        ntask_done++;
+    }
+
+    double stamp_task() {
+        return wall_time();
+    }
+
+    /// target of the active messages
+    class Pinger : public WorldObject<Pinger> {
+    public:
+        AtomicInt nreceived;
+
+        Pinger(World& world) : WorldObject<Pinger>(world) {
+            nreceived=0;
+            process_pending();
+        }
+
+        int ping(int i) const {
+            return i;
+        }
+
+        void receive(const std::vector<unsigned char>& buf) {
+            nreceived++;
+        }
+    };
+
+    typedef ConcurrentHashMap<long,long> hashmapT;
+
+    /// hammers a shared hash map from all threads
+    void hashmap_task(hashmapT* map, const long seed, const long nops, const long nkey) {
+        unsigned long k=seed;
+        for (long i=0; i<nops; ++i) {
+            k=k*6364136223846793005ul+1442695040888963407ul;
+            const long key=(k>>33)%nkey;
+            if (i%4==0) {
+                hashmapT::accessor acc;
+                map->insert(acc,key);
+                acc->second++;
+            } else {
+                map->find(key);
+            }
+        }
+    }
+
+    void bench_tasks(World& world, BenchmarkResults& results) {
+        const long nlatency=10000;
+        world.gop.fence();
+        double start=wall_time();
+        double delay=0.0;
+        for (long i=0; i<nlatency; ++i) {
+            const double t0=wall_time();
+            delay+=world.taskq.add(stamp_task).get()-t0;
+        }
+        results.add("task_spawn_to_run_latency",1.e6*delay/nlatency,"us");
+        results.add("task_spawn_and_wait_latency",1.e6*(wall_time()-start)/nlatency,"us");
+
+        const long ntask=200000;
+        ntask_done=0;
+        world.gop.fence();
+        start=wall_time();
+        for (long i=0; i<ntask; ++i) world.taskq.add(empty_task);
+        world.taskq.fence();
+        const double used=wall_time()-start;
+        MADNESS_CHECK(ntask_done==ntask);
+        const long nthread=std::max(std::size_t(1),ThreadPool::size());
+        results.add("tasks_per_second",ntask/used,"1/s");
+        results.add("tasks_per_second_per_thread",ntask/used/nthread,"1/s");
+        world.gop.fence();
+    }
+
+    void bench_am(World& world, BenchmarkResults& results) {
+        Pinger pinger(world);
+        world.gop.fence();
+        const ProcessID next=(world.rank()+1)%world.size();
+
+        const long nping=2000;
+        double start=wall_time();
+        for (long i=0; i<nping; ++i) pinger.send(next,&Pinger::ping,int(i)).get();
+        results.add("am_round_trip_latency",1.e6*(wall_time()-start)/nping,"us");
+        world.gop.fence();
+
+        for (long nbyte=8; nbyte<=(1l<<20); nbyte*=8) {
+            const std::vector<unsigned char> buf(nbyte);
+            const long nmsg=std::max(10l,std::min(10000l,(64l<<20)/nbyte));
+            pinger.nreceived=0;
+            world.gop.fence();
+            start=wall_time();
+            for (long i=0; i<nmsg; ++i) pinger.send(next,&Pinger::receive,buf);
+            world.gop.fence();
+            const double used=wall_time()-start;
+            MADNESS_CHECK(pinger.nreceived==nmsg);
+            results.add("am_message_rate",nmsg/used,"1/s",nbyte);
+            results.add("am_bandwidth",nmsg*nbyte/used/1.e6,"MB/s",nbyte);
+        }
+        world.gop.fence();
+    }
+
+    void bench_gop(World& world, BenchmarkResults& results) {
+        const long nfence=1000;
+        world.gop.fence();
+        double start=wall_time();
+        for (long i=0; i<nfence; ++i) world.gop.fence();
+        results.add("gop_fence_latency",1.e6*(wall_time()-start)/nfence,"us");
+
+        for (long n=1; n<=(1l<<20); n*=32) {
+            std::vector<double> buf(n,1.0);
+            const long nsum=std::max(5l,std::min(1000l,(16l<<20)/n));
+            world.gop.fence();
+            start=wall_time();
+            for (long i=0; i<nsum; ++i) world.gop.sum(buf.data(),n);
+            const double used=wall_time()-start;
+            results.add("gop_sum_latency",1.e6*used/nsum,"us",n*sizeof(double));
+            results.add("gop_sum_bandwidth",nsum*n*sizeof(double)/used/1.e6,"MB/s",n*sizeof(double));
+        }
+        world.gop.fence();
+    }
+
+    void bench_container(World& world, BenchmarkResults& results) {
+        typedef WorldContainer<long,double> dcT;
+        dcT dc(world);
+        const long nkey=20000*world.size();
+
+        // keys are inserted by the process that will look them up
+        std::vector<long> local, remote;
+        for (long key=world.rank(); key<nkey; key+=world.size()) {
+            if (dc.owner(key)==world.rank()) local.push_back(key);
+            else remote.push_back(key);
+        }
+
+        world.gop.fence();
+        double start=wall_time();
+        for (long key : local) dc.replace(key,double(key));
+        double used=wall_time()-start;
+        if (local.size()>0) results.add("container_insert_local",local.size()/used,"1/s");
+
+        start=wall_time();
+        for (long key : remote) dc.replace(key,double(key));
+        world.gop.fence();
+        used=wall_time()-start;
+        if (remote.size()>0) results.add("container_insert_remote",remote.size()/used,"1/s");
+
+        start=wall_time();
+        for (long key : local) MADNESS_CHECK(dc.find(key).get()->second==double(key));
+        used=wall_time()-start;
+        if (local.size()>0) results.add("container_find_local",local.size()/used,"1/s");
+
+        std::vector<Future<dcT::iterator> > futures;
+        futures.reserve(remote.size());
+        start=wall_time();
+        for (long key : remote) futures.push_back(dc.find(key));
+        for (auto& f : futures) f.get();
+        used=wall_time()-start;
+        if (remote.size()>0) results.add("container_find_remote",remote.size()/used,"1/s");
+        futures.clear();
+        world.gop.fence();
+    }
+
+    void bench_hashmap(World& world, BenchmarkResults& results) {
+        const long nthread=std::max(std::size_t(1),ThreadPool::size());
+        const long nops=400000;
+        for (long nkey : {16l,1024l,1048576l}) {
+            hashmapT map;
+            world.gop.fence();
+            const double start=wall_time();
+            for (long i=0; i<nthread; ++i) world.taskq.add(hashmap_task,&map,i+1,nops,nkey);
+            world.taskq.fence();
+            const double used=wall_time()-start;
+            results.add("hashmap_ops_per_second_nkey_"+std::to_string(nkey),nthread*nops/used,"1/s");
+        }
+        world.gop.fence();
+    }
+}
+
+int main(int argc, char** argv) {
+    World& world=initialize(argc,argv);
+
+    BenchmarkResults results;
+    bench_tasks(world,results);
+    bench_am(world,results);
+    bench_gop(world,results);
+    bench_container(world,results);
+    bench_hashmap(world,results);
+
+    if (world.rank()==0) {
+        if (argc>1) {
+            std::ofstream out(argv[1]);
+            out << results.json(world);
+        } else {
+            std::cout << results.json(world);
+        }
+    }
+
+    world.gop.fence();
+    finalize();
+    return 0;
+}
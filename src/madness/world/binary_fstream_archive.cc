@@ -56,7 +56,14 @@ namespace madness {
             os.rdbuf()->pubsetbuf(iobuf.get(), IOBUFSIZE);
 #endif
 
-            store(ARCHIVE_COOKIE, strlen(ARCHIVE_COOKIE)+1);
+            if (schema_mode()) {
+                const unsigned int version = ARCHIVE_SCHEMA_VERSION;
+                store(ARCHIVE_SCHEMA_COOKIE, strlen(ARCHIVE_SCHEMA_COOKIE)+1);
+                store(&version, 1);
+            }
+            else {
+                store(ARCHIVE_COOKIE, strlen(ARCHIVE_COOKIE)+1);
+            }
         }
 
         void BinaryFstreamOutputArchive::close() {
@@ -84,8 +91,19 @@ namespace madness {
             char cookie[255];
             int n = strlen(ARCHIVE_COOKIE)+1;
             load(cookie, n);
-            if (strncmp(cookie,ARCHIVE_COOKIE,n) != 0)
+            if (strncmp(cookie,ARCHIVE_SCHEMA_COOKIE,n) == 0) {
+                unsigned int version = 0;
+                load(&version, 1);
+                if (version > ARCHIVE_SCHEMA_VERSION)
+                    MADNESS_EXCEPTION("BinaryFstreamInputArchive: open: newer schema version", version);
+                set_schema_mode(true);
+            }
+            else if (strncmp(cookie,ARCHIVE_COOKIE,n) == 0) {
+                set_schema_mode(false);
+            }
+            else {
                 MADNESS_EXCEPTION("BinaryFstreamInputArchive: open: not an archive?", 1);
+            }
         }
 
         void BinaryFstreamInputArchive::close() {
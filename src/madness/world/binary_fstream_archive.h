@@ -50,7 +50,10 @@ namespace madness {
         /// @{
 
         /// Wraps an archive around a binary filestream for output.
-        class BinaryFstreamOutputArchive : public BaseOutputArchive {
+
+        /// The archive type checks every object and array with a cookie, unless
+        /// it is in schema mode (see \c BinarySchemaOutputArchive).
+        class BinaryFstreamOutputArchive : public BaseOutputArchive, public SchemaNesting {
             static const std::size_t IOBUFSIZE = 4*1024*1024; ///< Buffer size.
             std::shared_ptr<char> iobuf; ///< Buffer.
             mutable std::ofstream os; ///< The filestream.
@@ -101,7 +104,9 @@ namespace madness {
         };
 
         /// Wraps an archive around a binary filestream for input.
-        class BinaryFstreamInputArchive : public BaseInputArchive {
+
+        /// Files written in schema mode are recognized when opened.
+        class BinaryFstreamInputArchive : public BaseInputArchive, public SchemaNesting {
             static const std::size_t IOBUFSIZE = 4*1024*1024; ///< Buffer size.
             std::shared_ptr<char> iobuf; ///< Buffer.
             mutable std::ifstream is; ///< The filestream.
@@ -150,6 +155,56 @@ namespace madness {
             void close();
         };
 
+        /// Binary filestream output archive in schema mode.
+
+        /// Each top-level object is preceded by a single type cookie, and the
+        /// data inside it (e.g., the coefficients of all nodes of a function
+        /// stored through a \c ParallelOutputArchive) are written without any
+        /// further cookies. The file is read by \c BinaryFstreamInputArchive
+        /// and \c MmapInputArchive, which recognize the mode.
+        class BinarySchemaOutputArchive : public BinaryFstreamOutputArchive {
+        public:
+            /// Default constructor.
+
+            /// The filename and open modes are optional here; they can be
+            /// specified later by calling \c open().
+            /// \param[in] filename Name of the file to write to.
+            /// \param[in] mode I/O attributes for opening the file.
+            BinarySchemaOutputArchive(const char* filename = nullptr,
+                                      std::ios_base::openmode mode = std::ios_base::binary | \
+                                                                     std::ios_base::out | std::ios_base::trunc)
+                : BinaryFstreamOutputArchive() {
+                set_schema_mode(true);
+                if (filename) open(filename, mode);
+            }
+
+            BinarySchemaOutputArchive(const std::string name,
+                                      std::ios_base::openmode mode = std::ios_base::binary | \
+                                                                     std::ios_base::out | std::ios_base::trunc)
+                : BinarySchemaOutputArchive(name.c_str(),mode) {}
+        };
+
+        /// Type checking of \c BinaryFstreamOutputArchive, one cookie per top-level object in schema mode.
+
+        /// \tparam T The data type.
+        template <class T>
+        struct ArchivePrePostImpl<BinaryFstreamOutputArchive,T>
+            : public SchemaArchivePrePostImpl<BinaryFstreamOutputArchive,T> {};
+
+        /// Type checking of \c BinarySchemaOutputArchive, one cookie per top-level object.
+
+        /// \tparam T The data type.
+        template <class T>
+        struct ArchivePrePostImpl<BinarySchemaOutputArchive,T>
+            : public SchemaArchivePrePostImpl<BinarySchemaOutputArchive,T> {};
+
+        /// Type checking of \c BinaryFstreamInputArchive, one cookie per top-level object in schema mode.
+
+        /// \tparam T The data type.
+        template <class T>
+        struct ArchivePrePostImpl<BinaryFstreamInputArchive,T>
+            : public SchemaArchivePrePostImpl<BinaryFstreamInputArchive,T> {};
+
         /// @}
     }
 }
@@ -114,6 +114,7 @@ class Cloud {
     bool debug = false;       ///< prints debug output
     bool dofence = true;      ///< fences after load/store
     bool force_load_from_cache = false;       ///< forces load from cache (mainly for debugging)
+    double lossy = 0.0;       ///< error bound of stored function coefficients relative to their threshold
 
 public:
 
@@ -147,6 +148,13 @@ public:
         force_load_from_cache = value;
     }
 
+    /// store function coefficients with an error bound relative to their threshold, zero stores exactly
+
+    /// see ParallelOutputArchive::set_lossy_compression()
+    void set_lossy_compression(const double fraction) {
+        lossy = fraction;
+    }
+
     void print_timings(World &universe) const {
         double rtime = double(reading_time);
         double wtime = double(writing_time);
@@ -366,6 +374,7 @@ private:
         } else {
             madness::archive::ContainerRecordOutputArchive ar(world, container, record);
             madness::archive::ParallelOutputArchive<madness::archive::ContainerRecordOutputArchive> par(world, ar);
+            par.set_lossy_compression(lossy);
             par & source;
             local_list_of_container_keys+=record;
         }
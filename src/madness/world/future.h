@@ -123,7 +123,7 @@ namespace madness {
                     World& world = pimpl->remote_ref.get_world();
                     const ProcessID owner = pimpl->remote_ref.owner();
                     world.am.send(owner, FutureImpl<T>::set_handler,
-                            new_am_arg(pimpl->remote_ref, value));
+                            new_am_iovec(pimpl->remote_ref, value));
 
                     pimpl->set_assigned(value);
                 } else {
@@ -252,7 +252,7 @@ namespace madness {
                 World& world = remote_ref.get_world();
                 const ProcessID owner = remote_ref.owner();
                 world.am.send(owner, FutureImpl<T>::set_handler,
-                        new_am_arg(remote_ref, value));
+                        new_am_iovec(remote_ref, value));
                 set_assigned(std::forward<U>(value));
             } else {
                 set_assigned((const_cast<T&>(t) = std::forward<U>(value)));
@@ -0,0 +1,480 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+/**
+ \file h5p_archive.cc
+ \brief Implements a parallel archive in a single HDF5 file.
+ \ingroup serialization
+*/
+
+#include <madness/world/h5p_archive.h>
+
+#ifdef HAVE_HDF5
+
+#include <madness/world/MADworld.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// Parallel HDF5 calls MPI, so its calls are serialized with those of the runtime
+#ifdef H5_HAVE_PARALLEL
+#define MADNESS_H5P_MUTEX SAFE_MPI_GLOBAL_MUTEX
+#else
+#define MADNESS_H5P_MUTEX
+#endif
+
+namespace madness {
+    namespace archive {
+
+        namespace {
+            const std::size_t chunk_nbyte = 1ul<<20; ///< Default size of the chunks of a table
+            const std::size_t max_message = 1ul<<30; ///< Maximum bytes per message when gathering rows
+
+            /// Throws if an HDF5 call returned an error
+            template <typename R>
+            R h5_check(R status, const char* msg) {
+                if (status < 0) MADNESS_EXCEPTION(msg, int(status));
+                return status;
+            }
+
+            std::string record_name(std::size_t record) {
+                char buf[32];
+                snprintf(buf, sizeof(buf), "record_%06zu", record);
+                return buf;
+            }
+
+            void write_string_attribute(hid_t obj, const char* name, const std::string& value) {
+                hid_t type = H5Tcopy(H5T_C_S1);
+                H5Tset_size(type, std::max<std::size_t>(value.size(), 1));
+                H5Tset_strpad(type, H5T_STR_NULLPAD);
+                hid_t space = H5Screate(H5S_SCALAR);
+                hid_t attr = h5_check(H5Acreate2(obj, name, type, space, H5P_DEFAULT, H5P_DEFAULT),
+                                      "H5POutputArchive: could not create attribute");
+                std::string padded = value;
+                padded.resize(std::max<std::size_t>(value.size(), 1), '\0');
+                h5_check(H5Awrite(attr, type, padded.data()), "H5POutputArchive: could not write attribute");
+                H5Aclose(attr);
+                H5Sclose(space);
+                H5Tclose(type);
+            }
+
+            std::string read_string_attribute(hid_t obj, const char* name) {
+                hid_t attr = h5_check(H5Aopen(obj, name, H5P_DEFAULT), "H5PInputArchive: missing attribute");
+                hid_t type = H5Aget_type(attr);
+                std::vector<char> value(H5Tget_size(type) + 1, '\0');
+                hid_t memtype = H5Tcopy(H5T_C_S1);
+                H5Tset_size(memtype, value.size() - 1);
+                H5Tset_strpad(memtype, H5T_STR_NULLPAD);
+                h5_check(H5Aread(attr, memtype, value.data()), "H5PInputArchive: could not read attribute");
+                H5Tclose(memtype);
+                H5Tclose(type);
+                H5Aclose(attr);
+                return std::string(value.data());
+            }
+
+            /// Write nrow rows starting at row first of a table, or nothing if nrow is zero
+            void write_slab(hid_t dset, int rank, hid_t type, hid_t dxpl, hsize_t first,
+                            hsize_t nrow, hsize_t ncol, const void* data) {
+                hid_t filespace = H5Dget_space(dset);
+                hsize_t mdims[2] = {std::max<hsize_t>(nrow, 1), ncol};
+                hid_t memspace = H5Screate_simple(rank, mdims, nullptr);
+                if (nrow > 0) {
+                    hsize_t start[2] = {first, 0};
+                    hsize_t count[2] = {nrow, ncol};
+                    H5Sselect_hyperslab(filespace, H5S_SELECT_SET, start, nullptr, count, nullptr);
+                } else {
+                    H5Sselect_none(filespace);
+                    H5Sselect_none(memspace);
+                }
+                const unsigned char dummy = 0;
+                h5_check(H5Dwrite(dset, type, memspace, filespace, dxpl, nrow ? data : &dummy),
+                         "H5POutputArchive: could not write dataset");
+                H5Sclose(memspace);
+                H5Sclose(filespace);
+            }
+
+            /// Returns the number of rows and columns of a table
+            std::pair<std::size_t,std::size_t> table_shape(hid_t group, const char* name) {
+                hid_t dset = h5_check(H5Dopen2(group, name, H5P_DEFAULT), "H5PInputArchive: missing dataset");
+                hid_t space = H5Dget_space(dset);
+                hsize_t dims[2] = {0, 1};
+                const int rank = H5Sget_simple_extent_ndims(space);
+                MADNESS_CHECK(rank == 1 || rank == 2);
+                H5Sget_simple_extent_dims(space, dims, nullptr);
+                H5Sclose(space);
+                H5Dclose(dset);
+                return std::make_pair(std::size_t(dims[0]), std::size_t(rank == 2 ? dims[1] : 1));
+            }
+
+            /// Read the given rows of a table, merging consecutive rows into one hyperslab
+            void read_table_rows(hid_t group, const char* name, hid_t type, void* data,
+                                 const std::vector<std::size_t>& rows) {
+                hid_t dset = h5_check(H5Dopen2(group, name, H5P_DEFAULT), "H5PInputArchive: missing dataset");
+                hid_t filespace = H5Dget_space(dset);
+                const int rank = H5Sget_simple_extent_ndims(filespace);
+                hsize_t dims[2] = {0, 1};
+                H5Sget_simple_extent_dims(filespace, dims, nullptr);
+                const hsize_t ncol = (rank == 2) ? dims[1] : 1;
+
+                H5Sselect_none(filespace);
+                for (std::size_t i=0; i<rows.size(); ) {
+                    std::size_t j = i+1;
+                    while (j < rows.size() && rows[j] == rows[j-1]+1) ++j;
+                    MADNESS_CHECK(rows[j-1] < dims[0]);
+                    MADNESS_CHECK(j == rows.size() || rows[j] > rows[j-1]);
+                    hsize_t start[2] = {rows[i], 0};
+                    hsize_t count[2] = {j-i, ncol};
+                    H5Sselect_hyperslab(filespace, (i == 0) ? H5S_SELECT_SET : H5S_SELECT_OR,
+                                        start, nullptr, count, nullptr);
+                    i = j;
+                }
+
+                hsize_t mdims[2] = {std::max<hsize_t>(rows.size(), 1), ncol};
+                hid_t memspace = H5Screate_simple(rank, mdims, nullptr);
+                if (rows.empty()) H5Sselect_none(memspace);
+                unsigned char dummy = 0;
+                h5_check(H5Dread(dset, type, memspace, filespace, H5P_DEFAULT, rows.empty() ? &dummy : data),
+                         "H5PInputArchive: could not read dataset");
+                H5Sclose(memspace);
+                H5Sclose(filespace);
+                H5Dclose(dset);
+            }
+        }
+
+        bool H5POutputArchive::writes() const {
+#ifdef H5_HAVE_PARALLEL
+            return world != nullptr;
+#else
+            return world != nullptr && world->rank() == 0;
+#endif
+        }
+
+        void H5POutputArchive::open(World& world, const char* filename) {
+            MADNESS_ASSERT(filename);
+            close();
+            this->world = &world;
+            if (writes()) {
+                MADNESS_H5P_MUTEX;
+                hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+#ifdef H5_HAVE_PARALLEL
+                H5Pset_fapl_mpio(fapl, world.mpi.comm().Get_mpi_comm(), MPI_INFO_NULL);
+#endif
+                file = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+                H5Pclose(fapl);
+                if (file < 0) MADNESS_EXCEPTION("H5POutputArchive: could not create file", 0);
+            }
+            nrecord = 0;
+            inrecord = false;
+            buf.clear();
+        }
+
+        void H5POutputArchive::flush() {
+            if (!world || inrecord) return;
+            std::uint64_t n = buf.size();
+            world->gop.broadcast(n, 0);
+            if (n == 0) return;
+            create_record("local");
+            hid_t type = H5Type<std::uint8_t>::create();
+            write_rows("data", type, 1, buf.data(), world->rank() == 0 ? buf.size() : 0, 1, 0);
+            H5Tclose(type);
+            end_record();
+            buf.clear();
+        }
+
+        void H5POutputArchive::write_segments(const std::vector<unsigned char>& data) {
+            begin_record("container");
+            write_rows("data", data, 1);
+            write_rows("segment_size", std::vector<std::uint64_t>(1, data.size()), 1);
+            end_record();
+        }
+
+        void H5POutputArchive::begin_record(const char* kind) {
+            MADNESS_ASSERT(world);
+            flush();
+            create_record(kind);
+        }
+
+        void H5POutputArchive::create_record(const char* kind) {
+            MADNESS_ASSERT(world && !inrecord);
+            if (writes()) {
+                MADNESS_H5P_MUTEX;
+                group = h5_check(H5Gcreate2(file, record_name(nrecord).c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT),
+                                 "H5POutputArchive: could not create group");
+                write_string_attribute(group, "kind", kind);
+            }
+            ++nrecord;
+            inrecord = true;
+        }
+
+        std::size_t H5POutputArchive::write_rows(const char* name, hid_t type, std::size_t size, const void* data,
+                                                 std::size_t nrow, std::size_t ncol, std::size_t chunk_row) {
+            MADNESS_ASSERT(world && inrecord);
+
+            // The rows of each process follow those of the processes of lower rank
+            const int nproc = world->size();
+            const int me = world->rank();
+            std::vector<std::uint64_t> counts(nproc, 0);
+            counts[me] = nrow;
+            world->gop.sum(counts.data(), nproc);
+            std::vector<std::uint64_t> offsets(nproc+1, 0);
+            for (int p=0; p<nproc; ++p) offsets[p+1] = offsets[p] + counts[p];
+
+            // Chunks hold whole rows, i.e. whole items such as the coefficients of a node
+            if (chunk_row == 0) chunk_row = std::max<std::size_t>(1, chunk_nbyte/(ncol*size));
+            const int rank = (ncol == 1) ? 1 : 2;
+
+#ifndef H5_HAVE_PARALLEL
+            const Tag tag = world->mpi.unique_tag();
+            if (me != 0) {
+                const unsigned char* ptr = (const unsigned char*) data;
+                const std::size_t nbyte = nrow*ncol*size;
+                for (std::size_t lo=0; lo<nbyte; lo+=max_message) {
+                    world->mpi.Send(ptr+lo, std::min(nbyte-lo, max_message), 0, tag);
+                }
+                return offsets[me];
+            }
+#endif
+
+            hid_t dset;
+            {
+                MADNESS_H5P_MUTEX;
+                hsize_t dims[2] = {offsets[nproc], ncol};
+                hsize_t maxdims[2] = {H5S_UNLIMITED, ncol};
+                hsize_t chunk[2] = {chunk_row, ncol};
+                hid_t space = H5Screate_simple(rank, dims, maxdims);
+                hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+                H5Pset_chunk(dcpl, rank, chunk);
+                dset = h5_check(H5Dcreate2(group, name, type, space, H5P_DEFAULT, dcpl, H5P_DEFAULT),
+                                "H5POutputArchive: could not create dataset");
+                H5Pclose(dcpl);
+                H5Sclose(space);
+#ifdef H5_HAVE_PARALLEL
+                hid_t dxpl = H5Pcreate(H5P_DATASET_XFER);
+                H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE);
+                write_slab(dset, rank, type, dxpl, offsets[me], nrow, ncol, data);
+                H5Pclose(dxpl);
+#else
+                write_slab(dset, rank, type, H5P_DEFAULT, 0, nrow, ncol, data);
+#endif
+            }
+
+#ifndef H5_HAVE_PARALLEL
+            // Process zero writes the rows of the others as they arrive
+            std::vector<unsigned char> v;
+            for (int p=1; p<nproc; ++p) {
+                const std::size_t nbyte = counts[p]*ncol*size;
+                v.resize(nbyte);
+                for (std::size_t lo=0; lo<nbyte; lo+=max_message) {
+                    world->mpi.Recv(v.data()+lo, std::min(nbyte-lo, max_message), p, tag);
+                }
+                write_slab(dset, rank, type, H5P_DEFAULT, offsets[p], counts[p], ncol, v.data());
+            }
+#endif
+            {
+                MADNESS_H5P_MUTEX;
+                H5Dclose(dset);
+            }
+            return offsets[me];
+        }
+
+        void H5POutputArchive::write_attribute(const char* name, const std::vector<std::int64_t>& value) {
+            MADNESS_ASSERT(world && inrecord && !value.empty());
+            if (!writes()) return;
+            MADNESS_H5P_MUTEX;
+            hsize_t n = value.size();
+            hid_t space = H5Screate_simple(1, &n, nullptr);
+            hid_t attr = h5_check(H5Acreate2(group, name, H5T_NATIVE_INT64, space, H5P_DEFAULT, H5P_DEFAULT),
+                                  "H5POutputArchive: could not create attribute");
+            h5_check(H5Awrite(attr, H5T_NATIVE_INT64, value.data()), "H5POutputArchive: could not write attribute");
+            H5Aclose(attr);
+            H5Sclose(space);
+        }
+
+        void H5POutputArchive::end_record() {
+            if (group >= 0) {
+                MADNESS_H5P_MUTEX;
+                H5Gclose(group);
+            }
+            group = -1;
+            inrecord = false;
+        }
+
+        void H5POutputArchive::close() {
+            if (!world) return;
+            end_record();
+            flush();
+            if (file >= 0) {
+                MADNESS_H5P_MUTEX;
+                H5Fclose(file);
+            }
+            file = -1;
+            world = nullptr;
+            nrecord = 0;
+        }
+
+        void H5PInputArchive::open(World& world, const char* filename) {
+            MADNESS_ASSERT(filename);
+            close();
+            {
+                MADNESS_H5P_MUTEX;
+                hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+#ifdef H5_HAVE_PARALLEL
+                H5Pset_fapl_mpio(fapl, world.mpi.comm().Get_mpi_comm(), MPI_INFO_NULL);
+#endif
+                file = H5Fopen(filename, H5F_ACC_RDONLY, fapl);
+                H5Pclose(fapl);
+            }
+            if (file < 0) MADNESS_EXCEPTION("H5PInputArchive: could not open file", 0);
+            this->world = &world;
+
+            kinds.clear();
+            if (world.rank() == 0) {
+                MADNESS_H5P_MUTEX;
+                for (std::size_t i=0; H5Lexists(file, record_name(i).c_str(), H5P_DEFAULT) > 0; ++i) {
+                    hid_t g = H5Gopen2(file, record_name(i).c_str(), H5P_DEFAULT);
+                    kinds.push_back(read_string_attribute(g, "kind"));
+                    H5Gclose(g);
+                }
+            }
+            world.gop.broadcast_serializable(kinds, 0);
+            next = 0;
+            buf.clear();
+            pos = 0;
+        }
+
+        void H5PInputArchive::read_local_record() const {
+            MADNESS_ASSERT(world && world->rank() == 0);
+            MADNESS_CHECK(next < kinds.size() && kinds[next] == "local");
+            MADNESS_H5P_MUTEX;
+            hid_t g = h5_check(H5Gopen2(file, record_name(next++).c_str(), H5P_DEFAULT),
+                               "H5PInputArchive: missing record");
+            const std::size_t n = table_shape(g, "data").first;
+            std::vector<std::size_t> rows(n);
+            for (std::size_t i=0; i<n; ++i) rows[i] = i;
+            buf.resize(n);
+            hid_t type = H5Type<std::uint8_t>::create();
+            read_table_rows(g, "data", type, buf.data(), rows);
+            H5Tclose(type);
+            H5Gclose(g);
+            pos = 0;
+        }
+
+        std::vector<std::vector<unsigned char> > H5PInputArchive::read_segments() {
+            begin_record("container");
+            std::vector<std::uint64_t> sizes = read_rows<std::uint64_t>("segment_size", 0, nrow("segment_size"));
+            std::vector<std::uint64_t> offsets(sizes.size()+1, 0);
+            for (std::size_t i=0; i<sizes.size(); ++i) offsets[i+1] = offsets[i] + sizes[i];
+
+            // Distribute the segments round-robin over the readers
+            std::vector<std::vector<unsigned char> > result;
+            for (std::size_t i=world->rank(); i<sizes.size(); i+=world->size()) {
+                if (sizes[i] > 0) result.push_back(read_rows<std::uint8_t>("data", offsets[i], sizes[i]));
+            }
+            end_record();
+            return result;
+        }
+
+        void H5PInputArchive::begin_record(const char* kind) {
+            MADNESS_ASSERT(world);
+            // Process-local records in front of the record are only read by process zero
+            while (next < kinds.size() && kinds[next] == "local") ++next;
+            MADNESS_CHECK(next < kinds.size() && kinds[next] == kind);
+            open_record(next++);
+            buf.clear();
+            pos = 0;
+        }
+
+        void H5PInputArchive::open_record(std::size_t record) {
+            MADNESS_CHECK(file >= 0 && record < kinds.size());
+            end_record();
+            MADNESS_H5P_MUTEX;
+            group = h5_check(H5Gopen2(file, record_name(record).c_str(), H5P_DEFAULT),
+                             "H5PInputArchive: missing record");
+        }
+
+        std::size_t H5PInputArchive::nrow(const char* name) const {
+            MADNESS_ASSERT(group >= 0);
+            MADNESS_H5P_MUTEX;
+            return table_shape(group, name).first;
+        }
+
+        std::size_t H5PInputArchive::ncol(const char* name) const {
+            MADNESS_ASSERT(group >= 0);
+            MADNESS_H5P_MUTEX;
+            return table_shape(group, name).second;
+        }
+
+        std::vector<std::int64_t> H5PInputArchive::read_attribute(const char* name) const {
+            MADNESS_ASSERT(group >= 0);
+            MADNESS_H5P_MUTEX;
+            hid_t attr = h5_check(H5Aopen(group, name, H5P_DEFAULT), "H5PInputArchive: missing attribute");
+            hid_t space = H5Aget_space(attr);
+            std::vector<std::int64_t> value(H5Sget_simple_extent_npoints(space));
+            h5_check(H5Aread(attr, H5T_NATIVE_INT64, value.data()), "H5PInputArchive: could not read attribute");
+            H5Sclose(space);
+            H5Aclose(attr);
+            return value;
+        }
+
+        void H5PInputArchive::read_rows(const char* name, hid_t type, void* data,
+                                        const std::vector<std::size_t>& rows) const {
+            MADNESS_ASSERT(group >= 0);
+            MADNESS_H5P_MUTEX;
+            read_table_rows(group, name, type, data, rows);
+        }
+
+        void H5PInputArchive::end_record() {
+            if (group >= 0) {
+                MADNESS_H5P_MUTEX;
+                H5Gclose(group);
+            }
+            group = -1;
+        }
+
+        void H5PInputArchive::close() {
+            if (file < 0) return;
+            end_record();
+            {
+                MADNESS_H5P_MUTEX;
+                H5Fclose(file);
+            }
+            file = -1;
+            world = nullptr;
+            kinds.clear();
+            next = 0;
+            buf.clear();
+            pos = 0;
+        }
+    }
+}
+
+#endif // HAVE_HDF5
@@ -29,24 +29,52 @@
   fax:   865-572-0680
 */
 
-#ifdef H5_HAVE_PARALLEL
-
 #ifndef MADNESS_WORLD_H5P_ARCHIVE_H__INCLUDED
 #define MADNESS_WORLD_H5P_ARCHIVE_H__INCLUDED
 
 /**
- \file text_fstream_archive.h
- \brief Implements an archive wrapping text filestream.
+ \file h5p_archive.h
+ \brief Implements a parallel archive in a single HDF5 file.
  \ingroup serialization
+
+ Use as the local archive of the parallel archives,
+ \code
+   archive::ParallelOutputArchive<archive::H5POutputArchive> ar(world, "restart.h5");
+   ar & f;
+ \endcode
+
+ The file holds one group per record, named \c record_000000, \c record_000001, ...
+ in the order written, with a string attribute \c kind:
+  - \c "local": data of process-local objects, in the byte dataset \c data;
+  - \c "container": a \c WorldContainer serialized as bytes, in the dataset
+    \c data with one segment per writer whose sizes are in \c segment_size;
+  - any other kind: tables with one row per item, e.g. the nodes of a
+    \c Function (see mra/h5p_function_archive.h).
+
+ Tables are two-dimensional datasets chunked along the rows. If HDF5 was
+ built for parallel I/O, all processes open the file with the MPI-IO driver
+ and write their rows collectively; otherwise process zero writes the rows
+ it gathers from the others. Rows can be read selectively and independently
+ of the other processes, so parts of large objects can be post-processed
+ without loading them entirely.
 */
 
-#include <type_traits>
-#include <fstream>
-#include <cstring>
+#include <madness/madness_config.h>
+
+#ifdef HAVE_HDF5
+#  if ! __has_include("hdf5.h")
+#    error "HAVE_HDF5 is on, but hdf5.h was not found."
+#  endif
+
 #include <madness/world/archive.h>
-#include <madness/world/print.h>  // this injects operator<<(std::ostream,T) for common Ts
+#include <madness/world/parallel_archive.h>
 #include <madness/world/vector_archive.h>
-
+#include <madness/world/worlddc.h>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
 #include "hdf5.h"
 
 namespace madness {
@@ -55,277 +83,313 @@ namespace madness {
         /// \addtogroup serialization
         /// @{
 
-        /// Wraps an archive around a text filestream for output.
+        /// The HDF5 memory type of \c T.
+
+        /// \c create() returns a new type that must be closed by the caller.
+        template <typename T>
+        struct H5Type;
+
+        template <> struct H5Type<std::int8_t> { static hid_t create() {return H5Tcopy(H5T_NATIVE_INT8);} };
+        template <> struct H5Type<std::uint8_t> { static hid_t create() {return H5Tcopy(H5T_NATIVE_UINT8);} };
+        template <> struct H5Type<std::int32_t> { static hid_t create() {return H5Tcopy(H5T_NATIVE_INT32);} };
+        template <> struct H5Type<std::int64_t> { static hid_t create() {return H5Tcopy(H5T_NATIVE_INT64);} };
+        template <> struct H5Type<std::uint64_t> { static hid_t create() {return H5Tcopy(H5T_NATIVE_UINT64);} };
+        template <> struct H5Type<float> { static hid_t create() {return H5Tcopy(H5T_NATIVE_FLOAT);} };
+        template <> struct H5Type<double> { static hid_t create() {return H5Tcopy(H5T_NATIVE_DOUBLE);} };
+
+        /// Complex numbers are compounds of the fields \c r and \c i, as read by h5py.
+        template <typename T>
+        struct H5Type< std::complex<T> > {
+            static hid_t create() {
+                hid_t base = H5Type<T>::create();
+                hid_t type = H5Tcreate(H5T_COMPOUND, sizeof(std::complex<T>));
+                H5Tinsert(type, "r", 0, base);
+                H5Tinsert(type, "i", sizeof(T), base);
+                H5Tclose(base);
+                return type;
+            }
+        };
+
+        /// Collective output archive writing one HDF5 file.
+
+        /// All processes open, flush, write containers and tables and close
+        /// the archive collectively. Only process zero stores process-local
+        /// data, which is buffered and written before the next collective operation.
         class H5POutputArchive : public BaseOutputArchive {
-            mutable std::ofstream os; ///< The filestream.
-	    hid_t   file_id;                                         /* HDF5 file IDs  */
-            hid_t    acc_tpl1;                                        /* File access templates */
-	    hid_t   dataset_id;                                      /* Dataset transfer properties list */
-	    hid_t   dataspace_id;                                    /* Dataspace ID */
-	    hid_t   xfer_plist;                                      /* Dataset transfer properties list */
-	    hid_t   file_dataspace;                                  /* File dataspace ID */
-	    hid_t   mem_dataspace;                                   /* memory dataspace ID */
-	    hid_t   dataset1, dataset2;                              /* Dataset ID */
-
-	    herr_t  status;
-	    mutable std::vector<unsigned char> v;
-            madness::archive::VectorOutputArchive var;
-            mutable World* world; ///< The world.
+            World* world = nullptr; ///< The world, null if not open.
+            hid_t file = -1; ///< The file, only valid on processes that write.
+            hid_t group = -1; ///< The record being written, if any.
+            std::size_t nrecord = 0; ///< Number of records written.
+            bool inrecord = false; ///< True between \c begin_record() and \c end_record().
+            mutable std::vector<unsigned char> buf; ///< Buffered process-local data.
 
         public:
-            /// Default constructor.
-
-            /// The filename and open modes are optional here; they can be
-            /// specified later by calling \c open().
-            /// \param[in] filename Name of the file to write to.
-            /// \param[in] mode I/O attributes for opening the file.
-            H5POutputArchive(World& world, const char* filename = nullptr
-                    ):world(&world), v(), var(v)
-            {
-		    if (filename)
-			    open( world, filename);
-            };
-            void open(World& world,const char* filename) {
-		    std::cout << "h5p this open " << filename << std::endl;
-		    auto iocomm = world.mpi.comm().Get_mpi_comm();
-		    std::cout << "h5p this open comm " << iocomm << std::endl;
-                    auto ioinfo = world.mpi.comm().Get_info();
-
-                     herr_t ret;
-//                    MPI_Info info = MPI_INFO_NULL;
-//		    /* -------------------
-//		     * START AN HDF5 FILE
-//		     * -------------------*/
-//		    /* setup file access template with parallel IO access. */
-		    acc_tpl1 = H5Pcreate(H5P_FILE_ACCESS);
-		    std::cout << "H5Pcreate access succeed" << std::endl;
-//
-//		    /* set Parallel access with communicator */
-		    ret = H5Pset_fapl_mpio(acc_tpl1, iocomm, ioinfo);
-		    std::cout << "H5Pset_fapl_mpio succeed"  << std::endl;
-//
-//		    /* create the file collectively */
-		    file_id = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, acc_tpl1);
-		    std::cout << "H5Fcreate succeed" << std::endl;
-//
-		    /* Release file-access template */
-		    ret = H5Pclose(acc_tpl1);
-
-//		    file_id = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-
-	    } 
-
-
-            /// Store data to the filestream.
-
-            /// The function only appears (due to \c enable_if) if \c T is
-            /// serializable.
+            H5POutputArchive() = default;
+
+            /// Collectively create the file \c filename.
+            H5POutputArchive(World& world, const char* filename) {
+                open(world, filename);
+            }
+
+            H5POutputArchive(const H5POutputArchive&) = delete;
+            H5POutputArchive& operator=(const H5POutputArchive&) = delete;
+
+            ~H5POutputArchive() {
+                close();
+            }
+
+            /// Buffer process-local data.
+
             /// \tparam T The type of data to be written.
             /// \param[in] t Location of the data to be written.
             /// \param[in] n The number of data items to be written.
             template <class T>
-            typename std::enable_if< madness::is_ostreammable_v<T> >::type
+            inline
+            typename std::enable_if< is_trivially_serializable<T>::value, void >::type
             store(const T* t, long n) const {
-                //using madness::operators::operator<<;
-	        std::cout << "h5p this store 1 v " << v.size() << std::endl;
-	        std::cout << "h5p this store 1 n " << n << std::endl;
-		if (n > 0) {
-			var.store(t, n);
-//			//here flush
-		}
+                const unsigned char* ptr = (const unsigned char*) t;
+                buf.insert(buf.end(), ptr, ptr+n*sizeof(T));
             }
 
-            void close(){
-		   // flush();
-		    std::cout << "h5p this close " <<  std::endl;
-//		    status = H5Dclose(dataset_id);
-//		    status = H5Sclose(dataspace_id);
-		    status = H5Fclose(file_id);
-	    }
-
-            /// Flush the filestream.
-            void flush()  {
-		   std::cout << "h5p this flush " <<  std::endl;
-		   int dims = 1 ;
-		   hsize_t dimens_1d = v.size();
-	           std::cout << "h5p this flush 1 v " << v.size() << std::endl;
-
-                     herr_t ret;
-                   std::cout <<"h5p flush my rank " <<world->rank() << std::endl;
-                   int my =2 ;
-                   int total =2 ;
-                     
-                   
-//
-////		   dataspace_id = H5Screate_simple(dims, &dimens_1d, NULL);
-//                  dataspace_id = H5Screate_simple(dims, &dimens_1d, NULL);
-//		   std::cout << "h5p this dataspace created " <<  std::endl;
-//
-////		    /* Create the dataset. */
-//
-//                    dataset_id =
-//                        H5Dcreate2(file_id, "/dset", H5T_NATIVE_UCHAR,  dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-////			    H5Dcreate2(file_id, "/dset", H5T_NATIVE_UCHAR, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-////		    status = H5Dwrite(dataset_id, H5T_NATIVE_UCHAR, H5S_ALL, H5S_ALL, H5P_DEFAULT, v.data());
-//                  file_dataspace = H5Dget_space (dataset_id);
-//                  xfer_plist = H5Pcreate(H5P_DATASET_XFER);
-//                 ret = H5Pset_dxpl_mpio(xfer_plist, H5FD_MPIO_COLLECTIVE);
-//		   std::cout << "h5p this flush H5Pcreate xfer succeed created " <<  std::endl;
-//
-//
-//
-//                 hsize_t stride = 1;
-//                 hsize_t count  = dimens_1d / world.mpi.comm().Get_rank();
-//                 hsize_t start  = mpi_rank * count[0];
-
-//                 ret = H5Sselect_hyperslab(file_dataspace, H5S_SELECT_SET, &file_offset, &stride, &dsize, NULL); //stride=NULL?
-//                 ret = H5Sselect_hyperslab(file_dataspace, H5S_SELECT_SET, start, stride, count, NULL);
-//
-//                 ret = H5Dwrite(dataset1, H5T_NATIVE_INT, mem_dataspace, file_dataspace, xfer_plist, data_array1);
+            /// Collectively create and truncate the file.
+
+            /// \param[in] world The world of the processes sharing the file.
+            /// \param[in] filename The name of the file.
+            void open(World& world, const char* filename);
+
+            /// Collectively write the buffered process-local data as a record.
+            void flush();
+
+            /// Collectively write one segment of bytes per process as a record.
+
+            /// \param[in] data The bytes of this process, may be empty.
+            void write_segments(const std::vector<unsigned char>& data);
+
+            /// Collectively begin a record of tables.
+
+            /// \param[in] kind The kind of the record, stored as its attribute.
+            void begin_record(const char* kind);
+
+            /// Collectively write a table of the current record.
+
+            /// The rows of all processes are stored in rank order.
+            /// \param[in] name The name of the dataset.
+            /// \param[in] data The \c nrow x \c ncol elements of this process in row-major order.
+            /// \param[in] ncol The number of columns, the same on all processes.
+            /// \param[in] chunk_row Rows per chunk, by default about a megabyte.
+            /// \return The index of the first row of this process in the table.
+            template <typename T>
+            std::size_t write_rows(const char* name, const std::vector<T>& data, std::size_t ncol,
+                                   std::size_t chunk_row=0) {
+                MADNESS_ASSERT(ncol > 0 && data.size()%ncol == 0);
+                hid_t type = H5Type<T>::create();
+                const std::size_t first = write_rows(name, type, sizeof(T), data.data(), data.size()/ncol, ncol, chunk_row);
+                H5Tclose(type);
+                return first;
             }
 
-            /// Destructor.
-//            ~H5POutputArchive() {
-//                close();
-//            }
-        }; // class H5POutputArchive
+            /// Collectively attach integers to the current record.
+
+            /// \param[in] name The name of the attribute.
+            /// \param[in] value The value, the same on all processes.
+            void write_attribute(const char* name, const std::vector<std::int64_t>& value);
+
+            /// Collectively end the current record.
+            void end_record();
+
+            /// Collectively write the buffered data and close the file.
+            void close();
 
+        private:
+            /// True if this process calls HDF5 to write.
+            bool writes() const;
 
-        /// Wraps an archive around a text filestream for input.
+            /// Collectively create the group of the next record.
+            void create_record(const char* kind);
+
+            std::size_t write_rows(const char* name, hid_t type, std::size_t size, const void* data,
+                                   std::size_t nrow, std::size_t ncol, std::size_t chunk_row);
+        };
+
+        /// Collective input archive reading a file written by \c H5POutputArchive.
+
+        /// The number of readers need not match the number of writers. The
+        /// records can also be read in any order and independently on each
+        /// process with \c open_record() and \c read_rows().
         class H5PInputArchive : public BaseInputArchive {
-	    hid_t   file_id; /* identifiers */
-	    hid_t   dataset_id; /* identifiers */
-	    hid_t   dataspace_id; /* identifiers */
-	    herr_t  status;
-	    mutable std::vector<unsigned char> v;
-	    madness::archive::VectorInputArchive var;
-	    mutable std::size_t i; ///< Current input location.
+            World* world = nullptr; ///< The world, null if not open.
+            hid_t file = -1; ///< The file.
+            hid_t group = -1; ///< The record being read, if any.
+            std::vector<std::string> kinds; ///< Kind of each record.
+            mutable std::size_t next = 0; ///< Next record to read.
+            mutable std::vector<unsigned char> buf; ///< Current record of process-local data.
+            mutable std::size_t pos = 0; ///< Read position in \c buf.
 
         public:
-            /// Default constructor.
-
-            /// The filename and open modes are optional here; they can be
-            /// specified later by calling \c open().
-            /// \param[in] filename Name of the file to read from.
-            /// \param[in] mode I/O attributes for opening the file.
-            H5PInputArchive(const char* filename = nullptr
-                    ): v(), var(v)
-            {
-                if (filename)
-                    open(filename);
+            H5PInputArchive() = default;
+
+            /// Collectively open the file \c filename.
+            H5PInputArchive(World& world, const char* filename) {
+                open(world, filename);
+            }
+
+            H5PInputArchive(const H5PInputArchive&) = delete;
+            H5PInputArchive& operator=(const H5PInputArchive&) = delete;
+
+            ~H5PInputArchive() {
+                close();
             }
-            void open(const char* filename) {
-		    std::cout << "h5p input this open " << filename << std::endl;
-		    //file_id = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-		    file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
-//
-		    dataset_id = H5Dopen2(file_id, "/dset", H5P_DEFAULT);
-//
-		    hid_t datatype = H5Dget_type(dataset_id);
-		    size_t size = H5Tget_size(datatype);
-		    H5T_class_t t_class  = H5Tget_class(datatype);
-		    if(t_class == H5T_INTEGER)
-		    std::cout << "h5p input ajua"  << (int)t_class<< std::endl;
-		    std::cout << "h5p input  size "<< (int)size << std::endl;
-		    hid_t dataspace_id = H5Dget_space(dataset_id); /* dataspace handle */
-		    int rank = H5Sget_simple_extent_ndims(dataspace_id);
-		    std::cout << "h5p input  rank "<< (int)rank << std::endl;
-		    hsize_t dims_out[1];
-		    status  = H5Sget_simple_extent_dims(dataspace_id, dims_out, NULL);
-		    printf("h5p input rank %d, dimensions %lu x %lu \n", rank, (unsigned long)(dims_out[0]),
-           (unsigned long)(dims_out[0]));
-		v.resize((unsigned long)(dims_out[0]));
-		    status = H5Dread(dataset_id, H5T_NATIVE_UCHAR, H5S_ALL, H5S_ALL, H5P_DEFAULT, v.data());
-//  	    status = H5Dread(dataset_id, H5T_NATIVE_UCHAR, H5S_ALL, H5S_ALL, H5P_DEFAULT, v.data());
-//
-//		    int dims = 1 ;
-//		    hsize_t dimens_1d = v->size();
-//
-//		    dataspace_id = H5Screate_simple(dims, &dimens_1d, NULL);
-//
-//		    /* Create the dataset. */
-//                    dataset_id =
-//		      H5Dcreate2(file_id, "/dset", H5T_NATIVE_UCHAR, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-	    } 
-            /// The function only appears (due to \c enable_if) if \c T is
-            /// serializable.
+
+            /// Load process-local data, only called on process zero.
+
             /// \tparam T The type of data to be read.
             /// \param[out] t Where to put the loaded data.
             /// \param[in] n The number of data items to be loaded.
             template <class T>
-            typename std::enable_if< madness::is_istreammable_v<T> >::type
+            inline
+            typename std::enable_if< is_trivially_serializable<T>::value, void >::type
             load(T* t, long n) const {
-		    std::cout << "h5p input this load " << std::endl;
-	        std::cout << "h5p input this load 1 n " << n << std::endl;
-                std::cout << "h5p this store 1 v " << v.size() << std::endl;
-		var.load(t,n);
+                const std::size_t nbyte = n*sizeof(T);
+                if (pos == buf.size()) read_local_record();
+                MADNESS_CHECK(pos + nbyte <= buf.size());
+                memcpy((unsigned char*) t, &buf[pos], nbyte);
+                pos += nbyte;
             }
-            /// Close the filestream.
-            void close() {
-		    std::cout << "h5p inp this close " <<  std::endl;
-		    status = H5Dclose(dataset_id);
-//		    status = H5Sclose(dataspace_id);
-		    status = H5Fclose(file_id);
-            }
-            /// Destructor.
-//            ~H5PInputArchive() {
-//                close();
-//            }
-        }; // class H5PInputArchive
 
-        /// Implement pre/postamble storage routines for a \c TextFstreamOutputArchive.
+            /// Collectively open the file and list its records.
 
-        /// \tparam T The type to be stored.
-        template <class T>
-        struct ArchivePrePostImpl<H5POutputArchive, T> {
-            /// Write the preamble to the archive.
+            /// \param[in] world The world of the processes sharing the file.
+            /// \param[in] filename The name of the file.
+            void open(World& world, const char* filename);
 
-            /// \param[in] ar The archive.
-            static void preamble_store(const H5POutputArchive& ar) {
+            /// Returns the number of records in the file.
+            std::size_t size() const {
+                return kinds.size();
             }
 
-            /// Write the postamble to the archive.
-
-            /// \param[in] ar The archive.
-            static inline void postamble_store(const H5POutputArchive& ar) {
+            /// Returns the kind of a record.
+            const std::string& kind(std::size_t record) const {
+                MADNESS_CHECK(record < kinds.size());
+                return kinds[record];
             }
-        }; // struct ArchivePrePostImpl<TextFstreamOutputArchive,T>
 
-        /// Implement pre/postamble load routines for a \c TextFstreamInputArchive.
+            /// Collectively read the segments of the next container.
+
+            /// \return The segments assigned to this process.
+            std::vector<std::vector<unsigned char> > read_segments();
+
+            /// Collectively open the next record of tables, skipping process-local records.
+
+            /// \param[in] kind The expected kind of the record.
+            void begin_record(const char* kind);
 
-        /// \tparam T The expected type to be loaded.
-        template <class T>
-        struct ArchivePrePostImpl<H5PInputArchive,T> {
-            /// Load the preamble and perform type-checking.
+            /// Open a record of tables by its index.
 
-            /// \param[in] ar The archive.
-            static inline void preamble_load(const H5PInputArchive& ar) {
+            /// This is independent of the other processes and of the
+            /// sequential reading with \c begin_record() and \c load().
+            /// \param[in] record The index of the record.
+            void open_record(std::size_t record);
+
+            /// Returns the number of rows of a table of the current record.
+            std::size_t nrow(const char* name) const;
+
+            /// Returns the integers attached to the current record.
+            std::vector<std::int64_t> read_attribute(const char* name) const;
+
+            /// Reads consecutive rows of a table of the current record.
+
+            /// \param[in] name The name of the dataset.
+            /// \param[in] first The first row.
+            /// \param[in] count The number of rows.
+            /// \return The elements of the rows in row-major order.
+            template <typename T>
+            std::vector<T> read_rows(const char* name, std::size_t first, std::size_t count) const {
+                std::vector<std::size_t> rows(count);
+                for (std::size_t i=0; i<count; ++i) rows[i] = first + i;
+                return read_rows<T>(name, rows);
             }
 
-            /// Load the postamble and perform type-checking.
+            /// Reads selected rows of a table of the current record.
+
+            /// Only the chunks holding the rows are read from the file.
+            /// \param[in] name The name of the dataset.
+            /// \param[in] rows The indices of the rows in increasing order.
+            /// \return The elements of the rows in row-major order.
+            template <typename T>
+            std::vector<T> read_rows(const char* name, const std::vector<std::size_t>& rows) const {
+                const std::size_t ncol = this->ncol(name);
+                std::vector<T> data(rows.size()*ncol);
+                hid_t type = H5Type<T>::create();
+                read_rows(name, type, data.data(), rows);
+                H5Tclose(type);
+                return data;
+            }
+
+            /// End reading the current record.
+            void end_record();
+
+            /// Collectively close the file.
+            void close();
 
-            /// \param[in] ar The archive.
-            static inline void postamble_load(const H5PInputArchive& ar) {
+            void flush() {}
+
+        private:
+            /// Read the next record of process-local data into \c buf.
+            void read_local_record() const;
+
+            std::size_t ncol(const char* name) const;
+
+            void read_rows(const char* name, hid_t type, void* data, const std::vector<std::size_t>& rows) const;
+        };
+
+        /// Local archives that all processes open collectively on one file.
+        template <>
+        struct is_shared_file_archive<H5POutputArchive> : std::true_type {};
+        template <>
+        struct is_shared_file_archive<H5PInputArchive> : std::true_type {};
+
+        /// Write container to an HDF5 parallel archive.
+
+        /// \ingroup worlddc
+        /// Every process serializes its local data as a sequential archive
+        /// would and writes it as one segment of the record.
+        template <class keyT, class valueT>
+        struct ArchiveStoreImpl< ParallelOutputArchive<H5POutputArchive>, WorldContainer<keyT,valueT> > {
+            static void store(const ParallelOutputArchive<H5POutputArchive>& ar, const WorldContainer<keyT,valueT>& t) {
+                World* world = ar.get_world();
+                if (ar.dofence()) world->gop.fence();
+                std::vector<unsigned char> v;
+                VectorOutputArchive var(v);
+                var & t;
+                ar.local_archive().write_segments(v);
+                if (ar.dofence()) world->gop.fence();
+            }
+        };
+
+        /// Read container from an HDF5 parallel archive.
+
+        /// \ingroup worlddc
+        /// The segments are read round-robin by the current processes and
+        /// the values are inserted with \c replace(), which sends them to
+        /// their owner in the current process map.
+        template <class keyT, class valueT>
+        struct ArchiveLoadImpl< ParallelInputArchive<H5PInputArchive>, WorldContainer<keyT,valueT> > {
+            static void load(const ParallelInputArchive<H5PInputArchive>& ar, WorldContainer<keyT,valueT>& t) {
+                World* world = ar.get_world();
+                if (ar.dofence()) world->gop.fence();
+                std::vector<std::vector<unsigned char> > segments = ar.local_archive().read_segments();
+                for (auto& v : segments) {
+                    VectorInputArchive var(v);
+                    var & t;
+                }
+                if (ar.dofence()) world->gop.fence();
             }
-        }; // struct ArchivePrePostImpl<TextFstreamInputArchive,T>
+        };
 
         /// @}
     }
+}
 
-    template <>
-    struct is_archive<archive::H5POutputArchive> : std::true_type {};
-    template <>
-    struct is_archive<archive::H5PInputArchive> : std::true_type {};
-    template <>
-    struct is_output_archive<archive::H5POutputArchive> : std::true_type {};
-    template <>
-    struct is_input_archive<archive::H5PInputArchive> : std::true_type {};
-    template <typename T>
-    struct is_default_serializable_helper<archive::H5POutputArchive, T, std::enable_if_t<is_iostreammable_v<T> || std::is_function_v<T> || is_any_function_pointer_v<T>>> : std::true_type {};
-    template <typename T>
-    struct is_default_serializable_helper<archive::H5PInputArchive, T, std::enable_if_t<is_iostreammable_v<T> || is_any_function_pointer_v<T>>> : std::true_type {};
-
-} //namespace
+#endif // HAVE_HDF5
 
 #endif // MADNESS_WORLD_H5P_ARCHIVE_H__INCLUDED
-#endif // H5_HAVE_PARALLEL
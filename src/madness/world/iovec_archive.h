@@ -0,0 +1,196 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+#ifndef MADNESS_WORLD_IOVEC_ARCHIVE_H__INCLUDED
+#define MADNESS_WORLD_IOVEC_ARCHIVE_H__INCLUDED
+
+/**
+ \file iovec_archive.h
+ \brief Implements a scatter-gather archive that references large arrays instead of copying them.
+ \ingroup serialization
+*/
+
+#include <type_traits>
+#include <madness/world/archive.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <sys/uio.h>
+
+namespace madness {
+    namespace archive {
+
+        /// \addtogroup serialization
+        /// @{
+
+        /// An output archive recording the stream as a list of (pointer, length) segments.
+
+        /// Small fields are copied into an internal buffer. Large contiguous
+        /// arrays stored with \c store_reference() are only referenced; their
+        /// owner is kept alive by the archive, but the data must not be
+        /// modified until the segments are sent or gathered. The stream is
+        /// byte-for-byte that of a \c BufferOutputArchive, so it is read with
+        /// a \c BufferInputArchive. Unlike the latter it needs no counting pass.
+        ///
+        /// \note Type checking is disabled for efficiency.
+        class IovecOutputArchive : public BaseOutputArchive {
+        public:
+            /// Arrays smaller than this are copied rather than referenced.
+            static constexpr std::size_t min_reference_nbyte = 4096;
+
+        private:
+            /// A piece of the stream, either referenced or at an offset into the inline buffer.
+            struct Segment {
+                const unsigned char* ptr; ///< The referenced data, null if inline.
+                std::size_t offset; ///< Offset into the inline buffer.
+                std::size_t nbyte; ///< Length of the segment.
+            };
+
+            mutable std::vector<unsigned char> buf; ///< Inline data.
+            mutable std::vector<Segment> segments; ///< The stream, in order.
+            mutable std::vector<std::shared_ptr<const void>> owners; ///< Keep referenced data alive.
+            mutable std::size_t nbyte=0; ///< Total size of the stream.
+
+        public:
+            IovecOutputArchive() = default;
+
+            /// Stores data by copying it into the inline buffer.
+
+            /// The function only appears (due to \c enable_if) if \c T is
+            /// serializable.
+            /// \tparam T Type of the data to be stored.
+            /// \param[in] t Pointer to the data to be stored.
+            /// \param[in] n Size of data to be stored.
+            template <typename T>
+            inline
+            typename std::enable_if< madness::is_trivially_serializable<T>::value, void >::type
+            store(const T* t, long n) const {
+                const std::size_t m = n*sizeof(T);
+                if (m == 0) return;
+                if (segments.empty() or segments.back().ptr) segments.push_back(Segment{nullptr, buf.size(), 0});
+                buf.insert(buf.end(), (const unsigned char*)(t), (const unsigned char*)(t) + m);
+                segments.back().nbyte += m;
+                nbyte += m;
+            }
+
+            /// Stores an array by reference if it is large enough, otherwise by copy.
+
+            /// \tparam T Type of the data to be stored.
+            /// \param[in] t Pointer to the data, which must stay unmodified until sent or gathered.
+            /// \param[in] n Number of elements.
+            /// \param[in] owner Shared ownership of the data, kept until the archive is destroyed.
+            template <typename T>
+            inline
+            typename std::enable_if< madness::is_trivially_serializable<T>::value, void >::type
+            store_reference(const T* t, long n, std::shared_ptr<const void> owner=nullptr) const {
+                const std::size_t m = n*sizeof(T);
+                if (m < min_reference_nbyte) {
+                    store(t, n);
+                    return;
+                }
+                segments.push_back(Segment{(const unsigned char*)(t), 0, m});
+                if (owner) owners.push_back(std::move(owner));
+                nbyte += m;
+            }
+
+            /// Open the archive.
+            void open(std::size_t /*hint*/) {}
+
+            /// Close the archive.
+            void close() {}
+
+            /// Flush the archive.
+            void flush() {}
+
+            /// The archive never just counts, everything stored is sent.
+
+            /// \return False.
+            bool count_only() const { return false; }
+
+            /// Return the size of the stream.
+
+            /// \return The number of bytes stored.
+            std::size_t size() const {
+                return nbyte;
+            }
+
+            /// Return the number of referenced arrays.
+
+            /// \return The number of arrays stored by reference.
+            std::size_t nreference() const {
+                std::size_t n = 0;
+                for (const Segment& s : segments) if (s.ptr) ++n;
+                return n;
+            }
+
+            /// Copies the stream into contiguous memory.
+
+            /// \param[out] ptr Buffer of at least \c size() bytes.
+            void gather(void* ptr) const {
+                unsigned char* p = static_cast<unsigned char*>(ptr);
+                for (const Segment& s : segments) {
+                    std::memcpy(p, s.ptr ? s.ptr : buf.data()+s.offset, s.nbyte);
+                    p += s.nbyte;
+                }
+            }
+
+            /// Returns the stream as a list of (pointer, length) pairs.
+
+            /// The pointers into the inline buffer are invalidated by further stores.
+            /// \return The segments in order.
+            std::vector<struct iovec> iov() const {
+                std::vector<struct iovec> result(segments.size());
+                for (std::size_t i=0; i<segments.size(); ++i) {
+                    const Segment& s = segments[i];
+                    result[i].iov_base = const_cast<unsigned char*>(s.ptr ? s.ptr : buf.data()+s.offset);
+                    result[i].iov_len = s.nbyte;
+                }
+                return result;
+            }
+        };
+
+        /// Implement pre/postamble storage routines for an \c IovecOutputArchive.
+
+        /// \note No type checking, for efficiency.
+        /// \tparam T The type to be stored.
+        template <class T>
+        struct ArchivePrePostImpl<IovecOutputArchive, T> {
+            /// Write the preamble to the archive.
+            static inline void preamble_store(const IovecOutputArchive& /*ar*/) {}
+
+            /// Write the postamble to the archive.
+            static inline void postamble_store(const IovecOutputArchive& /*ar*/) {}
+        };
+
+        /// @}
+    }
+}
+#endif // MADNESS_WORLD_IOVEC_ARCHIVE_H__INCLUDED
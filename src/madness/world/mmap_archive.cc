@@ -0,0 +1,133 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+/**
+ \file mmap_archive.cc
+ \brief Implements an input archive reading a memory-mapped file, and the matching aligned output archive.
+ \ingroup serialization
+*/
+
+#include <madness/world/mmap_archive.h>
+#include <madness/world/madness_exception.h>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace madness {
+    namespace archive {
+
+        MmapOutputArchive::MmapOutputArchive(const char* filename)
+                : iobuf()
+        {
+            if (filename) open(filename);
+        }
+
+        void MmapOutputArchive::open(const char* filename) {
+            iobuf.reset(new char[IOBUFSIZE], std::default_delete<char[]>() );
+            os.open(filename, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+#ifndef ON_A_MAC
+            os.rdbuf()->pubsetbuf(iobuf.get(), IOBUFSIZE);
+#endif
+            pos = 0;
+            store(cookie, strlen(cookie)+1);
+        }
+
+        void MmapOutputArchive::close() {
+            if (iobuf) {
+                os.close();
+                iobuf.reset();
+            }
+        }
+
+        void MmapOutputArchive::flush() {
+            os.flush();
+        }
+
+        MmapInputArchive::MmapInputArchive(const char* filename) {
+            if (filename) open(filename);
+        }
+
+        void MmapInputArchive::open(const char* filename) {
+            close();
+            int fd = ::open(filename, O_RDONLY);
+            if (fd < 0) MADNESS_EXCEPTION("MmapInputArchive: open: failed", 1);
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                ::close(fd);
+                MADNESS_EXCEPTION("MmapInputArchive: open: stat failed", 1);
+            }
+            size = st.st_size;
+            const int n = strlen(ARCHIVE_COOKIE)+1;
+            if (size < std::size_t(n)) {
+                ::close(fd);
+                MADNESS_EXCEPTION("MmapInputArchive: open: not an archive?", 1);
+            }
+            void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);   // the mapping keeps the file open
+            if (p == MAP_FAILED) MADNESS_EXCEPTION("MmapInputArchive: open: mmap failed", 1);
+            madvise(p, size, MADV_SEQUENTIAL);
+            base = static_cast<const unsigned char*>(p);
+
+            aligned = false;
+            set_schema_mode(false);
+            pos = n;
+            if (strncmp((const char*) base, ARCHIVE_SCHEMA_COOKIE, n) == 0) {
+                unsigned int version = 0;
+                load(&version, 1);
+                if (version > ARCHIVE_SCHEMA_VERSION) {
+                    close();
+                    MADNESS_EXCEPTION("MmapInputArchive: open: newer schema version", version);
+                }
+                set_schema_mode(true);
+            }
+            else if (strncmp((const char*) base, MmapOutputArchive::cookie, n) == 0) {
+                aligned = true;
+            }
+            else if (strncmp((const char*) base, ARCHIVE_COOKIE, n) != 0) {
+                close();
+                MADNESS_EXCEPTION("MmapInputArchive: open: not an archive?", 1);
+            }
+        }
+
+        void MmapInputArchive::close() {
+            if (base) {
+                munmap(const_cast<unsigned char*>(base), size);
+                base = nullptr;
+                size = 0;
+                pos = 0;
+            }
+        }
+
+    } // namespace archive
+} // namespace madness
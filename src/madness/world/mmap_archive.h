@@ -0,0 +1,208 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+#ifndef MADNESS_WORLD_MMAP_ARCHIVE_H__INCLUDED
+#define MADNESS_WORLD_MMAP_ARCHIVE_H__INCLUDED
+
+/**
+ \file mmap_archive.h
+ \brief Implements an input archive reading a memory-mapped file, and the matching aligned output archive.
+ \ingroup serialization
+
+ \c MmapInputArchive maps the file read-only and copies each load with a
+ single \c memcpy, so the page cache is shared by all processes of a node
+ reading the same file. It reads files written by \c BinaryFstreamOutputArchive
+ and by \c MmapOutputArchive. The latter pads large arrays to a 64-byte
+ boundary so that \c MmapInputArchive::view() can return aligned pointers
+ into the mapping instead of copying.
+*/
+
+#include <type_traits>
+#include <fstream>
+#include <memory>
+#include <cstring>
+#include <madness/world/archive.h>
+
+namespace madness {
+    namespace archive {
+
+        /// \addtogroup serialization
+        /// @{
+
+        /// Wraps an archive around a binary filestream for output, aligning large arrays.
+        class MmapOutputArchive : public BaseOutputArchive {
+            static const std::size_t IOBUFSIZE = 4*1024*1024; ///< Buffer size.
+            std::shared_ptr<char> iobuf; ///< Buffer.
+            mutable std::ofstream os; ///< The filestream.
+            mutable std::size_t pos = 0; ///< Bytes written so far.
+
+            /// Write zeros up to the alignment of \c nbyte bytes.
+            void pad(std::size_t nbyte) const {
+                static const char zeros[alignment] = {};
+                const std::size_t npad = padding(pos, nbyte);
+                os.write(zeros, npad);
+                pos += npad;
+            }
+
+        public:
+            static constexpr std::size_t alignment = 64; ///< Alignment of large arrays.
+            static constexpr std::size_t align_threshold = 4096; ///< Arrays of at least this many bytes are aligned.
+            static constexpr const char* cookie = "archiva"; ///< Same length as \c ARCHIVE_COOKIE.
+
+            /// Number of padding bytes in front of \c nbyte bytes at position \c pos.
+            static std::size_t padding(std::size_t pos, std::size_t nbyte) {
+                if (nbyte < align_threshold) return 0;
+                return (alignment - pos%alignment)%alignment;
+            }
+
+            /// Default constructor.
+
+            /// The filename is optional here; it can be specified later by calling \c open().
+            /// \param[in] filename Name of the file to write to.
+            MmapOutputArchive(const char* filename = nullptr);
+
+            MmapOutputArchive(const std::string name) : MmapOutputArchive(name.c_str()) {}
+
+            /// Write to the filestream.
+
+            /// \tparam T The type of data to be written.
+            /// \param[in] t Location of the data to be written.
+            /// \param[in] n The number of data items to be written.
+            template <class T>
+            inline
+            typename std::enable_if< is_trivially_serializable<T>::value, void >::type
+            store(const T* t, long n) const {
+                const std::size_t nbyte = n*sizeof(T);
+                pad(nbyte);
+                os.write((const char *) t, nbyte);
+                pos += nbyte;
+            }
+
+            /// Open the filestream.
+
+            /// \param[in] filename The name of the file.
+            void open(const char* filename);
+
+            /// Close the filestream.
+            void close();
+
+            /// Flush the filestream.
+            void flush();
+        };
+
+        /// Wraps an archive around a read-only memory mapping of a file.
+
+        /// Files written in schema mode by \c BinarySchemaOutputArchive are
+        /// recognized when opened.
+        class MmapInputArchive : public BaseInputArchive, public SchemaNesting {
+            const unsigned char* base = nullptr; ///< Start of the mapping.
+            std::size_t size = 0; ///< Size of the mapping.
+            mutable std::size_t pos = 0; ///< Read position.
+            bool aligned = false; ///< True if written by \c MmapOutputArchive.
+
+            /// Skip the padding in front of \c nbyte bytes and check that they are in the file.
+            void advance(std::size_t nbyte) const {
+                if (aligned) pos += MmapOutputArchive::padding(pos, nbyte);
+                if (pos + nbyte > size) MADNESS_EXCEPTION("MmapInputArchive: read past end of file", pos);
+            }
+
+        public:
+            /// Default constructor.
+
+            /// The filename is optional here; it can be specified later by calling \c open().
+            /// \param[in] filename Name of the file to read from.
+            MmapInputArchive(const char* filename = nullptr);
+
+            MmapInputArchive(const std::string name) : MmapInputArchive(name.c_str()) {}
+
+            MmapInputArchive(const MmapInputArchive&) = delete;
+            MmapInputArchive& operator=(const MmapInputArchive&) = delete;
+
+            ~MmapInputArchive() {
+                close();
+            }
+
+            /// Load from the mapping with a single copy.
+
+            /// \tparam T The type of data to be read.
+            /// \param[out] t Where to put the loaded data.
+            /// \param[in] n The number of data items to be loaded.
+            template <class T>
+            inline
+            typename std::enable_if< is_trivially_serializable<T>::value, void >::type
+            load(T* t, long n) const {
+                const std::size_t nbyte = n*sizeof(T);
+                advance(nbyte);
+                std::memcpy((void*) t, base+pos, nbyte);
+                pos += nbyte;
+            }
+
+            /// Return a pointer to the next \c n items in the mapping without copying.
+
+            /// Use in place of \c load() for data that is only read. The pointer
+            /// is valid until the archive is closed, and is aligned to 64 bytes
+            /// for large arrays in files written by \c MmapOutputArchive.
+            /// \tparam T The type of data to be read.
+            /// \param[in] n The number of data items.
+            /// \return Pointer to the data in the mapping.
+            template <class T>
+            inline
+            typename std::enable_if< is_trivially_serializable<T>::value, const T* >::type
+            view(long n) const {
+                const std::size_t nbyte = n*sizeof(T);
+                advance(nbyte);
+                const T* result = reinterpret_cast<const T*>(base+pos);
+                pos += nbyte;
+                return result;
+            }
+
+            /// Map the file.
+
+            /// \param[in] filename Name of the file to read from.
+            void open(const char* filename);
+
+            /// Unmap the file.
+            void close();
+        };
+
+        /// Type checking of \c MmapInputArchive, one cookie per top-level object in schema mode.
+
+        /// \tparam T The data type.
+        template <class T>
+        struct ArchivePrePostImpl<MmapInputArchive,T>
+            : public SchemaArchivePrePostImpl<MmapInputArchive,T> {};
+
+        /// @}
+    }
+}
+
+#endif // MADNESS_WORLD_MMAP_ARCHIVE_H__INCLUDED
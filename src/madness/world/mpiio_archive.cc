@@ -0,0 +1,340 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+/**
+ \file mpiio_archive.cc
+ \brief Implements a parallel archive in a single file written collectively with MPI-IO.
+ \ingroup serialization
+*/
+
+#include <madness/world/mpiio_archive.h>
+
+#ifndef STUBOUTMPI
+
+#include <madness/world/MADworld.h>
+#include <algorithm>
+
+namespace madness {
+    namespace archive {
+
+        namespace {
+            const std::uint64_t mpiio_magic = 0x4d41444d5049494ful; ///< Marks the trailer of the file
+            const std::uint64_t max_chunk = 1ul<<30; ///< Maximum bytes per MPI-IO call
+
+            /// Trailer at the very end of the file
+            struct Trailer {
+                std::uint64_t magic;
+                std::uint64_t footer_offset;
+                std::uint64_t footer_size;
+            };
+
+            /// Collectively write n bytes at offset, in chunks of at most max_chunk
+
+            /// nchunk must be the same on all processes.
+            void write_at_all(MPI_File fh, std::uint64_t offset, const unsigned char* data,
+                              std::uint64_t n, std::uint64_t nchunk) {
+                for (std::uint64_t i=0; i<nchunk; ++i) {
+                    const std::uint64_t lo = std::min(n, i*max_chunk);
+                    const std::uint64_t hi = std::min(n, lo+max_chunk);
+                    SAFE_MPI_GLOBAL_MUTEX;
+                    MADNESS_MPI_TEST(MPI_File_write_at_all(fh, MPI_Offset(offset+lo), const_cast<unsigned char*>(data+lo),
+                                                           int(hi-lo), MPI_BYTE, MPI_STATUS_IGNORE));
+                }
+            }
+
+            /// Collectively read n bytes at offset, in chunks of at most max_chunk
+            void read_at_all(MPI_File fh, std::uint64_t offset, unsigned char* data,
+                             std::uint64_t n, std::uint64_t nchunk) {
+                for (std::uint64_t i=0; i<nchunk; ++i) {
+                    const std::uint64_t lo = std::min(n, i*max_chunk);
+                    const std::uint64_t hi = std::min(n, lo+max_chunk);
+                    SAFE_MPI_GLOBAL_MUTEX;
+                    MADNESS_MPI_TEST(MPI_File_read_at_all(fh, MPI_Offset(offset+lo), data+lo,
+                                                          int(hi-lo), MPI_BYTE, MPI_STATUS_IGNORE));
+                }
+            }
+
+            /// Independently read n bytes at offset
+            void read_at(MPI_File fh, std::uint64_t offset, unsigned char* data, std::uint64_t n) {
+                for (std::uint64_t lo=0; lo<n; lo+=max_chunk) {
+                    const std::uint64_t hi = std::min(n, lo+max_chunk);
+                    SAFE_MPI_GLOBAL_MUTEX;
+                    MADNESS_MPI_TEST(MPI_File_read_at(fh, MPI_Offset(offset+lo), data+lo,
+                                                      int(hi-lo), MPI_BYTE, MPI_STATUS_IGNORE));
+                }
+            }
+
+            std::uint64_t nchunk_of(std::uint64_t n) {
+                return (n + max_chunk - 1)/max_chunk;
+            }
+        }
+
+        void MPIIOOutputArchive::open(World& world, const char* filename) {
+            MADNESS_ASSERT(filename);
+            close();
+            int status;
+            {
+                SAFE_MPI_GLOBAL_MUTEX;
+                status = MPI_File_open(world.mpi.comm().Get_mpi_comm(), const_cast<char*>(filename),
+                                       MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+            }
+            if (status != MPI_SUCCESS) MADNESS_EXCEPTION("MPIIOOutputArchive: could not open file", status);
+            {
+                SAFE_MPI_GLOBAL_MUTEX;
+                MADNESS_MPI_TEST(MPI_File_set_size(fh, 0));
+            }
+            this->world = &world;
+            buf.clear();
+            end = 0;
+            index.clear();
+        }
+
+        void MPIIOOutputArchive::flush() {
+            if (!world) return;
+            std::uint64_t n = buf.size();
+            world->gop.broadcast(n, 0);
+            if (n == 0) return;
+            if (world->rank() == 0) {
+                MPIIOArchiveRecord record;
+                record.segments.push_back(std::make_pair(end, n));
+                index.push_back(record);
+                for (std::uint64_t lo=0; lo<n; lo+=max_chunk) {
+                    const std::uint64_t hi = std::min(n, lo+max_chunk);
+                    SAFE_MPI_GLOBAL_MUTEX;
+                    MADNESS_MPI_TEST(MPI_File_write_at(fh, MPI_Offset(end+lo), &buf[lo], int(hi-lo),
+                                                       MPI_BYTE, MPI_STATUS_IGNORE));
+                }
+                buf.clear();
+            }
+            end += n;
+        }
+
+        std::vector<std::pair<std::uint64_t,std::uint64_t> >
+        MPIIOOutputArchive::write_segment(const std::vector<unsigned char>& data) {
+            // The exclusive scan of the sizes gives the offset of each segment
+            const int nproc = world->size();
+            std::uint64_t mysize = data.size();
+            std::vector<std::uint64_t> sizes(nproc);
+            {
+                SAFE_MPI_GLOBAL_MUTEX;
+                MADNESS_MPI_TEST(MPI_Allgather(&mysize, 1, MPI_UINT64_T, sizes.data(), 1, MPI_UINT64_T,
+                                               world->mpi.comm().Get_mpi_comm()));
+            }
+            std::vector<std::uint64_t> offsets(nproc+1, end);
+            for (int p=0; p<nproc; ++p) offsets[p+1] = offsets[p] + sizes[p];
+
+            const std::uint64_t maxsize = *std::max_element(sizes.begin(), sizes.end());
+            write_at_all(fh, offsets[world->rank()], data.data(), mysize, nchunk_of(maxsize));
+            end = offsets[nproc];
+
+            std::vector<std::pair<std::uint64_t,std::uint64_t> > segments;
+            for (int p=0; p<nproc; ++p) segments.push_back(std::make_pair(offsets[p], sizes[p]));
+            return segments;
+        }
+
+        void MPIIOOutputArchive::write_segments(const std::vector<unsigned char>& data,
+                                                const std::vector<unsigned char>& owner_index) {
+            MADNESS_ASSERT(world);
+            flush();
+
+            MPIIOArchiveRecord record;
+            record.parallel = true;
+            record.segments = write_segment(data);
+            record.index_segments = write_segment(owner_index);
+            if (world->rank() == 0) index.push_back(record);
+        }
+
+        void MPIIOOutputArchive::close() {
+            if (!world) return;
+            flush();
+            if (world->rank() == 0) {
+                std::vector<unsigned char> footer;
+                VectorOutputArchive var(footer);
+                var & index;
+                Trailer trailer = {mpiio_magic, end, footer.size()};
+                const unsigned char* ptr = (const unsigned char*) &trailer;
+                footer.insert(footer.end(), ptr, ptr+sizeof(trailer));
+                SAFE_MPI_GLOBAL_MUTEX;
+                MADNESS_MPI_TEST(MPI_File_write_at(fh, MPI_Offset(end), footer.data(), int(footer.size()),
+                                                   MPI_BYTE, MPI_STATUS_IGNORE));
+            }
+            {
+                SAFE_MPI_GLOBAL_MUTEX;
+                MADNESS_MPI_TEST(MPI_File_close(&fh));
+            }
+            world = nullptr;
+            index.clear();
+        }
+
+        void MPIIOInputArchive::open(World& world, const char* filename) {
+            MADNESS_ASSERT(filename);
+            close();
+            int status;
+            {
+                SAFE_MPI_GLOBAL_MUTEX;
+                status = MPI_File_open(world.mpi.comm().Get_mpi_comm(), const_cast<char*>(filename),
+                                       MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+            }
+            if (status != MPI_SUCCESS) MADNESS_EXCEPTION("MPIIOInputArchive: could not open file", status);
+            this->world = &world;
+
+            index.clear();
+            if (world.rank() == 0) {
+                MPI_Offset filesize;
+                {
+                    SAFE_MPI_GLOBAL_MUTEX;
+                    MADNESS_MPI_TEST(MPI_File_get_size(fh, &filesize));
+                }
+                MADNESS_CHECK(std::uint64_t(filesize) >= sizeof(Trailer));
+                Trailer trailer;
+                read_at(fh, filesize-sizeof(Trailer), (unsigned char*) &trailer, sizeof(trailer));
+                MADNESS_CHECK(trailer.magic == mpiio_magic);
+                std::vector<unsigned char> footer(trailer.footer_size);
+                read_at(fh, trailer.footer_offset, footer.data(), footer.size());
+                VectorInputArchive var(footer);
+                var & index;
+            }
+            world.gop.broadcast_serializable(index, 0);
+            next = 0;
+            buf.clear();
+            pos = 0;
+        }
+
+        void MPIIOInputArchive::read_local_record() const {
+            MADNESS_ASSERT(world && world->rank() == 0);
+            MADNESS_CHECK(next < index.size() && !index[next].parallel);
+            const std::pair<std::uint64_t,std::uint64_t>& segment = index[next++].segments[0];
+            buf.resize(segment.second);
+            read_at(fh, segment.first, buf.data(), buf.size());
+            pos = 0;
+        }
+
+        std::vector<std::pair<std::size_t, std::vector<unsigned char> > > MPIIOInputArchive::read_owner_index() const {
+            MADNESS_ASSERT(world);
+            std::size_t i = next;
+            while (i < index.size() && !index[i].parallel) ++i;
+            MADNESS_CHECK(i < index.size());
+            const MPIIOArchiveRecord& record = index[i];
+            MADNESS_CHECK(record.index_segments.size() == record.segments.size());
+
+            // Distribute the indices round-robin over the readers
+            const std::size_t nproc = world->size();
+            const std::size_t me = world->rank();
+            const std::size_t nseg = record.index_segments.size();
+            std::vector<std::pair<std::size_t, std::vector<unsigned char> > > result;
+            for (std::size_t first=0; first<nseg; first+=nproc) {
+                std::uint64_t maxsize = 0;
+                for (std::size_t w=first; w<std::min(nseg,first+nproc); ++w) {
+                    maxsize = std::max(maxsize, record.index_segments[w].second);
+                }
+                std::uint64_t offset = 0, size = 0;
+                if (first+me < nseg) {
+                    offset = record.index_segments[first+me].first;
+                    size = record.index_segments[first+me].second;
+                }
+                std::vector<unsigned char> v(size);
+                read_at_all(fh, offset, v.data(), size, nchunk_of(maxsize));
+                if (first+me < nseg) result.push_back(std::make_pair(first+me, std::move(v)));
+            }
+            return result;
+        }
+
+        std::vector<std::uint64_t>
+        MPIIOInputArchive::exchange(const std::vector<std::vector<std::uint64_t> >& send) const {
+            MADNESS_ASSERT(world);
+            const int nproc = world->size();
+            MADNESS_CHECK(int(send.size()) == nproc);
+            std::vector<int> sendcounts(nproc), recvcounts(nproc), sdispls(nproc+1, 0), rdispls(nproc+1, 0);
+            for (int p=0; p<nproc; ++p) {
+                sendcounts[p] = send[p].size();
+                sdispls[p+1] = sdispls[p] + sendcounts[p];
+            }
+            std::vector<std::uint64_t> sendbuf(sdispls[nproc]);
+            for (int p=0; p<nproc; ++p) std::copy(send[p].begin(), send[p].end(), sendbuf.begin()+sdispls[p]);
+            {
+                SAFE_MPI_GLOBAL_MUTEX;
+                MADNESS_MPI_TEST(MPI_Alltoall(sendcounts.data(), 1, MPI_INT, recvcounts.data(), 1, MPI_INT,
+                                              world->mpi.comm().Get_mpi_comm()));
+            }
+            for (int p=0; p<nproc; ++p) rdispls[p+1] = rdispls[p] + recvcounts[p];
+            std::vector<std::uint64_t> recvbuf(rdispls[nproc]);
+            {
+                SAFE_MPI_GLOBAL_MUTEX;
+                MADNESS_MPI_TEST(MPI_Alltoallv(sendbuf.data(), sendcounts.data(), sdispls.data(), MPI_UINT64_T,
+                                               recvbuf.data(), recvcounts.data(), rdispls.data(), MPI_UINT64_T,
+                                               world->mpi.comm().Get_mpi_comm()));
+            }
+            return recvbuf;
+        }
+
+        std::vector<unsigned char>
+        MPIIOInputArchive::read_ranges(const std::vector<std::vector<std::pair<std::uint64_t,std::uint64_t> > >& ranges) const {
+            MADNESS_ASSERT(world);
+            while (next < index.size() && !index[next].parallel) ++next;
+            MADNESS_CHECK(next < index.size());
+            const MPIIOArchiveRecord& record = index[next++];
+            MADNESS_CHECK(ranges.size() <= record.segments.size());
+            buf.clear();
+            pos = 0;
+
+            std::uint64_t nbyte = 0;
+            for (const auto& r : ranges) {
+                for (const auto& range : r) nbyte += range.second;
+            }
+            std::vector<unsigned char> result(nbyte);
+            std::uint64_t p = 0;
+            for (std::size_t w=0; w<ranges.size(); ++w) {
+                const std::pair<std::uint64_t,std::uint64_t>& segment = record.segments[w];
+                for (const auto& range : ranges[w]) {
+                    MADNESS_CHECK(range.first + range.second <= segment.second);
+                    read_at(fh, segment.first + range.first, result.data() + p, range.second);
+                    p += range.second;
+                }
+            }
+            return result;
+        }
+
+        void MPIIOInputArchive::close() {
+            if (!world) return;
+            {
+                SAFE_MPI_GLOBAL_MUTEX;
+                MADNESS_MPI_TEST(MPI_File_close(&fh));
+            }
+            world = nullptr;
+            index.clear();
+            buf.clear();
+            pos = 0;
+        }
+    }
+}
+
+#endif // STUBOUTMPI
@@ -0,0 +1,356 @@
+/*
+  This file is part of MADNESS.
+
+  Copyright (C) 2007,2010 Oak Ridge National Laboratory
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+  For more information please contact:
+
+  Robert J. Harrison
+  Oak Ridge National Laboratory
+  One Bethel Valley Road
+  P.O. Box 2008, MS-6367
+
+  email: harrisonrj@ornl.gov
+  tel:   865-241-3937
+  fax:   865-572-0680
+*/
+
+
+#ifndef MADNESS_WORLD_MPIIO_ARCHIVE_H__INCLUDED
+#define MADNESS_WORLD_MPIIO_ARCHIVE_H__INCLUDED
+
+/**
+ \file mpiio_archive.h
+ \brief Implements a parallel archive in a single file written collectively with MPI-IO.
+ \ingroup serialization
+
+ Use as the local archive of the parallel archives,
+ \code
+   archive::ParallelOutputArchive<archive::MPIIOOutputArchive> ar(world, "restart");
+   ar & f;
+ \endcode
+
+ Every process writes the slice of each \c WorldContainer it owns into one
+ shared file at an offset computed by an exclusive scan of the slice sizes.
+ Data of process-local objects are written by process zero. A footer at the
+ end of the file indexes all segments, so the file can be read with any
+ number of processes.
+
+ Each slice is followed by an owner index with the key and offset of every
+ item. On load, the indices are read round-robin by the processes, which send
+ the location of every item to its owner in the process map of the container
+ it loads into. Each process then reads exactly the byte ranges of its items,
+ so a restart with a different number of processes or process map needs
+ neither I/O nodes nor forwarding of the data.
+
+ \note \c save() and \c load() of a \c Function, \c save_function() and the
+ SCF restart files still use \c BinaryFstreamOutputArchive, which must be read
+ with the same number of processes. To restart a \c Function with a different
+ number of processes, write it with this archive instead.
+*/
+
+#include <madness/madness_config.h>
+
+#ifndef STUBOUTMPI
+
+#include <madness/world/safempi.h>
+#include <madness/world/archive.h>
+#include <madness/world/parallel_archive.h>
+#include <madness/world/vector_archive.h>
+#include <madness/world/worlddc.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace madness {
+    namespace archive {
+
+        /// \addtogroup serialization
+        /// @{
+
+        /// A contiguous part of an MPI-IO archive, as listed in the footer index
+        struct MPIIOArchiveRecord {
+            bool parallel = false; ///< True for a container, with one segment per writer.
+            std::vector<std::pair<std::uint64_t,std::uint64_t> > segments; ///< (offset, size) in bytes.
+            std::vector<std::pair<std::uint64_t,std::uint64_t> > index_segments; ///< Owner index of each segment.
+
+            template <typename Archive>
+            void serialize(const Archive& ar) {
+                ar & parallel & segments & index_segments;
+            }
+        };
+
+        /// Collective output archive writing one shared file with MPI-IO.
+
+        /// All processes open, flush, write containers and close the archive
+        /// collectively. Only process zero stores process-local data, which is
+        /// buffered and written before the next collective operation.
+        class MPIIOOutputArchive : public BaseOutputArchive {
+            World* world = nullptr; ///< The world, null if not open.
+            MPI_File fh; ///< The shared file.
+            mutable std::vector<unsigned char> buf; ///< Buffered process-local data.
+            std::uint64_t end = 0; ///< End of the data written so far.
+            std::vector<MPIIOArchiveRecord> index; ///< Footer index, only on process zero.
+
+        public:
+            MPIIOOutputArchive() = default;
+
+            /// Collectively create the file \c filename.
+            MPIIOOutputArchive(World& world, const char* filename) {
+                open(world, filename);
+            }
+
+            MPIIOOutputArchive(const MPIIOOutputArchive&) = delete;
+            MPIIOOutputArchive& operator=(const MPIIOOutputArchive&) = delete;
+
+            ~MPIIOOutputArchive() {
+                close();
+            }
+
+            /// Buffer process-local data.
+
+            /// \tparam T The type of data to be written.
+            /// \param[in] t Location of the data to be written.
+            /// \param[in] n The number of data items to be written.
+            template <class T>
+            inline
+            typename std::enable_if< is_trivially_serializable<T>::value, void >::type
+            store(const T* t, long n) const {
+                const unsigned char* ptr = (const unsigned char*) t;
+                buf.insert(buf.end(), ptr, ptr+n*sizeof(T));
+            }
+
+            /// Collectively create and truncate the file.
+
+            /// \param[in] world The world of the processes sharing the file.
+            /// \param[in] filename The name of the file.
+            void open(World& world, const char* filename);
+
+            /// Collectively write the buffered process-local data.
+            void flush();
+
+            /// Collectively write one segment per process.
+
+            /// Segments are stored in rank order at offsets given by an exclusive
+            /// scan of their sizes, followed by the owner indices if given.
+            /// \param[in] data The bytes of this process, may be empty.
+            /// \param[in] owner_index The owner index of \c data.
+            void write_segments(const std::vector<unsigned char>& data,
+                                const std::vector<unsigned char>& owner_index);
+
+            /// Collectively write the footer index and close the file.
+            void close();
+
+        private:
+            /// Collectively write one segment per process at the end of the file.
+
+            /// \return The (offset, size) of the segment of each process.
+            std::vector<std::pair<std::uint64_t,std::uint64_t> > write_segment(const std::vector<unsigned char>& data);
+        };
+
+        /// Collective input archive reading a file written by \c MPIIOOutputArchive.
+
+        /// The number of readers need not match the number of writers: the
+        /// owner indices of a container are distributed round-robin over the
+        /// readers.
+        class MPIIOInputArchive : public BaseInputArchive {
+            World* world = nullptr; ///< The world, null if not open.
+            MPI_File fh; ///< The shared file.
+            std::vector<MPIIOArchiveRecord> index; ///< Footer index.
+            mutable std::size_t next = 0; ///< Next record to read.
+            mutable std::vector<unsigned char> buf; ///< Current record of process-local data.
+            mutable std::size_t pos = 0; ///< Read position in \c buf.
+
+        public:
+            MPIIOInputArchive() = default;
+
+            /// Collectively open the file \c filename.
+            MPIIOInputArchive(World& world, const char* filename) {
+                open(world, filename);
+            }
+
+            MPIIOInputArchive(const MPIIOInputArchive&) = delete;
+            MPIIOInputArchive& operator=(const MPIIOInputArchive&) = delete;
+
+            ~MPIIOInputArchive() {
+                close();
+            }
+
+            /// Load process-local data, only called on process zero.
+
+            /// \tparam T The type of data to be read.
+            /// \param[out] t Where to put the loaded data.
+            /// \param[in] n The number of data items to be loaded.
+            template <class T>
+            inline
+            typename std::enable_if< is_trivially_serializable<T>::value, void >::type
+            load(T* t, long n) const {
+                const std::size_t nbyte = n*sizeof(T);
+                if (pos == buf.size()) read_local_record();
+                MADNESS_CHECK(pos + nbyte <= buf.size());
+                memcpy((unsigned char*) t, &buf[pos], nbyte);
+                pos += nbyte;
+            }
+
+            /// Collectively open the file and read its footer index.
+
+            /// \param[in] world The world of the processes sharing the file.
+            /// \param[in] filename The name of the file.
+            void open(World& world, const char* filename);
+
+            /// Collectively read the owner indices of the next container.
+
+            /// The indices are distributed round-robin over the readers.
+            /// \return The writer and the index of the segments assigned to this process.
+            std::vector<std::pair<std::size_t, std::vector<unsigned char> > > read_owner_index() const;
+
+            /// Collectively send a list of numbers to every process.
+
+            /// \param[in] send The numbers for each process.
+            /// \return The numbers received, concatenated in rank order.
+            std::vector<std::uint64_t> exchange(const std::vector<std::vector<std::uint64_t> >& send) const;
+
+            /// Read byte ranges of the segments of the next container and move past it.
+
+            /// Collective, but every process reads its own ranges independently.
+            /// \param[in] ranges For each writer, increasing (offset, size) ranges within its segment.
+            /// \return The bytes of all ranges, concatenated in order.
+            std::vector<unsigned char>
+            read_ranges(const std::vector<std::vector<std::pair<std::uint64_t,std::uint64_t> > >& ranges) const;
+
+            /// Collectively close the file.
+            void close();
+
+            void flush() {}
+
+        private:
+            /// Read the next record of process-local data into \c buf.
+            void read_local_record() const;
+        };
+
+        /// Local archives that all processes open collectively on one file.
+        template <>
+        struct is_shared_file_archive<MPIIOOutputArchive> : std::true_type {};
+        template <>
+        struct is_shared_file_archive<MPIIOInputArchive> : std::true_type {};
+
+        /// Write container to an MPI-IO parallel archive.
+
+        /// \ingroup worlddc
+        /// Every process serializes its local data as a sequential archive
+        /// would and writes it as one segment of the shared file.  The owner
+        /// index of the segment lists the keys and the offsets of their items.
+        template <class keyT, class valueT>
+        struct ArchiveStoreImpl< ParallelOutputArchive<MPIIOOutputArchive>, WorldContainer<keyT,valueT> > {
+            static void store(const ParallelOutputArchive<MPIIOOutputArchive>& ar, const WorldContainer<keyT,valueT>& t) {
+                const long magic = 5881828; // as in WorldContainer::serialize
+                World* world = ar.get_world();
+                if (ar.dofence()) world->gop.fence();
+                unsigned long count = 0;
+                for (auto it=t.begin(); it!=t.end(); ++it) count++;
+                std::vector<keyT> keys;
+                std::vector<std::uint64_t> offsets;
+                keys.reserve(count);
+                offsets.reserve(count+1);
+
+                std::vector<unsigned char> v;
+                VectorOutputArchive var(v);
+                var & magic & count;
+                for (auto it=t.begin(); it!=t.end(); ++it) {
+                    keys.push_back(it->first);
+                    offsets.push_back(v.size());
+                    var & *it;
+                }
+                offsets.push_back(v.size());
+
+                std::vector<unsigned char> index;
+                VectorOutputArchive iar(index);
+                iar & keys & offsets;
+                ar.local_archive().write_segments(v, index);
+                if (ar.dofence()) world->gop.fence();
+            }
+        };
+
+        /// Read container from an MPI-IO parallel archive.
+
+        /// \ingroup worlddc
+        /// The owner indices are parsed round-robin by the current processes,
+        /// which send the writer, offset and size of every item to its owner
+        /// in the process map of \c t.  Every process then reads only the
+        /// items it owns and inserts them locally.
+        template <class keyT, class valueT>
+        struct ArchiveLoadImpl< ParallelInputArchive<MPIIOInputArchive>, WorldContainer<keyT,valueT> > {
+            static void load(const ParallelInputArchive<MPIIOInputArchive>& ar, WorldContainer<keyT,valueT>& t) {
+                typedef typename WorldContainer<keyT,valueT>::pairT pairT;
+                World* world = ar.get_world();
+                if (ar.dofence()) world->gop.fence();
+                const MPIIOInputArchive& localar = ar.local_archive();
+
+                // Tell the owner of every key where its item is
+                std::vector<std::vector<std::uint64_t> > send(world->size());
+                for (const auto& index : localar.read_owner_index()) {
+                    std::vector<unsigned char> bytes = index.second;
+                    VectorInputArchive iar(bytes);
+                    std::vector<keyT> keys;
+                    std::vector<std::uint64_t> offsets;
+                    iar & keys & offsets;
+                    MADNESS_CHECK(offsets.size() == keys.size()+1);
+                    for (std::size_t i=0; i<keys.size(); ++i) {
+                        std::vector<std::uint64_t>& s = send[t.owner(keys[i])];
+                        s.push_back(index.first);
+                        s.push_back(offsets[i]);
+                        s.push_back(offsets[i+1] - offsets[i]);
+                    }
+                }
+
+                // Read the items of this process, merging adjacent ranges
+                const std::vector<std::uint64_t> items = localar.exchange(send);
+                const std::size_t count = items.size()/3;
+                std::vector<std::array<std::uint64_t,3> > sorted(count);
+                for (std::size_t i=0; i<count; ++i) sorted[i] = {items[3*i], items[3*i+1], items[3*i+2]};
+                std::sort(sorted.begin(), sorted.end());
+                std::vector<std::vector<std::pair<std::uint64_t,std::uint64_t> > > ranges;
+                for (const auto& item : sorted) {
+                    if (ranges.size() <= item[0]) ranges.resize(item[0]+1);
+                    std::vector<std::pair<std::uint64_t,std::uint64_t> >& r = ranges[item[0]];
+                    if (!r.empty() && r.back().first + r.back().second == item[1]) {
+                        r.back().second += item[2];
+                    } else {
+                        r.push_back(std::make_pair(item[1], item[2]));
+                    }
+                }
+                std::vector<unsigned char> v = localar.read_ranges(ranges);
+                VectorInputArchive var(v);
+                for (std::size_t i=0; i<count; ++i) {
+                    pairT datum;
+                    var & datum;
+                    t.replace(datum);
+                }
+                if (ar.dofence()) world->gop.fence();
+            }
+        };
+
+        /// @}
+    }
+}
+
+#endif // STUBOUTMPI
+
+#endif // MADNESS_WORLD_MPIIO_ARCHIVE_H__INCLUDED
@@ -41,6 +41,7 @@
 #include <type_traits>
 #include <madness/world/archive.h>
 #include <madness/world/binary_fstream_archive.h>
+#include <madness/world/mmap_archive.h>
 #include <madness/world/world.h>
 #include <madness/world/worldgop.h>
 
@@ -57,6 +58,20 @@ namespace madness {
         /// Objects that implement their own parallel archive interface should derive from this class.
         class ParallelSerializableObject {};
 
+        /// True for local archives that \c BaseParallelArchive opens as one file per I/O node.
+        template <typename Archive>
+        struct is_file_archive : std::integral_constant<bool,
+                std::is_same<Archive,BinaryFstreamInputArchive>::value || std::is_same<Archive,BinaryFstreamOutputArchive>::value
+                || std::is_same<Archive,BinarySchemaOutputArchive>::value
+                || std::is_same<Archive,MmapInputArchive>::value || std::is_same<Archive,MmapOutputArchive>::value> {};
+
+        /// True for local archives that all processes open collectively on a single file.
+
+        /// Such archives are opened by \c BaseParallelArchive on every process
+        /// instead of on \c nio I/O nodes each with its own file.
+        template <typename Archive>
+        struct is_shared_file_archive : std::false_type {};
+
 
         /// Base class for input and output parallel archives.
 
@@ -86,7 +101,8 @@ namespace madness {
 
             /// Default constructor.
             template <typename X=Archive>
-            BaseParallelArchive(typename std::enable_if_t<std::is_same<X,BinaryFstreamInputArchive>::value || std::is_same<X,BinaryFstreamOutputArchive>::value,int> nio=0)
+            BaseParallelArchive(typename std::enable_if_t<is_file_archive<X>::value
+                                                          || is_shared_file_archive<X>::value,int> nio=0)
                 : world(nullptr), ar(), nio(nio), do_fence(true) {
             }
 
@@ -132,6 +148,25 @@ namespace madness {
                 return world;
             }
 
+            /// Returns the number of I/O nodes used for a requested number of writers.
+
+            /// \param[in] world The world.
+            /// \param[in] nwriter The requested number of writers.
+            /// \return \c nwriter limited to the maximum number of I/O nodes and the size of \c world.
+            static int num_io_nodes(World& world, int nwriter) {
+#if defined(HAVE_IBMBGP) || defined(HAVE_IBMBGQ)
+                /* Jeff believes that BG is designed to handle up to *
+                 * one file per node and I assume no more than 8 ppn */
+                int maxio = world.size()/8;
+#else
+                int maxio = 50;
+#endif
+                int nio = nwriter;
+                if (nio > maxio) nio = maxio; // Sanity?
+                if (nio > world.size()) nio = world.size();
+                return nio;
+            }
+
             /// Opens the parallel archive.
 
             /// \attention When writing to a new archive, the number of writers
@@ -151,20 +186,11 @@ namespace madness {
             /// \param[in] nwriter The number of writers.
 
             template <typename X=Archive>
-            typename std::enable_if_t<std::is_same<X,BinaryFstreamInputArchive>::value || std::is_same<X,BinaryFstreamOutputArchive>::value,
+            typename std::enable_if_t<is_file_archive<X>::value,
                                       void>
             open(World& world, const char* filename, int nwriter=1) {
                 this->world = &world;
-                nio = nwriter;
-#if defined(HAVE_IBMBGP) || defined(HAVE_IBMBGQ)
-                /* Jeff believes that BG is designed to handle up to *
-                 * one file per node and I assume no more than 8 ppn */
-                int maxio = world.size()/8;
-#else
-                int maxio = 50;
-#endif
-                if (nio > maxio) nio = maxio; // Sanity?
-                if (nio > world.size()) nio = world.size();
+                nio = num_io_nodes(world, nwriter);
 
                 MADNESS_ASSERT(filename);
                 MADNESS_ASSERT(strlen(filename)-1<sizeof(fname));
@@ -190,6 +216,25 @@ namespace madness {
                 set_nclient(world);
             }
 
+            /// Collectively opens a parallel archive in a single shared file.
+
+            /// Every process is an I/O node and reads or writes its own part
+            /// of the file, so \c nwriter is ignored.
+            /// \param[in] world The world.
+            /// \param[in] filename Name of the file.
+            /// \param[in] nwriter Ignored.
+            template <typename X=Archive>
+            typename std::enable_if_t<is_shared_file_archive<X>::value, void>
+            open(World& world, const char* filename, int nwriter=1) {
+                this->world = &world;
+                nio = world.size();
+                MADNESS_ASSERT(filename);
+                MADNESS_ASSERT(strlen(filename)-1<sizeof(fname));
+                strcpy(fname,filename);
+                ar.open(world, filename);
+                set_nclient(world);
+            }
+
             // Count #client
             void set_nclient(World& world) {
 				ProcessID me = world.rank();
@@ -212,7 +257,7 @@ namespace madness {
             /// \return True if the named, unopened archive exists and is readable.
             template <typename X=Archive>
             static
-            typename std::enable_if_t<std::is_same<X,BinaryFstreamInputArchive>::value || std::is_same<X,BinaryFstreamOutputArchive>::value,
+            typename std::enable_if_t<is_file_archive<X>::value,
                                       bool>
             exists(World& world, const char* filename) {
                 char buf[256];
@@ -227,6 +272,25 @@ namespace madness {
                 return status;
             }
 
+            /// Returns true if the named shared file exists with read access.
+
+            /// This is a collective operation.
+            /// \param[in] world The world.
+            /// \param[in] filename Name of the file.
+            /// \return True if the file exists and is readable.
+            template <typename X=Archive>
+            static
+            typename std::enable_if_t<is_shared_file_archive<X>::value, bool>
+            exists(World& world, const char* filename) {
+                bool status;
+                if (world.rank() == 0)
+                    status = (access(filename, F_OK|R_OK) == 0);
+
+                world.gop.broadcast(status);
+
+                return status;
+            }
+
             /// Closes the parallel archive.
             void close() {
                 MADNESS_ASSERT(world);
@@ -261,7 +325,7 @@ namespace madness {
             /// \param[in] filename Base name of the file.
             template <typename X=Archive>
             static
-            typename std::enable_if_t<std::is_same<X,BinaryFstreamInputArchive>::value || std::is_same<X,BinaryFstreamOutputArchive>::value,
+            typename std::enable_if_t<is_file_archive<X>::value,
                                       void>
             remove(World& world, const char* filename) {
                 if (world.rank() == 0) {
@@ -274,6 +338,17 @@ namespace madness {
                 }
             }
 
+            /// Deletes the shared file of the given name.
+
+            /// \param[in] world The world.
+            /// \param[in] filename Name of the file.
+            template <typename X=Archive>
+            static
+            typename std::enable_if_t<is_shared_file_archive<X>::value, void>
+            remove(World& world, const char* filename) {
+                if (world.rank() == 0) ::remove(filename);
+            }
+
             /// Removes the files associated with the current archive.
             void remove() {
                 MADNESS_ASSERT(world);
@@ -310,6 +385,8 @@ namespace madness {
         /// for reading, the number of readers is forced to match.
         template <class localarchiveT=BinaryFstreamOutputArchive>
         class ParallelOutputArchive : public BaseParallelArchive<localarchiveT>, public BaseOutputArchive {
+            double lossy=0.0; ///< Error bound of stored function coefficients relative to their threshold, zero if exact.
+
         public:
             using basear = BaseParallelArchive<localarchiveT>;
 
@@ -340,8 +417,47 @@ namespace madness {
             void flush() {
                 if (basear::is_io_node()) basear::local_archive().flush();
             }
+
+            /// Enables error-bounded lossy storage of function coefficients.
+
+            /// The coefficients of each node of a \c Function are quantized
+            /// and entropy coded such that the norm of their error is at most
+            /// \c fraction times the truncation threshold of the node.
+            /// The bound is verified when the function is loaded.
+            /// \param[in] fraction The error bound relative to the threshold, zero (default) stores exactly.
+            void set_lossy_compression(const double fraction) {
+                MADNESS_CHECK(fraction >= 0.0);
+                lossy = fraction;
+            }
+
+            /// Returns the error bound of stored function coefficients relative to their threshold.
+
+            /// \return The relative error bound, zero if coefficients are stored exactly.
+            double get_lossy_compression() const {
+                return lossy;
+            }
         };
 
+        /// Returns the error bound of stored function coefficients relative to their threshold.
+
+        /// Archives other than \c ParallelOutputArchive always store exactly.
+        /// \tparam Archive The archive type.
+        /// \return Zero.
+        template <typename Archive>
+        double get_lossy_compression(const Archive&) {
+            return 0.0;
+        }
+
+        /// Returns the error bound of stored function coefficients relative to their threshold.
+
+        /// \tparam localarchiveT The local archive type.
+        /// \param[in] ar The parallel archive.
+        /// \return The relative error bound, zero if coefficients are stored exactly.
+        template <class localarchiveT>
+        double get_lossy_compression(const ParallelOutputArchive<localarchiveT>& ar) {
+            return ar.get_lossy_compression();
+        }
+
         /// An archive for storing local or parallel data, wrapping a \c BinaryFstreamInputArchive.
 
         /// \note Reads of process-local objects load the values originally stored by process zero,
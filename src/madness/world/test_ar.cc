@@ -52,6 +52,11 @@ using madness::archive::TextFstreamOutputArchive;
 #include <madness/world/binary_fstream_archive.h>
 using madness::archive::BinaryFstreamInputArchive;
 using madness::archive::BinaryFstreamOutputArchive;
+using madness::archive::BinarySchemaOutputArchive;
+
+#include <madness/world/mmap_archive.h>
+using madness::archive::MmapInputArchive;
+using madness::archive::MmapOutputArchive;
 
 #include <madness/world/vector_archive.h>
 using madness::archive::VectorInputArchive;
@@ -61,6 +66,9 @@ using madness::archive::VectorOutputArchive;
 using madness::archive::BufferInputArchive;
 using madness::archive::BufferOutputArchive;
 
+#include <madness/world/iovec_archive.h>
+using madness::archive::IovecOutputArchive;
+
 #include <madness/world/cereal_archive.h>
 #ifdef MADNESS_HAS_CEREAL
 #include <cereal/archives/binary.hpp>
@@ -868,6 +876,75 @@ int main(int argc, char* argv[]) {
       iar.close();
     }
     world.gop.barrier();
+
+    if (is_read_proc) {
+      cout << endl << "testing mmap archive reading a binary fstream archive" << endl;
+      MmapInputArchive iar(f);
+      test_in(iar);
+      iar.close();
+    }
+    world.gop.barrier();
+  }
+
+  {
+    const char *f = "test.dat";
+    const char *g = "test_schema.dat";
+    if (is_write_proc) {
+      cout << endl << "testing binary fstream archive in schema mode" << endl;
+      BinarySchemaOutputArchive oar(g);
+      test_out(oar);
+      oar.close();
+      BinaryFstreamOutputArchive bar(f);
+      test_out(bar);
+      bar.close();
+      // nested objects carry no type cookies
+      std::ifstream fs(f, std::ios::binary | std::ios::ate), gs(g, std::ios::binary | std::ios::ate);
+      MADNESS_CHECK(gs.tellg() < fs.tellg());
+    }
+    world.gop.barrier();
+
+    if (is_read_proc) {
+      BinaryFstreamInputArchive iar(g);
+      MADNESS_CHECK(iar.schema_mode());
+      test_in(iar);
+      iar.close();
+    }
+    world.gop.barrier();
+
+    if (is_read_proc) {
+      cout << endl << "testing mmap archive reading a schema archive" << endl;
+      MmapInputArchive iar(g);
+      MADNESS_CHECK(iar.schema_mode());
+      test_in(iar);
+      iar.close();
+      std::remove(g);
+    }
+    world.gop.barrier();
+  }
+
+  {
+    const char *f = "test.dat";
+    if (is_write_proc) {
+      cout << endl << "testing aligned mmap archive" << endl;
+      MmapOutputArchive oar(f);
+      test_out(oar);
+      std::vector<double> big(1000, 1.5);
+      oar & madness::archive::wrap(big.data(), big.size());
+      oar.close();
+    }
+    world.gop.barrier();
+
+    if (is_read_proc) {
+      MmapInputArchive iar(f);
+      test_in(iar);
+      // large arrays are aligned in the mapping
+      madness::archive::ArchivePrePostImpl<MmapInputArchive,double*>::preamble_load(iar);
+      const double* big = iar.view<double>(1000);
+      MADNESS_CHECK(reinterpret_cast<std::uintptr_t>(big) % 64 == 0);
+      MADNESS_CHECK(big[0] == 1.5 && big[999] == 1.5);
+      iar.close();
+    }
+    world.gop.barrier();
   }
 
   if (me == 0) {
@@ -916,6 +993,34 @@ int main(int argc, char* argv[]) {
   }
   world.gop.barrier();
 
+  // iovec archive only tested on rank 0
+  if (me == 0) {
+    cout << endl << "testing iovec archive" << endl;
+    IovecOutputArchive oar;
+    test_out(oar);
+    std::vector<double> big(10000);
+    for (std::size_t i=0; i<big.size(); ++i) big[i] = i;
+    oar.store_reference(big.data(), big.size());
+    oar & 42;
+    MADNESS_CHECK(oar.nreference() == 1);
+
+    // gathered stream reads like a buffer archive, referenced data included
+    std::vector<unsigned char> buf(oar.size());
+    oar.gather(buf.data());
+    std::size_t nbyte = 0;
+    for (const auto& v : oar.iov()) nbyte += v.iov_len;
+    MADNESS_CHECK(nbyte == oar.size());
+
+    BufferInputArchive iar(buf.data(), buf.size());
+    test_in(iar);
+    std::vector<double> big_in(big.size());
+    int answer = 0;
+    iar & wrap(big_in.data(), big_in.size()) & answer;
+    MADNESS_CHECK(big_in == big && answer == 42 && iar.nbyte_avail() == 0);
+    iar.close();
+  }
+  world.gop.barrier();
+
 #ifdef MADNESS_HAS_CEREAL
   {
     const char *f = "test.dat";
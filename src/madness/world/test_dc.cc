@@ -241,6 +241,48 @@ void test_local(World& world) {
 
 }
 
+void test_spill(World& world) {
+    WorldContainer<int,std::vector<double> > c(world);
+    const int n=100;
+    for (int i=0; i<n; ++i) {
+        if (c.is_local(i)) c.replace(i,std::vector<double>(100,double(i)));
+    }
+    world.gop.fence();
+    const std::size_t nlocal=c.size();
+
+    // keep roughly a quarter of the values in memory, touch the even keys last
+    WorldDCSpillPolicy policy;
+    policy.memory_budget=nlocal*100*sizeof(double)/4;
+    c.set_spill_policy(policy);
+    for (int i=0; i<n; i+=2) c.probe(i);
+    std::size_t nbyte=c.spill_cold();
+    MADNESS_CHECK(nlocal==0 || nbyte>0);
+    MADNESS_CHECK(c.size()==nlocal);
+    MADNESS_CHECK(nlocal==0 || c.nspilled()>0);
+    world.gop.fence();
+
+    // keyed access faults values back in, also from remote processes
+    for (int i=0; i<n; ++i) MADNESS_CHECK(c.find(i).get()->second[99]==double(i));
+    world.gop.fence();
+
+    // overwriting and erasing spilled values
+    c.spill_cold();
+    for (int i=0; i<n; ++i) {
+        if (c.is_local(i) && i%3==0) c.replace(i,std::vector<double>(1,-1.0));
+        if (c.is_local(i) && i%3==1) c.erase(i);
+    }
+    std::size_t count=0;
+    for (auto it=c.begin(); it!=c.end(); ++it) {
+        const int i=it->first;
+        MADNESS_CHECK(i%3!=1);
+        MADNESS_CHECK(it->second.back()==((i%3==0) ? -1.0 : double(i)));
+        count++;
+    }
+    MADNESS_CHECK(c.nspilled()==0 && count==c.size());
+    world.gop.fence();
+    if (world.rank()==0) print("test_spill OK");
+}
+
 int main(int argc, char** argv) {
     initialize(argc, argv);
     World world(SafeMPI::COMM_WORLD);
@@ -251,6 +293,7 @@ int main(int argc, char** argv) {
         test1(world);
         test1(world);
         test_local(world);
+        test_spill(world);
     }
     catch (const SafeMPI::Exception& e) {
         error("caught an MPI exception");
@@ -37,6 +37,9 @@
 #include <madness/world/MADworld.h>
 #include <madness/world/world_object.h>
 #include <madness/world/worlddc.h>
+#include <madness/world/mpiio_archive.h>
+#include <madness/world/h5p_archive.h>
+#include <madness/world/async_checkpoint.h>
 
 #if MADNESS_CATCH_SIGNALS
 # include <csignal>
@@ -1137,6 +1140,160 @@ void test13(World& world) {
     world.gop.fence();
 }
 
+/// Maps keys round-robin to processes, starting with the last one
+class ReversePmap : public WorldDCPmapInterface<int> {
+    const int nproc;
+public:
+    ReversePmap(World& world) : nproc(world.size()) {}
+
+    ProcessID owner(const int& key) const {
+        return nproc-1 - key%nproc;
+    }
+};
+
+void test13_mpiio(World& world) {
+    PROFILE_FUNC;
+    // Serial data around a container in one shared file
+    ProcessID me = world.rank();
+    WorldContainer<int,double> d(world);
+    for (int i=0; i<100; ++i) {
+        int key = me*100+i;
+        d.replace(key, double(key));
+    }
+    world.gop.fence();
+
+    {
+        archive::ParallelOutputArchive<archive::MPIIOOutputArchive> fout(world, "fred.mpiio");
+        fout & 1.0 & d & 42;
+    }
+
+    double v = 0.0;
+    int i42 = 0;
+    WorldContainer<int,double> c(world);
+    {
+        archive::ParallelInputArchive<archive::MPIIOInputArchive> fin(world, "fred.mpiio");
+        fin & v & c & i42;
+    }
+    MADNESS_CHECK(v == 1.0 && i42 == 42);
+    MADNESS_CHECK(c.size() == d.size());
+    for (int i=0; i<100; ++i) {
+        int key = me*100+i;
+        MADNESS_CHECK(c.find(key).get()->second == key);
+    }
+
+    // Every process reads the items it owns in another process map
+    std::shared_ptr< WorldDCPmapInterface<int> > pmap(new ReversePmap(world));
+    WorldContainer<int,double> r(world, pmap);
+    {
+        archive::ParallelInputArchive<archive::MPIIOInputArchive> fin(world, "fred.mpiio");
+        fin & v & r & i42;
+    }
+    std::size_t nlocal = 0;
+    for (auto it=r.begin(); it!=r.end(); ++it, ++nlocal) {
+        MADNESS_CHECK(r.owner(it->first) == me && it->second == it->first);
+    }
+    world.gop.sum(nlocal);
+    MADNESS_CHECK(nlocal == std::size_t(100*world.size()) && i42 == 42);
+
+    MADNESS_CHECK((archive::ParallelInputArchive<archive::MPIIOInputArchive>::exists(world, "fred.mpiio")));
+    archive::ParallelOutputArchive<archive::MPIIOOutputArchive>::remove(world, "fred.mpiio");
+
+    print("Test13 MPI-IO OK");
+    world.gop.fence();
+}
+
+#ifdef HAVE_HDF5
+void test13_h5p(World& world) {
+    PROFILE_FUNC;
+    // Serial data around a container and a table in one HDF5 file
+    ProcessID me = world.rank();
+    WorldContainer<int,double> d(world);
+    for (int i=0; i<100; ++i) {
+        int key = me*100+i;
+        d.replace(key, double(key));
+    }
+    world.gop.fence();
+
+    // Every process writes me+2 rows of three columns
+    std::vector<std::int64_t> rows;
+    for (int i=0; i<me+2; ++i) {
+        for (int j=0; j<3; ++j) rows.push_back(1000*me + 10*i + j);
+    }
+    {
+        archive::ParallelOutputArchive<archive::H5POutputArchive> fout(world, "fred.h5");
+        fout & 1.0 & d & 42;
+        archive::H5POutputArchive& h5 = fout.local_archive();
+        h5.begin_record("table");
+        h5.write_attribute("answer", std::vector<std::int64_t>(1, 42));
+        MADNESS_CHECK(h5.write_rows("rows", rows, 3, 2) == std::size_t(me*(me+3)/2));
+        h5.end_record();
+    }
+
+    double v = 0.0;
+    int i42 = 0;
+    WorldContainer<int,double> c(world);
+    {
+        archive::ParallelInputArchive<archive::H5PInputArchive> fin(world, "fred.h5");
+        fin & v & c & i42;
+        archive::H5PInputArchive& h5 = fin.local_archive();
+        MADNESS_CHECK(h5.kind(h5.size()-1) == "table");
+        h5.open_record(h5.size()-1);
+        MADNESS_CHECK(h5.read_attribute("answer") == std::vector<std::int64_t>(1, 42));
+        const std::size_t n = world.size()*(world.size()+3)/2;
+        MADNESS_CHECK(h5.nrow("rows") == n);
+        // The first and last rows of the last writer
+        const ProcessID last = world.size()-1;
+        std::vector<std::int64_t> sel = h5.read_rows<std::int64_t>("rows", std::vector<std::size_t>{0, n-1});
+        MADNESS_CHECK(sel.size() == 6 && sel[0] == 0 && sel[2] == 2);
+        MADNESS_CHECK(sel[3] == 1000*last + 10*(last+1) && sel[5] == 1000*last + 10*(last+1) + 2);
+        h5.end_record();
+    }
+    MADNESS_CHECK(v == 1.0 && i42 == 42);
+    MADNESS_CHECK(c.size() == d.size());
+    for (int i=0; i<100; ++i) {
+        int key = me*100+i;
+        MADNESS_CHECK(c.find(key).get()->second == key);
+    }
+
+    MADNESS_CHECK((archive::ParallelInputArchive<archive::H5PInputArchive>::exists(world, "fred.h5")));
+    archive::ParallelOutputArchive<archive::H5POutputArchive>::remove(world, "fred.h5");
+
+    print("Test13 HDF5 OK");
+    world.gop.fence();
+}
+#endif
+
+void test13_async(World& world) {
+    PROFILE_FUNC;
+    // A checkpoint written in the background is read by the usual parallel archive
+    ProcessID me = world.rank();
+    WorldContainer<int,double> d(world);
+    for (int i=0; i<100; ++i) {
+        int key = me*100+i;
+        d.replace(key, double(key));
+    }
+    world.gop.fence();
+
+    Future<bool> written = save_async(world, d, "fred.async");
+    // modifying the container does not change the checkpoint
+    for (int i=0; i<100; ++i) d.replace(me*100+i, -1.0);
+    MADNESS_CHECK(written.get());
+    world.gop.fence();
+
+    WorldContainer<int,double> c(world);
+    archive::ParallelInputArchive<archive::BinaryFstreamInputArchive> fin(world, "fred.async");
+    fin & c;
+    for (int i=0; i<100; ++i) {
+        int key = me*100+i;
+        MADNESS_CHECK(c.find(key).get()->second == key);
+    }
+    fin.close();
+    fin.remove();
+
+    print("Test13 async checkpoint OK");
+    world.gop.fence();
+}
+
 void test14(World& world) {
 
   if (world.size() > 1) {
@@ -1350,6 +1507,11 @@ int main(int argc, char** argv) {
         //test11(world);
         test12(world);
         test13(world);
+        test13_mpiio(world);
+#ifdef HAVE_HDF5
+        test13_h5p(world);
+#endif
+        test13_async(world);
         test14(world);
         test15(world);
 
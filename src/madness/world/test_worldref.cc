@@ -524,6 +524,29 @@ namespace {
             EXPECT_EQ(*i, *back);
         }
     }
+
+    TEST_F(WorldRefTest, BatchedReset) {
+
+        if(pworld->size() > 1) {
+            ProcessID send = (pworld->rank() != (pworld->size() - 1) ? pworld->rank() + 1 : 0);
+
+            // Send the pointer to the next process
+            XferRef<int> xfer_wobj(*pworld);
+            xfer_wobj.xfer(send, r, true);
+            pworld->gop.fence();
+            EXPECT_EQ(2, r.use_count());
+
+            // The release is queued until the next fence
+            RemoteReference<int>& remote = xfer_wobj.remote_ref.get();
+            remote.reset();
+            EXPECT_FALSE(remote);
+            EXPECT_EQ(1u, madness::detail::RemoteCounterReleaser::size());
+
+            pworld->gop.fence();
+            EXPECT_EQ(0u, madness::detail::RemoteCounterReleaser::size());
+            EXPECT_EQ(1, r.use_count());
+        }
+    }
 }
 
 int main(int argc, char **argv) {
@@ -467,8 +467,12 @@ namespace madness {
     class BaseOutputArchive;
     class BinaryFstreamOutputArchive;
     class BinaryFstreamInputArchive;
+    class BinarySchemaOutputArchive;
+    class MmapOutputArchive;
+    class MmapInputArchive;
     class BufferOutputArchive;
     class BufferInputArchive;
+    class IovecOutputArchive;
     class VectorOutputArchive;
     class VectorInputArchive;
     class TextFstreamOutputArchive;
@@ -481,6 +485,8 @@ namespace madness {
     class MPIRawInputArchive;
     class MPIOutputArchive;
     class MPIInputArchive;
+    class MPIIOOutputArchive;
+    class MPIIOInputArchive;
     class ContainerRecordInputArchive;
     class ContainerRecordOutputArchive;
     template <class localarchiveT>
@@ -545,10 +551,18 @@ namespace madness {
     template <typename T>
     struct is_default_serializable_helper<archive::BinaryFstreamInputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
     template <typename T>
+    struct is_default_serializable_helper<archive::BinarySchemaOutputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
+    template <typename T>
+    struct is_default_serializable_helper<archive::MmapOutputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
+    template <typename T>
+    struct is_default_serializable_helper<archive::MmapInputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
+    template <typename T>
     struct is_default_serializable_helper<archive::BufferOutputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
     template <typename T>
     struct is_default_serializable_helper<archive::BufferInputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
     template <typename T>
+    struct is_default_serializable_helper<archive::IovecOutputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
+    template <typename T>
     struct is_default_serializable_helper<archive::VectorOutputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
     template <typename T>
     struct is_default_serializable_helper<archive::VectorInputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
@@ -572,6 +586,14 @@ namespace madness {
     template <typename T>
     struct is_default_serializable_helper<archive::MPIInputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
     template <typename T>
+    struct is_default_serializable_helper<archive::MPIIOOutputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
+    template <typename T>
+    struct is_default_serializable_helper<archive::MPIIOInputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
+    template <typename T>
+    struct is_default_serializable_helper<archive::H5POutputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
+    template <typename T>
+    struct is_default_serializable_helper<archive::H5PInputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
+    template <typename T>
     struct is_default_serializable_helper<archive::ContainerRecordOutputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
     template <typename T>
     struct is_default_serializable_helper<archive::ContainerRecordInputArchive, T, std::enable_if_t<is_trivially_serializable<T>::value>> : std::true_type {};
@@ -587,10 +609,18 @@ namespace madness {
     template <>
     struct is_archive<archive::BinaryFstreamInputArchive> : std::true_type {};
     template <>
+    struct is_archive<archive::BinarySchemaOutputArchive> : std::true_type {};
+    template <>
+    struct is_archive<archive::MmapOutputArchive> : std::true_type {};
+    template <>
+    struct is_archive<archive::MmapInputArchive> : std::true_type {};
+    template <>
     struct is_archive<archive::BufferOutputArchive> : std::true_type {};
     template <>
     struct is_archive<archive::BufferInputArchive> : std::true_type {};
     template <>
+    struct is_archive<archive::IovecOutputArchive> : std::true_type {};
+    template <>
     struct is_archive<archive::VectorOutputArchive> : std::true_type {};
     template <>
     struct is_archive<archive::VectorInputArchive> : std::true_type {};
@@ -611,6 +641,14 @@ namespace madness {
     template <>
     struct is_archive<archive::MPIInputArchive> : std::true_type {};
     template <>
+    struct is_archive<archive::MPIIOOutputArchive> : std::true_type {};
+    template <>
+    struct is_archive<archive::MPIIOInputArchive> : std::true_type {};
+    template <>
+    struct is_archive<archive::H5POutputArchive> : std::true_type {};
+    template <>
+    struct is_archive<archive::H5PInputArchive> : std::true_type {};
+    template <>
     struct is_archive<archive::ContainerRecordOutputArchive> : std::true_type {};
     template <>
     struct is_archive<archive::ContainerRecordInputArchive> : std::true_type {};
@@ -622,8 +660,14 @@ namespace madness {
     template <>
     struct is_output_archive<archive::BinaryFstreamOutputArchive> : std::true_type {};
     template <>
+    struct is_output_archive<archive::BinarySchemaOutputArchive> : std::true_type {};
+    template <>
+    struct is_output_archive<archive::MmapOutputArchive> : std::true_type {};
+    template <>
     struct is_output_archive<archive::BufferOutputArchive> : std::true_type {};
     template <>
+    struct is_output_archive<archive::IovecOutputArchive> : std::true_type {};
+    template <>
     struct is_output_archive<archive::VectorOutputArchive> : std::true_type {};
     template <>
     struct is_output_archive<archive::TextFstreamOutputArchive> : std::true_type {};
@@ -634,6 +678,10 @@ namespace madness {
     template <>
     struct is_output_archive<archive::MPIOutputArchive> : std::true_type {};
     template <>
+    struct is_output_archive<archive::MPIIOOutputArchive> : std::true_type {};
+    template <>
+    struct is_output_archive<archive::H5POutputArchive> : std::true_type {};
+    template <>
     struct is_output_archive<archive::ContainerRecordOutputArchive> : std::true_type {};
     template <class localarchiveT>
     struct is_output_archive<archive::ParallelOutputArchive<localarchiveT> > : std::true_type {};
@@ -641,6 +689,8 @@ namespace madness {
     template <>
     struct is_input_archive<archive::BinaryFstreamInputArchive> : std::true_type {};
     template <>
+    struct is_input_archive<archive::MmapInputArchive> : std::true_type {};
+    template <>
     struct is_input_archive<archive::BufferInputArchive> : std::true_type {};
     template <>
     struct is_input_archive<archive::VectorInputArchive> : std::true_type {};
@@ -653,6 +703,10 @@ namespace madness {
     template <>
     struct is_input_archive<archive::MPIInputArchive> : std::true_type {};
     template <>
+    struct is_input_archive<archive::MPIIOInputArchive> : std::true_type {};
+    template <>
+    struct is_input_archive<archive::H5PInputArchive> : std::true_type {};
+    template <>
     struct is_input_archive<archive::ContainerRecordInputArchive> : std::true_type {};
     template <class localarchiveT>
     struct is_input_archive<archive::ParallelInputArchive<localarchiveT> > : std::true_type {};
@@ -41,6 +41,8 @@
 #include <madness/world/worldam.h>
 #include <madness/world/world_task_queue.h>
 #include <madness/world/worldgop.h>
+#include <madness/world/worldref.h>
+#include <madness/world/async_checkpoint.h>
 #include <cstdlib>
 #include <sstream>
 
@@ -119,6 +121,8 @@ namespace madness {
 //        MADNESS_ASSERT_NOEXCEPT(map_ptr_to_id.size() == 0);
 //        MADNESS_ASSERT_NOEXCEPT(map_id_to_ptr.size() == 0);
         if (this->_id != 0) worlds.remove(this);
+        // Send remote releases queued since the last fence, they would leak on their owners
+        detail::RemoteCounterReleaser::flush(*this);
         delete &taskq;
         delete &gop;
         delete &am;
@@ -243,6 +247,7 @@ namespace madness {
     }
 
     void finalize() {
+        AsyncCheckpoint::wait_all();
         World::default_world->gop.fence();
         const auto rank = World::default_world->rank();
         const auto world_size = World::default_world->size();
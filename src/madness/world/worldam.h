@@ -36,6 +36,7 @@
 /// \brief Implements active message layer for World on top of RMI layer
 
 #include <madness/world/buffer_archive.h>
+#include <madness/world/iovec_archive.h>
 #include <madness/world/worldrmi.h>
 #include <madness/world/world.h>
 #include <vector>
@@ -192,16 +193,24 @@ namespace madness {
     /// Convenience template for serializing arguments into a new AmArg
     template <typename... argT>
     inline AmArg* new_am_arg(const argT&... args) {
-        // compute size
-        archive::BufferOutputArchive count;
-        serialize_am_args(count, args...);
-
-        // Serialize arguments
-        AmArg* am_args = alloc_am_arg(count.size());
-        serialize_am_args(*am_args, args...);
+        // Serialize arguments in one pass, then gather them into the message
+        archive::IovecOutputArchive ar;
+        serialize_am_args(ar, args...);
+        AmArg* am_args = alloc_am_arg(ar.size());
+        ar.gather(am_args->buf());
         return am_args;
     }
 
+    /// Convenience template for serializing arguments for a scatter-gather active message
+
+    /// Large tensors are referenced rather than copied, see WorldAmInterface::send().
+    template <typename... argT>
+    inline archive::IovecOutputArchive new_am_iovec(const argT&... args) {
+        archive::IovecOutputArchive ar;
+        serialize_am_args(ar, args...);
+        return ar;
+    }
+
 
     /// Implements AM interface
     class WorldAmInterface : private SCALABLE_MUTEX_TYPE {
@@ -349,6 +358,40 @@ namespace madness {
             send_req[i].unlock(); // << matches try_lock above
         }
 
+        /// Sends an active message serialized into a scatter-gather archive
+
+        /// Messages larger than the RMI receive buffers are sent directly from
+        /// the referenced arrays with a single MPI derived datatype, blocking
+        /// until the send completes (such messages already wait for the
+        /// receiver to post a buffer). All others are gathered into a managed
+        /// buffer and sent without blocking.
+        void send(ProcessID dest, am_handlerT op, const archive::IovecOutputArchive& ar,
+                  const int attr=RMI::ATTR_ORDERED)
+        {
+            if (ar.nreference() == 0 || ar.size()+sizeof(AmArg) <= RMI::max_msg_len()
+                || RMI::get_this_thread_is_server()) {
+                AmArg* arg = alloc_am_arg(ar.size());
+                ar.gather(arg->buf());
+                send(dest, op, arg, attr);
+                return;
+            }
+
+            AmArg header;
+            header.set_size(ar.size());
+            header.set_worldid(worldid);
+            header.set_src(rank);
+            header.set_func(op);
+            header.clear_flags();
+
+            std::vector<struct iovec> iov = ar.iov();
+            iov.insert(iov.begin(), iovec{&header, sizeof(AmArg)});
+
+            lock(); nsent++; unlock();
+            RMI::Request req = RMI::isendv(iov.data(), iov.size(), map_to_comm_world[dest], handler, attr);
+            MutexWaiter waiter;
+            while (!req.Test()) waiter.wait();
+        }
+
         /// Frees as many send buffers as possible, returning the number that are free
         int free_managed_buffers() {
             int nfree = 0;
@@ -40,10 +40,21 @@
 
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include <madness/world/parallel_archive.h>
+#include <madness/world/buffer_archive.h>
 #include <madness/world/worldhashmap.h>
 #include <madness/world/mpi_archive.h>
 #include <madness/world/world_object.h>
@@ -342,6 +353,200 @@ namespace madness {
         }
     };
 
+    /// Controls the out-of-core storage of a WorldContainer
+
+    /// \ingroup worlddc
+    struct WorldDCSpillPolicy {
+        std::string directory = ".";        ///< Directory on node-local storage for the spill files
+        std::size_t memory_budget = 0;      ///< Bytes of resident values per process, 0 disables spilling
+    };
+
+    namespace detail {
+
+        /// Stores the spilled values of one WorldContainerImpl on one process
+
+        /// Values are serialized with a BufferOutputArchive and appended to a
+        /// node-local file; an in-memory index maps keys to their records.
+        /// File space is reused once all values have been faulted back in.
+        /// The store also keeps the time of last use of every key for the
+        /// choice of cold values.  The index and the times are split into
+        /// buckets by the hash of the key, each with its own lock, so that
+        /// threads accessing different keys rarely contend; only reading and
+        /// writing the file is serialized.
+        template <typename keyT, typename valueT, typename hashfunT>
+        class WorldDCSpillStore {
+            struct recordT {
+                std::size_t offset;
+                std::size_t nbyte;
+            };
+
+            static const std::size_t nbucket = 64;
+
+            struct bucketT {
+                std::mutex mutex;
+                std::unordered_map<keyT, recordT, hashfunT> index;
+                std::unordered_map<keyT, unsigned long, hashfunT> use;
+
+                explicit bucketT(const hashfunT& hf) : index(31, hf), use(31, hf) {}
+            };
+
+            const WorldDCSpillPolicy policy;
+            const std::string filename;
+            const hashfunT hf;
+            std::fstream file;
+            std::size_t file_end = 0;             ///< Guarded by file_mutex
+            std::size_t nrecord = 0;              ///< Guarded by file_mutex
+            std::atomic<unsigned long> clock{0};
+            std::vector< std::unique_ptr<bucketT> > buckets;
+            mutable std::mutex file_mutex;        ///< Always taken after the lock of a bucket
+
+            bucketT& bucket(const keyT& key) const {
+                return *buckets[hf(key) % nbucket];
+            }
+
+            /// Reads and deserializes a record, file_mutex must be held
+            void read(const recordT& record, valueT& value) {
+                std::vector<unsigned char> buf(record.nbyte);
+                file.seekg(record.offset);
+                file.read((char*) buf.data(), record.nbyte);
+                if (!file) MADNESS_EXCEPTION("WorldDCSpillStore: failed reading spill file", record.offset);
+                archive::BufferInputArchive ar(buf.data(), buf.size());
+                ar & value;
+            }
+
+            /// Forgets one record, file_mutex must be held
+            void release_record() {
+                if (--nrecord == 0) file_end = 0;
+            }
+
+        public:
+            WorldDCSpillStore(const WorldDCSpillPolicy& policy, const std::string& filename, const hashfunT& hf)
+                : policy(policy)
+                , filename(filename)
+                , hf(hf)
+                , file(filename, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary) {
+                if (!file) MADNESS_EXCEPTION(("WorldDCSpillStore: cannot open " + filename).c_str(), 0);
+                for (std::size_t b=0; b<nbucket; ++b) buckets.emplace_back(new bucketT(hf));
+            }
+
+            ~WorldDCSpillStore() {
+                file.close();
+                std::remove(filename.c_str());
+            }
+
+            std::size_t budget() const {
+                return policy.memory_budget;
+            }
+
+            /// Number of spilled values
+            std::size_t size() const {
+                std::lock_guard<std::mutex> lock(file_mutex);
+                return nrecord;
+            }
+
+            /// Logical time of the last access to key, 0 if never accessed
+            unsigned long last_use(const keyT& key) const {
+                bucketT& b = bucket(key);
+                std::lock_guard<std::mutex> lock(b.mutex);
+                auto it = b.use.find(key);
+                return (it == b.use.end()) ? 0 : it->second;
+            }
+
+            /// Writes value to disk
+            void put(const keyT& key, const valueT& value) {
+                archive::BufferOutputArchive count;
+                count & value;
+                std::vector<unsigned char> buf(count.size());
+                archive::BufferOutputArchive ar(buf.data(), buf.size());
+                ar & value;
+
+                bucketT& b = bucket(key);
+                std::lock_guard<std::mutex> lock(b.mutex);
+                std::lock_guard<std::mutex> flock(file_mutex);
+                file.seekp(file_end);
+                file.write((const char*) buf.data(), buf.size());
+                if (!file) MADNESS_EXCEPTION("WorldDCSpillStore: failed writing spill file", file_end);
+                if (b.index.insert_or_assign(key, recordT{file_end, buf.size()}).second) ++nrecord;
+                file_end += buf.size();
+            }
+
+            /// Records an access to key and, if key is spilled, passes the value to insert
+
+            /// The value is removed from the store while the lock of its bucket is held,
+            /// so concurrent lookups of the same key see it either here or in insert's target.
+            /// @return true if the key was spilled
+            template <typename opT>
+            bool take(const keyT& key, const opT& insert) {
+                bucketT& b = bucket(key);
+                std::lock_guard<std::mutex> lock(b.mutex);
+                b.use[key] = ++clock;
+                auto it = b.index.find(key);
+                if (it == b.index.end()) return false;
+                valueT value;
+                {
+                    std::lock_guard<std::mutex> flock(file_mutex);
+                    read(it->second, value);
+                    release_record();
+                }
+                b.index.erase(it);
+                insert(key, value);
+                return true;
+            }
+
+            /// Passes all spilled values to insert and empties the store
+            template <typename opT>
+            void take_all(const opT& insert) {
+                for (auto& b : buckets) {
+                    std::lock_guard<std::mutex> lock(b->mutex);
+                    for (const auto& [key, record] : b->index) {
+                        valueT value;
+                        {
+                            std::lock_guard<std::mutex> flock(file_mutex);
+                            read(record, value);
+                            release_record();
+                        }
+                        insert(key, value);
+                    }
+                    b->index.clear();
+                }
+            }
+
+            /// Forgets a spilled value and the use of key, because it was erased
+            void drop(const keyT& key) {
+                bucketT& b = bucket(key);
+                std::lock_guard<std::mutex> lock(b.mutex);
+                b.use.erase(key);
+                if (b.index.erase(key)) {
+                    std::lock_guard<std::mutex> flock(file_mutex);
+                    release_record();
+                }
+            }
+
+            /// Forgets a spilled value because it was overwritten, which counts as a use of key
+            void overwrite(const keyT& key) {
+                bucketT& b = bucket(key);
+                std::lock_guard<std::mutex> lock(b.mutex);
+                b.use[key] = ++clock;
+                if (b.index.erase(key)) {
+                    std::lock_guard<std::mutex> flock(file_mutex);
+                    release_record();
+                }
+            }
+
+            void clear() {
+                for (auto& b : buckets) {
+                    std::lock_guard<std::mutex> lock(b->mutex);
+                    b->index.clear();
+                    b->use.clear();
+                }
+                std::lock_guard<std::mutex> flock(file_mutex);
+                nrecord = 0;
+                file_end = 0;
+            }
+        };
+
+    }  // namespace detail
+
     /// Internal implementation of distributed container to facilitate shallow copy
 
     /// \ingroup worlddc
@@ -391,8 +596,34 @@ namespace madness {
         internal_containerT local;               ///< Locally owned data
         std::vector<keyT>* move_list;            ///< Tempoary used to record data that needs redistributing
 
+        typedef detail::WorldDCSpillStore<keyT,valueT,hashfunT> spillT;
+        std::unique_ptr<spillT> spill;           ///< Out-of-core storage of cold values, null if disabled
+
+        /// Moves the value of key back into memory if it was spilled
+        void fault_in(const keyT& key) const {
+            if (!spill) return;
+            internal_containerT& l = const_cast<internal_containerT&>(local);
+            spill->take(key, [&l](const keyT& k, const valueT& value) {
+                accessor acc;
+                l.insert(acc, k);
+                acc->second = value;
+            });
+        }
+
+        /// Moves all spilled values back into memory
+        void fault_in_all() const {
+            if (!spill) return;
+            internal_containerT& l = const_cast<internal_containerT&>(local);
+            spill->take_all([&l](const keyT& k, const valueT& value) {
+                accessor acc;
+                l.insert(acc, k);
+                acc->second = value;
+            });
+        }
+
         /// Handles find request
         void find_handler(ProcessID requestor, const keyT& key, const RemoteReference< FutureImpl<iterator> >& ref) {
+            fault_in(key);
             internal_iteratorT r = local.find(key);
             if (r == local.end()) {
                 //print("find_handler: failure:", key);
@@ -446,6 +677,57 @@ namespace madness {
             return pmap;
         }
 
+        /// Enables, changes or (with a zero budget) disables the out-of-core storage
+
+        /// Not thread safe with respect to other accesses of this container
+        void set_spill_policy(const WorldDCSpillPolicy& policy) {
+            fault_in_all();
+            spill.reset();
+            if (policy.memory_budget == 0) return;
+            std::ostringstream filename;
+            filename << policy.directory << "/madness_spill." << me << "." << (void*) this;
+            spill.reset(new spillT(policy, filename.str(), local.get_hash()));
+        }
+
+        /// Writes the least recently used values to disk until the rest fits into the memory budget
+
+        /// Cold values are chosen by the time of their last keyed access.
+        /// Not thread safe with respect to other accesses of this container,
+        /// call it when no tasks operate on the container, e.g. after a fence.
+        /// @return the number of bytes written
+        std::size_t spill_cold() {
+            if (!spill) return 0;
+            std::vector<std::tuple<unsigned long, std::size_t, keyT> > resident;
+            std::size_t total = 0;
+            for (internal_iteratorT it = local.begin(); it != local.end(); ++it) {
+                archive::BufferOutputArchive count;
+                count & it->second;
+                total += count.size();
+                resident.emplace_back(spill->last_use(it->first), count.size(), it->first);
+            }
+            if (total <= spill->budget()) return 0;
+
+            std::sort(resident.begin(), resident.end(), [](const auto& a, const auto& b) {
+                return std::get<0>(a) < std::get<0>(b);
+            });
+            std::size_t nbyte = 0;
+            for (const auto& [time, size, key] : resident) {
+                if (total <= spill->budget()) break;
+                accessor acc;
+                if (!local.find(acc, key)) continue;
+                spill->put(key, acc->second);
+                local.erase(acc);
+                total -= size;
+                nbyte += size;
+            }
+            return nbyte;
+        }
+
+        /// Number of local values currently held on disk
+        std::size_t nspilled() const {
+            return spill ? spill->size() : 0;
+        }
+
         void reset_pmap_to_local() {
             pmap->deregister_callback(this);
             pmap.reset(new WorldDCLocalPmap<keyT>(this->get_world()));
@@ -488,7 +770,7 @@ namespace madness {
         	if (fence) world.gop.fence();
         }
 
-        hashfunT& get_hash() const { return local.get_hash(); }
+        const hashfunT& get_hash() const { return local.get_hash(); }
 
         bool is_local(const keyT& key) const {
             return owner(key) == me;
@@ -500,19 +782,22 @@ namespace madness {
 
         bool probe(const keyT& key) const {
             ProcessID dest = owner(key);
-            if (dest == me)
+            if (dest == me) {
+                fault_in(key);
                 return local.find(key) != local.end();
+            }
             else
                 return false;
         }
 
         std::size_t size() const {
-            return local.size();
+            return local.size() + nspilled();
         }
 
         void insert(const pairT& datum) {
             ProcessID dest = owner(datum.first);
             if (dest == me) {
+                if (spill) spill->overwrite(datum.first);
                 // Was using iterator ... try accessor ?????
                 accessor acc;
                 local.insert(acc,datum.first);
@@ -526,15 +811,18 @@ namespace madness {
 
         bool insert_acc(accessor& acc, const keyT& key) {
             MADNESS_ASSERT(owner(key) == me);
+            fault_in(key);
             return local.insert(acc,key);
         }
 
         bool insert_const_acc(const_accessor& acc, const keyT& key) {
             MADNESS_ASSERT(owner(key) == me);
+            fault_in(key);
             return local.insert(acc,key);
         }
 
         void clear() {
+            if (spill) spill->clear();
             local.clear();
         }
 
@@ -542,6 +830,7 @@ namespace madness {
         void erase(const keyT& key) {
             ProcessID dest = owner(key);
             if (dest == me) {
+                if (spill) spill->drop(key);
                 local.erase(key);
             }
             else {
@@ -567,11 +856,14 @@ namespace madness {
             } while(first != last);
         }
 
+        /// Iteration covers all local values, spilled values are faulted in first
         iterator begin() {
+            fault_in_all();
             return iterator(local.begin());
         }
 
         const_iterator begin() const {
+            fault_in_all();
             return const_iterator(local.begin());
         }
 
@@ -597,6 +889,7 @@ namespace madness {
         Future<iterator> find(const keyT& key) {
             ProcessID dest = owner(key);
             if (dest == me) {
+                fault_in(key);
                 return Future<iterator>(iterator(local.find(key)));
             } else {
                 Future<iterator> result;
@@ -607,12 +900,14 @@ namespace madness {
 
         bool find(accessor& acc, const keyT& key) {
             if (owner(key) != me) return false;
+            fault_in(key);
             return local.find(acc,key);
         }
 
 
         bool find(const_accessor& acc, const keyT& key) const {
             if (owner(key) != me) return false;
+            fault_in(key);
             return local.find(acc,key);
         }
 
@@ -621,6 +916,7 @@ namespace madness {
         template <typename memfunT>
         MEMFUN_RETURNT(memfunT)
         itemfun(const keyT& key, memfunT memfun) {
+            fault_in(key);
             accessor acc;
             local.insert(acc, key);
             return (acc->second.*memfun)();
@@ -630,6 +926,7 @@ namespace madness {
         template <typename memfunT, typename arg1T>
         MEMFUN_RETURNT(memfunT)
         itemfun(const keyT& key, memfunT memfun, const arg1T& arg1) {
+            fault_in(key);
             accessor acc;
             local.insert(acc, key);
             return (acc->second.*memfun)(arg1);
@@ -639,6 +936,7 @@ namespace madness {
         template <typename memfunT, typename arg1T, typename arg2T>
         MEMFUN_RETURNT(memfunT)
         itemfun(const keyT& key, memfunT memfun, const arg1T& arg1, const arg2T& arg2) {
+            fault_in(key);
             accessor acc;
             local.insert(acc, key);
             return (acc->second.*memfun)(arg1,arg2);
@@ -648,6 +946,7 @@ namespace madness {
         template <typename memfunT, typename arg1T, typename arg2T, typename arg3T>
         MEMFUN_RETURNT(memfunT)
         itemfun(const keyT& key, memfunT memfun, const arg1T& arg1, const arg2T& arg2, const arg3T& arg3) {
+            fault_in(key);
             accessor acc;
             local.insert(acc, key);
             return (acc->second.*memfun)(arg1,arg2,arg3);
@@ -657,6 +956,7 @@ namespace madness {
         template <typename memfunT, typename arg1T, typename arg2T, typename arg3T, typename arg4T>
         MEMFUN_RETURNT(memfunT)
         itemfun(const keyT& key, memfunT memfun, const arg1T& arg1, const arg2T& arg2, const arg3T& arg3, const arg4T& arg4) {
+            fault_in(key);
             accessor acc;
             local.insert(acc, key);
             return (acc->second.*memfun)(arg1,arg2,arg3,arg4);
@@ -666,6 +966,7 @@ namespace madness {
         template <typename memfunT, typename arg1T, typename arg2T, typename arg3T, typename arg4T, typename arg5T>
         MEMFUN_RETURNT(memfunT)
         itemfun(const keyT& key, memfunT memfun, const arg1T& arg1, const arg2T& arg2, const arg3T& arg3, const arg4T& arg4, const arg5T& arg5) {
+            fault_in(key);
             accessor acc;
             local.insert(acc, key);
             return (acc->second.*memfun)(arg1,arg2,arg3,arg4,arg5);
@@ -675,6 +976,7 @@ namespace madness {
         template <typename memfunT, typename arg1T, typename arg2T, typename arg3T, typename arg4T, typename arg5T, typename arg6T>
         MEMFUN_RETURNT(memfunT)
         itemfun(const keyT& key, memfunT memfun, const arg1T& arg1, const arg2T& arg2, const arg3T& arg3, const arg4T& arg4, const arg5T& arg5, const arg6T& arg6) {
+            fault_in(key);
             accessor acc;
             local.insert(acc, key);
             return (acc->second.*memfun)(arg1,arg2,arg3,arg4,arg5,arg6);
@@ -685,6 +987,7 @@ namespace madness {
         MEMFUN_RETURNT(memfunT)
         itemfun(const keyT& key, memfunT memfun, const arg1T& arg1, const arg2T& arg2, const arg3T& arg3,
 				const arg4T& arg4, const arg5T& arg5, const arg6T& arg6, const arg7T& arg7) {
+            fault_in(key);
             accessor acc;
             local.insert(acc, key);
             return (acc->second.*memfun)(arg1,arg2,arg3,arg4,arg5,arg6,arg7);
@@ -692,6 +995,7 @@ namespace madness {
 
         // First phase of redistributions changes pmap and makes list of stuff to move
         void redistribute_phase1(const std::shared_ptr< WorldDCPmapInterface<keyT> >& newpmap) {
+            fault_in_all();
             pmap = newpmap;
             move_list = new std::vector<keyT>();
             for (typename internal_containerT::iterator iter=local.begin(); iter!=local.end(); ++iter) {
@@ -1025,6 +1329,31 @@ namespace madness {
             return p->size();
         }
 
+        /// Keeps the local values within a memory budget by spilling cold ones to node-local disk
+
+        /// Spilled values are faulted back in on keyed access (find, probe,
+        /// insert, send to an item) and by iteration, which pages in all of
+        /// them.  Values are written only by spill_cold().  Disabled by default.
+        void set_spill_policy(const WorldDCSpillPolicy& policy) {
+            check_initialized();
+            p->set_spill_policy(policy);
+        }
+
+        /// Writes the least recently used local values to disk until the rest fits into the budget
+
+        /// Call only when no tasks operate on the container, e.g. after a fence.
+        /// @return the number of bytes written
+        std::size_t spill_cold() {
+            check_initialized();
+            return p->spill_cold();
+        }
+
+        /// Returns the number of \em local entries held on disk (no communication)
+        std::size_t nspilled() const {
+            check_initialized();
+            return p->nspilled();
+        }
+
         /// Returns shared pointer to the process mapping
         inline const std::shared_ptr< WorldDCPmapInterface<keyT> >& get_pmap() const {
             check_initialized();
@@ -1037,7 +1366,7 @@ namespace madness {
         }
 
         /// Returns a reference to the hashing functor
-        hashfunT& get_hash() const {
+        const hashfunT& get_hash() const {
             check_initialized();
             return p->get_hash();
         }
@@ -1567,6 +1896,14 @@ namespace madness {
 
         /// (de)Serialize --- !! ONLY for purpose of interprocess communication
 
+        /// This just writes the unique id to the IovecOutputArchive.
+        void serialize(const archive::IovecOutputArchive& ar) {
+            check_initialized();
+            ar & static_cast<WorldObject<implT>*>(p.get());
+        }
+
+        /// (de)Serialize --- !! ONLY for purpose of interprocess communication
+
         /// This just writes/reads the unique id to/from the Buffer*Archive.
         void serialize(const archive::BufferInputArchive& ar) {
             WorldObject<implT>* ptr = nullptr;
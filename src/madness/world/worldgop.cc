@@ -32,6 +32,7 @@
 #include <limits>
 #include <madness/world/worldgop.h>
 #include <madness/world/MADworld.h>
+#include <madness/world/worldref.h>
 #ifdef MADNESS_HAS_GOOGLE_PERF_TCMALLOC
 #include <gperftools/malloc_extension.h>
 #endif
@@ -81,6 +82,10 @@ namespace madness {
             do {
                 world_.taskq.fence();
 
+                // Release remote references queued by tasks before counting
+                // messages, so the release messages are part of this fence.
+                detail::RemoteCounterReleaser::flush(world_);
+
                 // Since the number of outstanding tasks and number of AM sent/recv
                 // don't share a critical section read each twice and ensure they
                 // are unchanged to ensure that are consistent ... they don't have
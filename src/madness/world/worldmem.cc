@@ -33,12 +33,18 @@
 */
 
 #include <madness/world/worldmem.h>
+#include <madness/world/world.h>
+#include <madness/world/worldgop.h>
 #include <cstdlib>
 //#include <cstdio>
 #include <climits>
 #include <iostream>
 #include <iomanip>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <map>
 #include <mutex>
 
 /*
@@ -111,6 +117,124 @@ namespace madness {
         max_num_bytes = 0;
     }
 
+    namespace detail {
+        bool memory_tags_enabled_flag = false;
+
+        /// Counters of one memory tag
+        struct MemoryTagCounters {
+            std::atomic<long> cur_bytes{0};
+            std::atomic<long> max_bytes{0};
+            std::atomic<long> nalloc{0};
+        };
+
+        static const int max_memory_tags = 256;
+        static MemoryTagCounters memory_tag_counters[max_memory_tags];
+        static std::vector<std::string> memory_tag_names = {"untagged", "other"};
+        static std::mutex memory_tag_mutex;
+        static thread_local int memory_tag_active = 0;
+    }  // namespace detail
+
+    void memory_tags_enable() {
+        detail::memory_tags_enabled_flag = true;
+    }
+
+    void memory_tags_disable() {
+        detail::memory_tags_enabled_flag = false;
+    }
+
+    int memory_tag_id(const std::string& name) {
+        std::lock_guard<std::mutex> lock(detail::memory_tag_mutex);
+        auto& names = detail::memory_tag_names;
+        auto it = std::find(names.begin(), names.end(), name);
+        if (it != names.end()) return it - names.begin();
+        if (names.size() == std::size_t(detail::max_memory_tags)) return 1;
+        names.push_back(name);
+        return names.size() - 1;
+    }
+
+    int memory_tag_current() {
+        return detail::memory_tag_active;
+    }
+
+    int memory_tag_allocate(std::size_t nbyte) {
+        const int tag = detail::memory_tag_active;
+        detail::MemoryTagCounters& c = detail::memory_tag_counters[tag];
+        c.nalloc++;
+        const long cur = (c.cur_bytes += nbyte);
+        long max = c.max_bytes.load(std::memory_order_relaxed);
+        while (cur > max && !c.max_bytes.compare_exchange_weak(max, cur, std::memory_order_relaxed));
+        return tag;
+    }
+
+    void memory_tag_deallocate(int tag, std::size_t nbyte) {
+        detail::memory_tag_counters[tag].cur_bytes -= nbyte;
+    }
+
+    std::vector<MemoryTagInfo> memory_tag_statistics() {
+        std::vector<std::string> names;
+        {
+            std::lock_guard<std::mutex> lock(detail::memory_tag_mutex);
+            names = detail::memory_tag_names;
+        }
+        std::vector<MemoryTagInfo> result;
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            const detail::MemoryTagCounters& c = detail::memory_tag_counters[i];
+            if (c.nalloc == 0 && c.cur_bytes == 0) continue;
+            MemoryTagInfo info;
+            info.name = names[i];
+            info.cur_bytes = c.cur_bytes;
+            info.max_bytes = c.max_bytes;
+            info.nalloc = c.nalloc;
+            result.push_back(info);
+        }
+        return result;
+    }
+
+    void memory_tag_reset() {
+        // Tags that still hold memory stay listed, since their deallocations are still to come
+        for (auto& c : detail::memory_tag_counters) {
+            c.max_bytes = c.cur_bytes.load();
+            c.nalloc = 0;
+        }
+    }
+
+    void print_memory_tag_statistics(World& world) {
+        const std::vector<MemoryTagInfo> all = world.gop.concat0(memory_tag_statistics());
+        if (world.rank() != 0) return;
+
+        // per tag: current and high-water summed over processes, largest per-process high-water
+        std::map<std::string, std::array<long,4> > bytag;
+        for (const MemoryTagInfo& info : all) {
+            std::array<long,4>& b = bytag[info.name];
+            b[0] += info.cur_bytes;
+            b[1] += info.max_bytes;
+            b[2] = std::max(b[2], info.max_bytes);
+            b[3] += info.nalloc;
+        }
+
+        const double to_MiB = 1.0 / (1024.0 * 1024.0);
+        std::cout.flush();
+        std::cout << "\n    MADNESS memory by tag (MiB)\n";
+        std::cout << "    ---------------------------\n";
+        std::cout << std::setw(24) << "tag" << std::setw(12) << "current" << std::setw(12) << "high-water"
+                  << std::setw(12) << "max/proc" << std::setw(12) << "#alloc" << "\n";
+        for (const auto& [name, b] : bytag) {
+            std::cout << std::setw(24) << name << std::fixed << std::setprecision(1)
+                      << std::setw(12) << b[0] * to_MiB << std::setw(12) << b[1] * to_MiB
+                      << std::setw(12) << b[2] * to_MiB << std::setw(12) << b[3] << "\n";
+        }
+        std::cout.unsetf(std::ios_base::floatfield);
+        std::cout << std::endl;
+    }
+
+    MemoryTagScope::MemoryTagScope(const int tag) : previous(detail::memory_tag_active) {
+        detail::memory_tag_active = tag;
+    }
+
+    MemoryTagScope::~MemoryTagScope() {
+        detail::memory_tag_active = previous;
+    }
+
 }  // namespace madness
 
 #ifdef WORLD_GATHER_MEM_STATS
@@ -43,6 +43,7 @@
 #include <cstddef>
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 #if defined(MADNESS_HAS_GOOGLE_PERF_TCMALLOC)
 #include <gperftools/malloc_extension.h>
@@ -112,6 +113,87 @@ namespace madness {
     /// Returns pointer to internal structure
     WorldMemInfo* world_mem_info();
 
+    class World;
+
+    /// \name Memory accounting by subsystem
+    /// Tensor allocations made while a MemoryTagScope is active in the calling
+    /// thread are attributed to the tag of the innermost scope, e.g. "operator cache"
+    /// or "KAIN subspace".  Unlike WorldMemInfo this works with the production
+    /// allocator.  Accounting costs two atomic updates per allocation and is
+    /// therefore off by default, switch it on with memory_tags_enable().
+    /// \note Tags are thread-local; tasks spawned inside a scope are not covered.
+    /// Therefore the coefficients of a FunctionImpl, which are computed in tasks,
+    /// have no tag of their own and show up as "untagged".
+    ///@{
+
+    /// Statistics of a single memory tag
+    struct MemoryTagInfo {
+        std::string name;
+        long cur_bytes=0;       ///< Currently allocated bytes
+        long max_bytes=0;       ///< High-water mark in bytes
+        long nalloc=0;          ///< Number of allocations
+
+        template <typename Archive>
+        void serialize(Archive& ar) {
+            ar & name & cur_bytes & max_bytes & nalloc;
+        }
+    };
+
+    namespace detail {
+        extern bool memory_tags_enabled_flag;
+    }
+
+    /// enables memory accounting by tag
+    void memory_tags_enable();
+    /// disables memory accounting by tag
+    void memory_tags_disable();
+    /// @return true if tensor allocations are attributed to memory tags
+    inline bool memory_tags_enabled() {
+        return detail::memory_tags_enabled_flag;
+    }
+
+    /// @return the id of the tag with the given name, registering it if necessary
+    /// \note the number of tags is limited, surplus names share the tag "other"
+    int memory_tag_id(const std::string& name);
+
+    /// @return the id of the tag active in the calling thread, 0 is "untagged"
+    int memory_tag_current();
+
+    /// attributes an allocation of nbyte bytes to the tag of the calling thread
+    /// @return the tag id that must be passed to memory_tag_deallocate()
+    int memory_tag_allocate(std::size_t nbyte);
+
+    /// removes a deallocation of nbyte bytes from tag
+    void memory_tag_deallocate(int tag, std::size_t nbyte);
+
+    /// @return the statistics of all tags used by this process
+    std::vector<MemoryTagInfo> memory_tag_statistics();
+
+    /// resets the high-water marks of all tags to the current usage and the allocation counts to zero
+    /// \note tags that still hold memory keep being reported
+    void memory_tag_reset();
+
+    /// gathers the tag statistics of all processes and prints them on rank 0
+
+    /// Collective.  The high-water mark is reported as the sum and the
+    /// maximum over processes of the per-process high-water marks.
+    void print_memory_tag_statistics(World& world);
+
+    /// RAII scope attributing tensor allocations of the calling thread to a tag
+    class MemoryTagScope {
+        int previous;
+    public:
+        explicit MemoryTagScope(const int tag);
+        explicit MemoryTagScope(const std::string& name)
+            : MemoryTagScope(memory_tag_id(name)) {}
+        ~MemoryTagScope();
+
+        MemoryTagScope(const MemoryTagScope&) = delete;
+        MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+    };
+
+    ///@}
+
     namespace detail {
       template <typename Char> const Char* Vm_cstr();
 
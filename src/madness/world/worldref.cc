@@ -34,11 +34,72 @@
 #include <madness/world/worldref.h>
 #include <madness/world/worldmutex.h>
 #include <iostream>
+#include <map>
 
 namespace madness {
     namespace detail {
         RemoteCounter::pimpl_mapT RemoteCounter::pimpl_map_;
 
+        std::size_t RemoteCounterReleaser::max_batch_size_ = 1024;
+
+        namespace {
+            typedef std::vector<RemoteCounter> batchT;
+            typedef std::pair<unsigned long, ProcessID> batch_keyT; ///< (world id, owner)
+
+            Mutex batch_mutex;
+            std::map<batch_keyT, batchT> batches;
+        }
+
+        void RemoteCounterReleaser::send(World& world, ProcessID owner, const batchT& batch) {
+            // Serialization hands the references over to the owner
+            world.am.send(owner, RemoteCounterReleaser::release_handler, new_am_arg(batch));
+        }
+
+        void RemoteCounterReleaser::release_handler(const AmArg& arg) {
+            batchT batch;
+            arg & batch;
+            // the counters are released when batch goes out of scope
+        }
+
+        void RemoteCounterReleaser::release(RemoteCounter& counter) {
+            MADNESS_ASSERT(!counter.is_local() && counter.has_owner());
+            World& world = counter.get_world();
+            const ProcessID owner = counter.owner();
+
+            batchT full;
+            {
+                ScopedMutex<Mutex> lock(batch_mutex);
+                batchT& batch = batches[batch_keyT(world.id(), owner)];
+                batch.emplace_back();
+                batch.back().swap(counter);
+                if (batch.size() >= max_batch_size_) full.swap(batch);
+            }
+            if (!full.empty()) send(world, owner, full);
+        }
+
+        void RemoteCounterReleaser::flush(World& world) {
+            std::vector<std::pair<ProcessID, batchT> > pending;
+            {
+                ScopedMutex<Mutex> lock(batch_mutex);
+                auto it = batches.lower_bound(batch_keyT(world.id(), 0));
+                while (it != batches.end() && it->first.first == world.id()) {
+                    if (!it->second.empty()) {
+                        pending.emplace_back(it->first.second, batchT());
+                        pending.back().second.swap(it->second);
+                    }
+                    it = batches.erase(it);
+                }
+            }
+            for (const auto& p : pending) send(world, p.first, p.second);
+        }
+
+        std::size_t RemoteCounterReleaser::size() {
+            ScopedMutex<Mutex> lock(batch_mutex);
+            std::size_t n = 0;
+            for (const auto& b : batches) n += b.second.size();
+            return n;
+        }
+
         std::ostream& operator<<(std::ostream& out, const RemoteCounter& counter) {
             out << "RemoteCounter( owner=" << counter.owner() << " worldid=" <<
                     counter.get_worldid() << " use_count=" << counter.use_count() << ")";
@@ -43,6 +43,8 @@
 #include <madness/world/worldptr.h>     // for WorldPtr
 #include <madness/world/worldhashmap.h> // for ConcurrentHashMap
 #include <iosfwd>               // for std::ostream
+#include <vector>               // for std::vector
+#include <algorithm>            // for std::max
 
 //#define MADNESS_REMOTE_REFERENCE_DEBUG
 #ifdef MADNESS_REMOTE_REFERENCE_DEBUG
@@ -376,6 +378,51 @@ namespace madness {
 
         std::ostream& operator<<(std::ostream& out, const RemoteCounter& counter);
 
+        /// Batches the release of remote reference counters
+
+        /// Releasing a non-local reference requires a message to its owner.
+        /// Instead of sending one message per reference, released counters
+        /// are collected per world and owner, and each batch is sent as a
+        /// single active message when it reaches \c max_batch_size counters,
+        /// or when the world is fenced or destroyed.
+        class RemoteCounterReleaser {
+        private:
+            static std::size_t max_batch_size_;
+
+            static void send(World& world, ProcessID owner,
+                    const std::vector<RemoteCounter>& batch);
+
+            static void release_handler(const AmArg& arg);
+
+        public:
+            /// Queue the release of a non-local counter
+
+            /// Ownership of the reference is taken from \c counter, which is
+            /// left empty.
+            /// \param counter The non-local counter to release
+            static void release(RemoteCounter& counter);
+
+            /// Send all pending releases of \c world to their owners
+
+            /// Called by \c WorldGopInterface::fence() so that the messages
+            /// are included in its termination detection, and by the
+            /// destructor of \c World so that no release is lost.
+            /// \param world The world whose releases are sent
+            static void flush(World& world);
+
+            /// \return The number of counters waiting to be released
+            static std::size_t size();
+
+            /// Set the number of counters per owner that triggers a send
+
+            /// \param n The batch size, 1 sends every release immediately
+            static void set_max_batch_size(std::size_t n) {
+                max_batch_size_ = std::max(std::size_t(1), n);
+            }
+
+            static std::size_t get_max_batch_size() { return max_batch_size_; }
+        }; // class RemoteCounterReleaser
+
     } // namespace detail
 
 
@@ -406,13 +453,6 @@ namespace madness {
         template <typename>
         friend class RemoteReference;
 
-        // Handles reset of a remote reference from another node.
-        static void reset_handler(const AmArg& arg) {
-            RemoteReference<T> r;
-            arg & r;
-            // r resets on scope exit.
-        }
-
     public:
 
         /// Makes a non-shared (no reference count) null pointer
@@ -470,14 +510,17 @@ namespace madness {
         /// Release this reference
 
         /// This function will clear the reference and leave it in the default
-        /// constructed state. If the reference is non-local, then a message is
-        /// sent to the reference owner that releases the reference.
+        /// constructed state. If the reference is non-local, then the release
+        /// is queued and sent to the reference owner, together with other
+        /// releases, at the latest by the next fence.
         /// \warning Only call this function for non-local references when it
         /// will not otherwise be returned to the reference owner as part of a
         /// message.
         void reset() {
-            if((! (counter_.is_local())) && counter_.has_owner())
-                get_world().am.send(owner(), RemoteReference<T>::reset_handler, new_am_arg(*this));
+            if((! (counter_.is_local())) && counter_.has_owner()) {
+                detail::RemoteCounterReleaser::release(counter_);
+                pointer_ = nullptr;
+            }
             else
                 RemoteReference<T>().swap(*this);
         }
@@ -40,6 +40,7 @@
 #include <sstream>
 #include <list>
 #include <memory>
+#include <vector>
 #include <madness/world/safempi.h>
 #include <madness/world/archive.h>
 
@@ -469,24 +470,7 @@ namespace madness {
         static std::size_t numsent = 0; // for tracking synchronous sends
 
         if (nbyte > max_msg_len_) {
-            // Huge message protocol ... send message to dest indicating size and origin of huge message.
-            // Remote end posts a buffer then acks the request.  This end can then send.
-            const int nword = HEADER_LEN/sizeof(size_t);
-            size_t info[nword+3];
-            info[nword  ] = rank;
-            info[nword+1] = nbyte;
-            tag = unique_tag();
-            info[nword+2] = tag;
-
-            int ack;
-            // make unique tags to ensure that ack msgs do not collide with normal recv msgs
-            Request req_ack = comm.Irecv(&ack, sizeof(ack), MPI_BYTE, dest, tag + unique_tag_period());
-            Request req_send = isend(info, sizeof(info), dest, RMI::RmiTask::huge_msg_handler, ATTR_UNORDERED);
-
-            MutexWaiter waiter;
-            while (!req_send.Test()) waiter.wait();
-            waiter.reset();
-            while (!req_ack.Test()) waiter.wait();
+            tag = huge_msg_rendezvous(nbyte, dest);
         }
         else if (nbyte < HEADER_LEN) {
             MADNESS_EXCEPTION("RMI::isend --- your buffer is too small to hold the header", static_cast<int>(nbyte));
@@ -533,6 +517,91 @@ namespace madness {
         return result;
     }
 
+    int RMI::RmiTask::huge_msg_rendezvous(size_t nbyte, ProcessID dest) {
+        // Huge message protocol ... send message to dest indicating size and origin of huge message.
+        // Remote end posts a buffer then acks the request.  This end can then send.
+        const int nword = HEADER_LEN/sizeof(size_t);
+        size_t info[nword+3];
+        info[nword  ] = rank;
+        info[nword+1] = nbyte;
+        const int tag = unique_tag();
+        info[nword+2] = tag;
+
+        int ack;
+        // make unique tags to ensure that ack msgs do not collide with normal recv msgs
+        Request req_ack = comm.Irecv(&ack, sizeof(ack), MPI_BYTE, dest, tag + unique_tag_period());
+        Request req_send = isend(info, sizeof(info), dest, RMI::RmiTask::huge_msg_handler, ATTR_UNORDERED);
+
+        MutexWaiter waiter;
+        while (!req_send.Test()) waiter.wait();
+        waiter.reset();
+        while (!req_ack.Test()) waiter.wait();
+        return tag;
+    }
+
+    RMI::Request
+    RMI::RmiTask::isendv(const struct iovec* iov, int niov, ProcessID dest, rmi_handlerT func, attrT attr) {
+#ifdef STUBOUTMPI
+        MADNESS_EXCEPTION("RMI::isendv --- no messages can be sent without MPI", niov);
+#else
+        MADNESS_ASSERT(niov > 0);
+        if (iov[0].iov_len < HEADER_LEN)
+            MADNESS_EXCEPTION("RMI::isendv --- your first buffer is too small to hold the header", static_cast<int>(iov[0].iov_len));
+
+        size_t nbyte = 0;
+        std::vector<int> blocklen(niov);
+        std::vector<MPI_Aint> displ(niov);
+        for (int i=0; i<niov; ++i) {
+            MADNESS_ASSERT(iov[i].iov_len <= std::size_t(std::numeric_limits<int>::max()));
+            blocklen[i] = iov[i].iov_len;
+            displ[i] = reinterpret_cast<MPI_Aint>(iov[i].iov_base);
+            nbyte += iov[i].iov_len;
+        }
+        MADNESS_ASSERT(nbyte <= std::numeric_limits<int>::max());
+
+        int tag = SafeMPI::RMI_TAG;
+        if (nbyte > max_msg_len_) tag = huge_msg_rendezvous(nbyte, dest);
+
+        if (RMI::debugging)
+          print_error(rank, ":RMI: sending niov=", niov, " nbyte=", nbyte,
+                      " dest=", dest, " func=", func,
+                      " ordered=", is_ordered(attr),
+                      " count=", int(send_counters[dest]), "\n");
+
+        // Absolute addresses relative to MPI_BOTTOM describe the message
+        MPI_Datatype type;
+        {
+            SAFE_MPI_GLOBAL_MUTEX;
+            MADNESS_MPI_TEST(MPI_Type_create_hindexed(niov, blocklen.data(), displ.data(), MPI_BYTE, &type));
+            MADNESS_MPI_TEST(MPI_Type_commit(&type));
+        }
+
+        lock();
+
+        if (is_ordered(attr)) {
+            attr |= ((send_counters[dest]++)<<16);
+        }
+
+        header* h = (header*)(iov[0].iov_base);
+        h->func = archive::to_rel_fn_ptr(func);
+        h->attr = attr;
+
+        ++(RMI::stats.nmsg_sent);
+        RMI::stats.nbyte_sent += nbyte;
+
+        Request result = comm.Isend(MPI_BOTTOM, 1, type, dest, tag);
+
+        unlock();
+
+        // Freeing only marks the type for deallocation once the send completes
+        {
+            SAFE_MPI_GLOBAL_MUTEX;
+            MADNESS_MPI_TEST(MPI_Type_free(&type));
+        }
+        return result;
+#endif // STUBOUTMPI
+    }
+
     int RMI::RmiTask::unique_tag() const {
         constexpr int first_tag = 4096;
         static int tag = first_tag;
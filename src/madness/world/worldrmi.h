@@ -42,6 +42,7 @@
 #include <memory>
 #include <tuple>
 #include <pthread.h>
+#include <sys/uio.h>
 #include <madness/world/print.h>
 
 /*
@@ -272,12 +273,18 @@ namespace madness {
 
             Request isend(const void* buf, size_t nbyte, ProcessID dest, rmi_handlerT func, attrT attr);
 
+            Request isendv(const struct iovec* iov, int niov, ProcessID dest, rmi_handlerT func, attrT attr);
+
             void post_pending_huge_msg();
 
             void post_recv_buf(int i);
 
         private:
 
+            /// announces a message larger than the recv buffers and waits until \c dest has posted a buffer for it
+            /// @returns the tag to send the message with
+            int huge_msg_rendezvous(size_t nbyte, ProcessID dest);
+
             /// thread-safely round-robins through tags in [first_tag, first_tag+period) range
             /// @returns new tag to be used in messaging
             int unique_tag() const;
@@ -347,6 +354,24 @@ namespace madness {
             return task_ptr->isend(buf, nbyte, dest, func, attr);
         }
 
+        /// Send a remote method invocation gathered from several buffers
+
+        /// The receiver gets the concatenation of the buffers as one contiguous message,
+        /// which is sent without copying using an MPI derived datatype.
+        /// @param[in] iov The buffers, the first holding the header (do not modify until send is completed)
+        /// @param[in] niov The number of buffers
+        /// @param[in] dest Process to receive the message
+        /// @param[in] func The function to handle the message on the remote end
+        /// @param[in] attr Attributes of the message (ATTR_UNORDERED or ATTR_ORDERED)
+        /// @return The status as an RMI::Request that presently is a SafeMPI::Request
+        static Request
+        isendv(const struct iovec* iov, int niov, ProcessID dest, rmi_handlerT func, unsigned int attr=ATTR_UNORDERED) {
+            if(!task_ptr) {
+              MADNESS_EXCEPTION("!! MADNESS error: The RMI thread is not running", (task_ptr != nullptr));
+            }
+            return task_ptr->isendv(iov, niov, dest, func, attr);
+        }
+
         /// will complain to std::cerr and throw if ASLR is on by making
         /// sure that address of this function matches across @p comm
         /// @param[in] comm the communicator